@@ -9,21 +9,19 @@
 */
 
 #include "4_stroke_engine.h"
-#include <memory>               // used for shared_ptr<T>
-using std::vector;
-using std::shared_ptr;
 
 //=================================== cylinder =========================================//  
 
-float Cylinder::process (float driveIn, juceDelay& delayA, juceDelay& delayB, float speed)
+template <typename SampleType>
+SampleType Cylinder<SampleType>::process (SampleType driveIn, jr::DelayLine<SampleType>& delayA, jr::DelayLine<SampleType>& delayB, SampleType speed)
 {
     // calculate pulsewidth
     pulseWidth = 2.0f + 3.0f * (1.0f - speed);
 
-    float delayAOut = delayA.popSample(0, delayTimeInSeconds, false);
-    float delayBOut = delayB.popSample(0, delayTimeInSeconds, false);
+    SampleType delayAOut = delayA.popSample (delayTimeInSeconds, false);
+    SampleType delayBOut = delayB.popSample (delayTimeInSeconds, false);
 
-    float sampleOut = cos (juce::MathConstants<float>().twoPi * (driveIn + delayAOut - phaseShift));
+    SampleType sampleOut = cos (juce::MathConstants<SampleType>().twoPi * (driveIn + delayAOut - phaseShift));
     
     sampleOut *= (pulseWidth + delayBOut);
     
@@ -35,67 +33,92 @@ float Cylinder::process (float driveIn, juceDelay& delayA, juceDelay& delayB, fl
 
 //================================= Four Stroke Engine =====================================//
 
-void FourStrokeEngine::init (float sr)
+template <typename SampleType>
+size_t FourStrokeEngine<SampleType>::getRequiredMemory (SampleType sr)
 {
-    if (sampleRate == sr)
-        return;
+    return 2 * jr::DelayLine<SampleType>::getRequiredMemory (0.03 * sr);
+}
 
+template <typename SampleType>
+void FourStrokeEngine<SampleType>::init (SampleType sr, jr::MemoryArena& arena)
+{
     sampleRate = sr;
 
-    delaySpecs.maximumBlockSize = 512;
-    delaySpecs.numChannels = 1;
-    delaySpecs.sampleRate = sampleRate;
-
-    delayA.prepare (delaySpecs);
-    delayB.prepare (delaySpecs);
-
-    delayA.setMaximumDelayInSamples (0.03 * sampleRate);
-    delayB.setMaximumDelayInSamples (0.03 * sampleRate);
+    delayA.prepare (0.03 * sampleRate, arena);
+    delayB.prepare (0.03 * sampleRate, arena);
 
-    lpf1.setCoefficients (juce::IIRCoefficients::makeLowPass(sampleRate, 20.0, 0.01));
-    lpf2.setCoefficients (juce::IIRCoefficients::makeLowPass(sampleRate, 20.0, 0.01));
-    hpf.setCoefficients (juce::IIRCoefficients::makeHighPass(sampleRate, 2.0, 0.01));
+    noiseFilter.setCoefficients (jr::IIRCoefficients<SampleType>::makeLowPass(sampleRate, 20.0, 0.01));
+    hpf.setCoefficients (jr::IIRCoefficients<SampleType>::makeHighPass(sampleRate, 2.0, 0.01));
 
-    // if cylinders already exist
-    if (cylinders.size() > 0)
-        return;
-    else
+    for (int i = 1; i < (numCylinders + 1); i++)
     {
-        for (size_t i = 1; i < (numCylinders + 1); i++)
-        {
-            cylinders.push_back (std::make_shared<Cylinder> (sampleRate, (0.005 * i), (1.0f - (0.25 * i))));
-        }
-        initialised = true;
+        cylinders[i - 1].setTiming ((0.005 * i), (1.0f - (0.25 * i)));
     }
+    initialised = true;
+}
+
+template <typename SampleType>
+jr::MemoryFootprint FourStrokeEngine<SampleType>::getMemoryFootprint() const
+{
+    // cylinders are held inline, so they are part of the engine's own size
+    return { sizeof (*this), delayA.getMemoryFootprint().bufferBytes + delayB.getMemoryFootprint().bufferBytes };
+}
+
+template <typename SampleType>
+void FourStrokeEngine<SampleType>::saveState (jr::SnapshotWriter& writer) const
+{
+    // cylinders recalculate all of their state from their inputs each sample
+    delayA.saveState (writer);
+    delayB.saveState (writer);
+    noiseFilter.saveState (writer);
+    hpf.saveState (writer);
+    writer.write (random, cylinderMix);
+}
+
+template <typename SampleType>
+void FourStrokeEngine<SampleType>::loadState (jr::SnapshotReader& reader)
+{
+    delayA.loadState (reader);
+    delayB.loadState (reader);
+    noiseFilter.loadState (reader);
+    hpf.loadState (reader);
+    reader.read (random, cylinderMix);
 }
 
-float FourStrokeEngine::process (float speedIn, float driveIn)
+template <typename SampleType>
+SampleType FourStrokeEngine<SampleType>::process (SampleType speedIn, SampleType driveIn)
 {
     if (initialised == false)
         return 0.0f;
 
     // generate filtered noise
-    float rawNoise = 2.0f * (random.nextFloat() - 0.5f);
-    float filteredNoise = lpf1.processSingleSampleRaw (rawNoise);
-    filteredNoise = lpf2.processSingleSampleRaw (filteredNoise);
+    SampleType rawNoise = 2.0f * (random.nextFloat() - 0.5f);
+    SampleType filteredNoise = noiseFilter.processSingleSampleRaw (rawNoise);
 
-    delayA.pushSample (0, filteredNoise * 0.5f);
-    delayB.pushSample (0, filteredNoise * 10.0f);
+    delayA.pushSample (filteredNoise * 0.5f);
+    delayB.pushSample (filteredNoise * 10.0f);
 
     // process cylinders, tally output
-    float sampleOut{};
-    for (size_t i = 0; i < numCylinders; i++)
+    SampleType sampleOut{};
+    for (auto& cylinder : cylinders)
     {
-        sampleOut += cylinders.at (i)->process (driveIn, delayA, delayB, speedIn);
+        sampleOut += cylinder.process (driveIn, delayA, delayB, speedIn);
     }
 
     // updates the readPos of the delay lines
-    delayA.popSample (0, -1, true);
-    delayB.popSample (0, -1, true);
+    delayA.popSample (-1, true);
+    delayB.popSample (-1, true);
 
     // scale output and return
     sampleOut *= (cylinderMix * 2.0f);
 
     return hpf.processSingleSampleRaw (sampleOut);
     
-}
\ No newline at end of file
+}
+
+//======================= Explicit Instantiations =========================//
+
+template class Cylinder<float>;
+template class Cylinder<double>;
+template class FourStrokeEngine<float>;
+template class FourStrokeEngine<double>;
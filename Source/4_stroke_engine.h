@@ -9,23 +9,25 @@
 */
 
 #pragma once
-#include <vector>               // used for std::vector<T>
+#include <array>                // used for std::array<T, N>
 #include <JuceHeader.h>
-using std::vector;
-using std::shared_ptr;
-using juceDelay = juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear>;
+#include "jr_Delay.h"               // used for jr::DelayLine
+#include "jr_MemoryArena.h"         // used for jr::MemoryArena
+#include "jr_Snapshot.h"           // used for jr::SnapshotWriter / SnapshotReader
+#include "jr_IIRFilter.h"           // used for jr::IIRFilter / IIRCascade
 
 /** A model of a single cylinder within a 4 stroke Engine of a car
 */
+template <typename SampleType>
 class Cylinder
 {
 public:
 
-    /** Constructor
-    * @param sr - sample rate, Hz
+    /** Sets the timing of the cylinder, used to stagger it from the other cylinders
+    * @param delayInSeconds - delay time of the noise read from the delay lines
     * @param pShift - phase shift (0-1)
     */
-    Cylinder (float sr, float delayInSeconds, float pShift) : delayTimeInSeconds (delayInSeconds), phaseShift (pShift) {}
+    void setTiming (SampleType delayInSeconds, SampleType pShift) { delayTimeInSeconds = delayInSeconds; phaseShift = pShift; }
 
     /** Returns the next sample value for the cylinder
     * @param driveIn - current sample value for driving phasor
@@ -33,31 +35,42 @@ public:
     * @param delayB - reference to delay line B
     * @param speed - engine speed control value (0-1)
     */
-    float process (float driveIn, juceDelay& delayA, juceDelay& delayB, float speed);
+    SampleType process (SampleType driveIn, jr::DelayLine<SampleType>& delayA, jr::DelayLine<SampleType>& delayB, SampleType speed);
 
 private:
-    float delaySizeInSeconds{ 0.03 };               // size of delay buffers in seconds
-    float pulseWidth{};                             // pulse width, calculated as a function of the speed value in
-    float delayTimeInSeconds;                       // delay time in seconds, to be initiated at construction
-    float phaseShift;                               // phase shift amount to stagger cylinder from other instances
-    bool initialised{ false };                      // returns true once delay buffer size has been initialised to prevent delay buffer size from being set multiple times
+    SampleType delaySizeInSeconds{ 0.03 };          // size of delay buffers in seconds
+    SampleType pulseWidth{};                        // pulse width, calculated as a function of the speed value in
+    SampleType delayTimeInSeconds{};                // delay time in seconds, set by setTiming()
+    SampleType phaseShift{};                        // phase shift amount to stagger cylinder from other instances
 };
 
 /** A model of a 4 Stroke Car Engine with 4 cylinders. Call init() before use, then call process() each sample for output.
 */
+template <typename SampleType>
 class FourStrokeEngine
 {
 public:
 
+    /** Returns the number of bytes of arena memory the engine's delay lines need
+    * @param sr - sample rate, Hz
+    */
+    static size_t getRequiredMemory (SampleType sr);
+
     /** Initialises the FourStrokeEngine
     * @param sr - sample rate, Hz
+    * @param arena - arena with room for getRequiredMemory() bytes
     */
-    void init (float sr);
+    void init (SampleType sr, jr::MemoryArena& arena);
+
+    /** Seeds the noise generator, so that renders can be repeated exactly
+    * @param seed - seed value
+    */
+    void setRandomSeed (juce::int64 seed) { random.setSeed (seed); }
     
     /** Sets the cylinder mix
     * @param mix - cylinder mix (0-1)
     */
-    void setCylinderMix (float mix) 
+    void setCylinderMix (SampleType mix) 
     { 
         if (mix >= 1) cylinderMix = 1;
         if (mix <= 0) cylinderMix = 0;
@@ -68,19 +81,32 @@ public:
     * @param speedIn - engine speed control in (0-1)
     * @param driveIn - current sample value of driving phasor
     */
-    float process (float speedIn, float driveIn);
+    SampleType process (SampleType speedIn, SampleType driveIn);
+
+    /** Writes the complete DSP state of the engine to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const;
+
+    /** Reads the complete DSP state of the engine from a snapshot taken from an engine prepared the same way
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader);
+
+    /** Returns the memory used by the engine, including its delay lines in the arena
+    */
+    jr::MemoryFootprint getMemoryFootprint() const;
 
 private:
-    float sampleRate{};                           // sample rate, Hz
-    vector<shared_ptr<Cylinder>> cylinders;       // vector of pointers to the 4 cylinders
-    juce::Random random;                          // random number generator for noise
-    juceDelay delayA;                             // delay buffer A, containing low frequency noise with very small amplitude
-    juceDelay delayB;                             // delay buffer B, containing low frequency noise with large amplitude
-    juce::dsp::ProcessSpec delaySpecs;            // specs for initialising delay
-    juce::IIRFilter lpf1;                         // low pass filter 1
-    juce::IIRFilter lpf2;                         // low pass filter 2
-    juce::IIRFilter hpf;                          // high pass filter
-    float cylinderMix{};                          // output level of cylinders (0-1)
-    bool initialised{ false };                    // bool returns true when the component has been initialised
-    size_t numCylinders{ 4 };                     // number of cylinders
+    static constexpr int numCylinders{ 4 };             // number of cylinders
+
+    SampleType sampleRate{};                            // sample rate, Hz
+    std::array<Cylinder<SampleType>, numCylinders> cylinders;  // the 4 cylinders, held inline so the engine allocates nothing
+    juce::Random random;                                // random number generator for noise
+    jr::DelayLine<SampleType> delayA;                   // delay buffer A, containing low frequency noise with very small amplitude
+    jr::DelayLine<SampleType> delayB;                   // delay buffer B, containing low frequency noise with large amplitude
+    jr::IIRCascade<SampleType, 2> noiseFilter;          // two low pass stages in series, shaping the noise in the delay buffers
+    jr::IIRFilter<SampleType> hpf;                      // high pass filter
+    SampleType cylinderMix{};                           // output level of cylinders (0-1)
+    bool initialised{ false };                          // bool returns true when the component has been initialised
 };
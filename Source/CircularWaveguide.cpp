@@ -11,56 +11,55 @@
 #include "CircularWaveguide.h"
 #include <JuceHeader.h>
 
-//=========================== constructors =================================//
+//=========================== Constructors ==============================//
 
-CircularWaveguide::CircularWaveguide()
+template <typename SampleType>
+CircularWaveguide<SampleType>::CircularWaveguide()
 {
-    setSampleRate (44100); 
+    // width 2 -> length 1 -> width 1 -> length 2, with 'b' and 'd' heard in the output and 'c' only fed into width 1
+    network.setLayout (4, 3, 1);
+    network.setInjectionPoint (0, 1, true);
+    network.setInjectionPoint (1, 2, false);
+    network.setInjectionPoint (2, 3, true);
+    network.setFeedbackTap (0, 3, 0);
 }
 
 //========================= mutator functions ==============================//
 
-void CircularWaveguide::setSampleRate (float sr)
+template <typename SampleType>
+size_t CircularWaveguide<SampleType>::getRequiredMemory (SampleType sr) const
 {
-    if (sampleRate == sr)
-        return;
+    SampleType sizeInSamples = 0.12f * sr;
+    return network.getRequiredMemory ((int) sizeInSamples) + jr::DelayLine<SampleType>::getRequiredMemory (sizeInSamples * 3.0f, driveStorage);
+}
 
+template <typename SampleType>
+void CircularWaveguide<SampleType>::prepare (SampleType sr, jr::MemoryArena& arena)
+{
     sampleRate = sr;
-    
 
     //========== initialise delay lines ===========//
 
-    delaySpecs.maximumBlockSize = 512;
-    delaySpecs.sampleRate = sampleRate;
-    delaySpecs.numChannels = 1;
-
-    delay1.prepare (delaySpecs);
-    delay2.prepare (delaySpecs);
-    delay3.prepare (delaySpecs);
-    delay4.prepare (delaySpecs);
-    delayedDrive.prepare (delaySpecs);
-
-    float sizeInSamples = 0.12f * sampleRate;
-    delay1.setMaximumDelayInSamples (sizeInSamples);
-    delay2.setMaximumDelayInSamples (sizeInSamples);
-    delay3.setMaximumDelayInSamples (sizeInSamples);
-    delay4.setMaximumDelayInSamples (sizeInSamples);
-    delayedDrive.setMaximumDelayInSamples (sizeInSamples * 3.0f);
+    SampleType sizeInSamples = 0.12f * sampleRate;
+    network.prepare (sampleRate, (int) sizeInSamples, arena);
+    delayedDrive.prepare (sizeInSamples * 3.0f, arena, driveStorage, 1.0f);     // driving phasor is in the range 0-1
 
     //=========== initialise filters ===========//
 
-    hpf1.setCoefficients (juce::IIRCoefficients::makeHighPass(sampleRate, 30.0, 0.01));   
+    hpf1.setCoefficients (jr::IIRCoefficients<SampleType>::makeHighPass(sampleRate, 30.0, 0.01));   
 }
 
-void CircularWaveguide::setDimensions (float w1, float w2, float l1, float l2)
+template <typename SampleType>
+void CircularWaveguide<SampleType>::setDimensions (SampleType w1, SampleType w2, SampleType l1, SampleType l2)
 {
-    width1 = w1;
-    width2 = w2;
-    length1 = l1;
-    length2 = l2;
+    network.setSegmentLength (0, w2);
+    network.setSegmentLength (1, l1);
+    network.setSegmentLength (2, w1);
+    network.setSegmentLength (3, l2);
 }
 
-void CircularWaveguide::setParams (float parabDelay, float parabMix, float wDelay, float warpAmt)
+template <typename SampleType>
+void CircularWaveguide<SampleType>::setParams (SampleType parabDelay, SampleType parabMix, SampleType wDelay, SampleType warpAmt)
 {
     parabolicDelay = parabDelay;
     parabolicMix = parabMix;
@@ -68,21 +67,22 @@ void CircularWaveguide::setParams (float parabDelay, float parabMix, float wDela
     waveguideWarp = warpAmt;
 }
 
-void CircularWaveguide::updateParams (float speedIn, float driveIn)
+template <typename SampleType>
+void CircularWaveguide<SampleType>::updateParams (SampleType speedIn, SampleType driveIn)
 {
-    delayedDrive.pushSample (0, driveIn);
+    delayedDrive.pushSample (driveIn);
 
     // update 'a'
-    a = delayedDrive.popSample (0, ((parabolicDelay / 1000.0f) * sampleRate));
+    a = delayedDrive.popSample (((parabolicDelay / 1000.0f) * sampleRate));
     // parabola transform
     a -= 0.5f;
     a = 0.5f * ((-4.0f * pow (a, 2)) + 1.0f);
     a *= (parabolicMix * 2.0f);
     
     // update 'fm1'
-    float cosineCurve = cos (juce::MathConstants<float>().twoPi * delayedDrive.popSample (0, (warpDelay / 1000.0f)*sampleRate));
+    SampleType cosineCurve = cos (juce::MathConstants<SampleType>().twoPi * delayedDrive.popSample ((warpDelay / 1000.0f)*sampleRate));
     
-    float warpAmount = speedIn * waveguideWarp;
+    SampleType warpAmount = speedIn * waveguideWarp;
 
     fm1 = 0.5f + ((1.0f - cosineCurve) * warpAmount);
 
@@ -91,35 +91,67 @@ void CircularWaveguide::updateParams (float speedIn, float driveIn)
 
 //======================== accessor functions =============================//
 
-float CircularWaveguide::process (float speedIn, float driveIn, float b, float c, float d)
+template <typename SampleType>
+void CircularWaveguide<SampleType>::saveState (jr::SnapshotWriter& writer) const
 {
-    updateParams (speedIn, driveIn);
-
-    float output{};
-    
-    delay1.pushSample (0, (hpf1.processSingleSampleRaw(a) + (feedbackAmt * fbSignal2)));
-
-    float delayOut = delay1.popSample (0, (sampleRate * ((width2 * fm2) / 1000.0f)));
-
-    float outputSubMix = delayOut + b;
+    network.saveState (writer);
+    delayedDrive.saveState (writer);
+    hpf1.saveState (writer);
+    writer.write (parabolicDelay, parabolicMix, warpDelay, waveguideWarp, a, fm1, fm2);
+}
 
-    output += outputSubMix;
+template <typename SampleType>
+void CircularWaveguide<SampleType>::loadState (jr::SnapshotReader& reader)
+{
+    network.loadState (reader);
+    delayedDrive.loadState (reader);
+    hpf1.loadState (reader);
+    reader.read (parabolicDelay, parabolicMix, warpDelay, waveguideWarp, a, fm1, fm2);
+}
 
-    delay2.pushSample (0, outputSubMix);
+template <typename SampleType>
+jr::MemoryFootprint CircularWaveguide<SampleType>::getMemoryFootprint() const
+{
+    size_t bufferBytes = network.getMemoryFootprint().bufferBytes + delayedDrive.getMemoryFootprint().bufferBytes;
 
-    fbSignal1 = delay2.popSample (0, (sampleRate * ((length1 * fm1) / 1000.0f)));
-    output += fbSignal1;
+    return { sizeof (*this), bufferBytes };
+}
 
-    delay3.pushSample (0, fbSignal1 + c);
+template <typename SampleType>
+SampleType CircularWaveguide<SampleType>::process (SampleType speedIn, SampleType driveIn, SampleType b, SampleType c, SampleType d)
+{
+    updateParams (speedIn, driveIn);
 
-    outputSubMix = delay3.popSample (0, (sampleRate * ((width1 * fm1) / 1000.0f))) + d;
-    output += outputSubMix;
+    SampleType injections[3]{ b, c, d };
+    SampleType modulations[4]{ fm2, fm1, fm1, fm2 };
 
-    delay4.pushSample (0, outputSubMix);
+    return network.process (hpf1.processSingleSampleRaw (a), injections, modulations);
+}
 
-    fbSignal2 = delay4.popSample (0, (sampleRate * ((length2 * fm2) / 1000.0f)));
+template <typename SampleType>
+void CircularWaveguide<SampleType>::processBlock (SampleType* output, const SampleType* speeds, const SampleType* drives, const SampleType* b, const SampleType* c, const SampleType* d, int numSamples)
+{
+    for (int blockStart = 0; blockStart < numSamples; blockStart += blockSize)
+    {
+        int numInBlock = juce::jmin (blockSize, numSamples - blockStart);
+
+        // 'a', 'fm1' and 'fm2' come from the driving phasor alone, so they are worked out for the whole block before the loop is run
+        for (int i = 0; i < numInBlock; i++)
+        {
+            updateParams (speeds[blockStart + i], drives[blockStart + i]);
+            excitationBlock[i] = hpf1.processSingleSampleRaw (a);
+            fm1Block[i] = fm1;
+            fm2Block[i] = fm2;
+        }
+
+        const SampleType* injections[3]{ b + blockStart, c + blockStart, d + blockStart };
+        const SampleType* modulations[4]{ fm2Block, fm1Block, fm1Block, fm2Block };
+
+        network.processBlock (output + blockStart, excitationBlock, injections, modulations, numInBlock);
+    }
+}
 
-    output += fbSignal2;
+//======================= Explicit Instantiations =========================//
 
-    return output;
-}
\ No newline at end of file
+template class CircularWaveguide<float>;
+template class CircularWaveguide<double>;
@@ -10,23 +10,39 @@
 
 #pragma once
 #include <JuceHeader.h>
-using juceDelay = juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear>;
+#include "jr_Delay.h"               // used for jr::DelayLine
+#include "jr_MemoryArena.h"         // used for jr::MemoryArena
+#include "jr_Snapshot.h"            // used for jr::SnapshotWriter / SnapshotReader
+#include "jr_IIRFilter.h"           // used for jr::IIRFilter
+#include "jr_WaveguideNetwork.h"    // used for jr::WaveguideNetwork
 
 /** Circular Non-Linear Warping Waveguide used to model the effect of the exhaust system in a car. 
-Use setSampleRate() before use, then setParams() or setMappedParams() to set parameters, and call process() each sample for output.
+The four delays of the loop are the segments of a jr::WaveguideNetwork: width 2, length 1, width 1 and length 2 in order, with 'b', 'c' and 'd'
+injected at the junctions after the first three and the last fed back into the first.
+Use prepare() before use, then setParams() or setMappedParams() to set parameters, and call process() each sample or processBlock() for output.
 */
+template <typename SampleType>
 class CircularWaveguide
 {
 public:
 
-    /** Constructor
-    */
     CircularWaveguide();
 
-    /** Sets the sample rate
+    /** Sets whether the driving phasor delay line is stored as 16-bit fixed point (half the memory) instead of floats - call before getRequiredMemory() and prepare()
+    * @param isCompact - true for compact storage
+    */
+    void setCompactStorage (bool isCompact) { driveStorage = isCompact ? jr::DelayStorage::FIXED16 : jr::DelayStorage::FULL_PRECISION; }
+
+    /** Returns the number of bytes of arena memory the waveguide's delay lines need
+    * @param sr - sample rate, Hz
+    */
+    size_t getRequiredMemory (SampleType sr) const;
+
+    /** Sets the sample rate and takes the delay lines from the arena
     * @param sr - sample rate, Hz
+    * @param arena - arena with room for getRequiredMemory() bytes
     */
-    void setSampleRate (float sr);
+    void prepare (SampleType sr, jr::MemoryArena& arena);
 
     /** Sets the dimensions of the waveguide
     * @param w1 - width 1 (0-1)
@@ -34,12 +50,12 @@ public:
     * @param l1 - length 1 (0-1)
     * @param l2 - length 2 (0-1)
     */
-    void setDimensions (float w1, float w2, float l1, float l2);
+    void setDimensions (SampleType w1, SampleType w2, SampleType l1, SampleType l2);
 
     /** sets the amount of feedback
     * @param fb - feedback amount (0-1)
     */
-    void setFeedbackAmt (float fb) { feedbackAmt = fb; }
+    void setFeedbackAmt (SampleType fb) { network.setFeedbackGain (0, fb); }
 
     /** Sets the params of the waveguide
     * @param parabDelay - delay in ms for driver to signal 'a' (0-100)
@@ -47,7 +63,7 @@ public:
     * @param wDelay - delay in ms for 'fm1' and 'fm2' (0-100)
     * @param warpAmt - amount of driving signal sent to 'fm1' and 'fm2' (0-1)
     */
-    void setParams (float parabDelay, float parabMix, float wDelay, float warpAmt);
+    void setParams (SampleType parabDelay, SampleType parabMix, SampleType wDelay, SampleType warpAmt);
 
     /** Returns the next sample value for the waveguide
     * @param speedIn - engine speed (0-1)
@@ -56,7 +72,33 @@ public:
     * @param c - current sample value of the input signal 'c' (from overtone generator)
     * @param d - current sample value of the input signal 'd' (from overtone generator)
     */
-    float process (float speedIn, float driveIn, float b, float c, float d);
+    SampleType process (SampleType speedIn, SampleType driveIn, SampleType b, SampleType c, SampleType d);
+
+    /** Processes a block of samples, giving the same output as calling process() for each. The delays of the loop are read and written
+    as blocks, in runs no longer than the shortest delay
+    * @param output - array to write the waveguide output to
+    * @param speeds - engine speed for each sample (0-1)
+    * @param drives - driving phasor for each sample
+    * @param b - input signal 'b' for each sample (from overtone generator)
+    * @param c - input signal 'c' for each sample (from overtone generator)
+    * @param d - input signal 'd' for each sample (from overtone generator)
+    * @param numSamples - number of samples
+    */
+    void processBlock (SampleType* output, const SampleType* speeds, const SampleType* drives, const SampleType* b, const SampleType* c, const SampleType* d, int numSamples);
+
+    /** Writes the complete DSP state of the waveguide to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const;
+
+    /** Reads the complete DSP state of the waveguide from a snapshot taken from a waveguide prepared the same way
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader);
+
+    /** Returns the memory used by the waveguide, including its delay lines in the arena
+    */
+    jr::MemoryFootprint getMemoryFootprint() const;
 
 private:
 
@@ -64,37 +106,29 @@ private:
     * @param speedIn - engine speed (0-1)
     * @param driveIn - current sample value for driving phasor
     */
-    void updateParams (float speedIn, float driveIn);
+    void updateParams (SampleType speedIn, SampleType driveIn);
 
 private:
-    float sampleRate{};         // sample rate, Hz
-
-    float feedbackAmt{};        // feedback amount (0-1)
-    float fbSignal1{};          // current sample value for signal to be feedback through the delays
-    float fbSignal2{};          // current sample value for signal to be feedback through the delays
-
-    juce::IIRFilter hpf1;       // high pass filter to filter signal 'a'
-
-    float width1{};             // width 1 (0-40)
-    float width2{};             // width 2 (0-40)
-    float length1{};            // length 1 (0-40)
-    float length2{};            // length 2 (0-40)
+    SampleType sampleRate{};    // sample rate, Hz
 
-    juceDelay delay1;           // delay buffer using linear interpolation
-    juceDelay delay2;           // delay buffer using linear interpolation
-    juceDelay delay3;           // delay buffer using linear interpolation
-    juceDelay delay4;           // delay buffer using linear interpolation
-    juceDelay delayedDrive;     // delay buffer using linear interpolation for driving phasor
+    jr::IIRFilter<SampleType> hpf1;         // high pass filter to filter signal 'a'
 
-    juce::dsp::ProcessSpec delaySpecs;  // process specs used to initialise delay lines
+    jr::WaveguideNetwork<SampleType> network;   // the four delays of the loop, as segments width 2, length 1, width 1, length 2
+    jr::DelayLine<SampleType> delayedDrive; // delay buffer using linear interpolation for driving phasor
+    jr::DelayStorage driveStorage{ jr::DelayStorage::FULL_PRECISION };    // sample format of delayedDrive buffer
 
-    float parabolicDelay{};     // delay in ms for driver to signal 'a' (0 - 100)
-    float parabolicMix{};       // mix amount for signal 'a' (0-1)
-    float warpDelay{};          // delay in ms for 'fm1' and 'fm2' (0-100)
-    float waveguideWarp{};      // amount of driving signal sent to 'fm1' and 'fm2' (0-1)
+    SampleType parabolicDelay{};            // delay in ms for driver to signal 'a' (0 - 100)
+    SampleType parabolicMix{};              // mix amount for signal 'a' (0-1)
+    SampleType warpDelay{};                 // delay in ms for 'fm1' and 'fm2' (0-100)
+    SampleType waveguideWarp{};             // amount of driving signal sent to 'fm1' and 'fm2' (0-1)
 
     // parameters calculated within class
-    float a{};                  // current sample value for signal 'a'
-    float fm1{};                // current sample value for first signal controlling fm
-    float fm2{};                // current sample value for second signal controlling fm
+    SampleType a{};             // current sample value for signal 'a'
+    SampleType fm1{};           // current sample value for first signal controlling fm
+    SampleType fm2{};           // current sample value for second signal controlling fm
+
+    static constexpr int blockSize{ jr::WaveguideNetwork<SampleType>::maxBlockSize };     // most samples prepared for the network at once
+    SampleType excitationBlock[blockSize];  // filtered signal 'a' for the current block
+    SampleType fm1Block[blockSize];         // 'fm1' for the current block
+    SampleType fm2Block[blockSize];         // 'fm2' for the current block
 };
\ No newline at end of file
@@ -13,33 +13,43 @@
 #include "Rotor.h"                          // used for Rotor / Brush
 #include "Stator.h"                         // used for Stator
 #include "FM_Resonator.h"                   // used for FM resonance
-#include "jr_PolyBLEP_Oscillators.h"        // used for driving phasor (Oscillator set to SAW mode)
+#include "jr_MemoryArena.h"                 // used for jr::MemoryFootprint
+#include "jr_Snapshot.h"                    // used for jr::SnapshotWriter / SnapshotReader
+#include "jr_Ramp.h"                        // used for jr::Ramp
 
+/** Physical model of an electric DC motor, made up of a rotor, stator, resonant casing and a power on/off envelope.
+The motor runs as one loop over a block: a single driving phasor gives the rotor envelope and resonator modulation, and the stator's phase is derived from it
+* @tparam SampleType - float or double
+*/
+template <typename SampleType>
 class ElectricMotorDC
 {
 public:
 
-    ElectricMotorDC() 
-    { 
-        phasor.setMuted (false);
-        phasor.setMode (jr::Oscillator::OscillatorMode::SAW);
-    }
-
     //======================== mutators ===========================//
 
     /** Sets the sample rate
     * @param sr - sample rate, Hz
     */
-    void setSampleRate (float sr)
+    void setSampleRate (SampleType sr)
     {
-        phasor.setSampleRate (sr);
+        sampleRate = sr;
+        phaseDelta = phasorFreq / sampleRate;
         rotor.setSampleRate (sr);
-        stator.setSampleRate (sr);
         resonator.setSampleRate (sr);
         envelope.setSampleRate (sr);
         smoothedGain.reset (sr, 0.01);
     }
 
+    /** Seeds every noise generator in the motor, so that renders can be repeated exactly
+    * @param seed - seed value
+    */
+    void setRandomSeed (juce::int64 seed)
+    {
+        random.setSeed (seed);
+        rotor.setRandomSeed (seed + 1);
+    }
+
     /** Sets the parameters of the motor via a simlpified set of parameters that the others are mapped to
     * @param powerUpTime - power up time in seconds 
     * @param powerDownTime - power down time in seconds 
@@ -51,14 +61,14 @@ public:
     * @param sparksIn - sparks level (0-1)
     * @param humIn - true if rotor DC signal is sent to resonator pre-envelope
     */
-    void setMappedParams (float powerUpTimeIn,float powerDownTimeIn, float accelRate, float gainIn, float maxSpeedIn, float casingSizeIn, float rotorIn, float sparksIn, bool humIn)
+    void setMappedParams (SampleType powerUpTimeIn,SampleType powerDownTimeIn, SampleType accelRate, SampleType gainIn, SampleType maxSpeedIn, SampleType casingSizeIn, SampleType rotorIn, SampleType sparksIn, bool humIn)
     {
-        float statorVal = 0.4 + (0.6 * casingSizeIn);
+        SampleType statorVal = 0.4 + (0.6 * casingSizeIn);
 
         setParams (gainIn, powerUpTimeIn, powerDownTimeIn, accelRate, statorVal, sparksIn, rotorIn, casingSizeIn, maxSpeedIn, 1.0f, 2800.0f, humIn);
     }
 
-    void setParams (float gainIn, float powerUpTime, float powerDownTime, float accRate, float statorLevel, float brushLevel, float rotorLevel, float resAmount, float maxSpeedIn, float jitterAmount, float brushFreq=4000, int resModeIn=0)
+    void setParams (SampleType gainIn, SampleType powerUpTime, SampleType powerDownTime, SampleType accRate, SampleType statorLevel, SampleType brushLevel, SampleType rotorLevel, SampleType resAmount, SampleType maxSpeedIn, SampleType jitterAmount, SampleType brushFreq=4000, int resModeIn=0)
     {
         smoothedGain.setTargetValue (gainIn);
         envelope.setPowerUpTime (powerUpTime);
@@ -77,18 +87,28 @@ public:
     /** Set the amount of jitter applied to the driving phasor's frequency (0-1)
     * @param jitterAmount - volume of jitter noise (0-1)
     */
-    void setPhasorJitter (float jitterAmount) { phasorJitterAmount = jitterAmount; }
+    void setPhasorJitter (SampleType jitterAmount) { phasorJitterAmount = jitterAmount; }
 
     /** Sets the maximum speed of the motor, reflected in the maximum frequency the motor will reach
     * @param speed - maximum frequency of the motor, Hz
     */
-    void setMaxSpeed (float speed) { maxSpeed = speed; }
+    void setMaxSpeed (SampleType speed) { maxSpeed = speed; }
 
     /** Sets the resonation mode via index
     * @param mode - index dictating mode, 0 for resonating after the rotor envelope applied, 1 for resonating the unenveloped rotor signal
     */
     void setResMode (int mode) { if (mode == 0 || mode == 1)  resMode = mode; }
 
+    /** Sets whether the resonator is excited by an external signal (see setExcitation()) in place of the rotor
+    * @param isExternal - true to excite the resonator with the external signal
+    */
+    void setExternalExcitation (bool isExternal) { useExternalExcitation = isExternal; }
+
+    /** Sets the current sample of the external excitation signal - call each sample before process()
+    * @param sample - excitation sample value
+    */
+    void setExcitation (SampleType sample) { excitation = sample; }
+
     //=============================================================================//
 
     /** Turns motor ON
@@ -101,52 +121,158 @@ public:
     */
     void powerOff() { envelope.powerOff(); }
 
+    /** Puts the motor straight into its fully on or fully off state, skipping the power up/down envelope
+    * @param isPoweredOn - true for fully on, false for fully off
+    */
+    void setSteadyState (bool isPoweredOn) { envelope.setSteadyState (isPoweredOn); }
+
     /** Returns the next sample value for the motor
     * @return sampleOut - next sample value
     */
-    float process()
+    SampleType process()
+    {
+        SampleType sampleOut{}, speed{}, envelopeVal{};
+        processBlock (&sampleOut, &speed, &envelopeVal, nullptr, nullptr, 1);
+
+        return sampleOut;
+    }
+
+    /** Processes a block of the motor in one loop, with no oscillators to re-set each sample
+    * @param output - block to write the motor's output to
+    * @param speeds - block to write the motor's speed (the frequency of the driving phasor) to, Hz
+    * @param envelopes - block to write the power on/off envelope to
+    * @param maxSpeeds - maximum speed for each sample, Hz, or nullptr to use the one from setMaxSpeed()
+    * @param excitations - external excitation for each sample, or nullptr to use the one from setExcitation() (only read when setExternalExcitation() is on)
+    * @param numSamples - number of samples
+    */
+    void processBlock (SampleType* output, SampleType* speeds, SampleType* envelopes, const SampleType* maxSpeeds, const SampleType* excitations, int numSamples)
     {
-        float envelopeVal = envelope.process();
-        float jitter = (2.0f * (random.nextFloat() - 1.0f)) * phasorJitterAmount;
-        currentFreq = (envelopeVal * maxSpeed) + jitter;
-        phasor.setFrequency (currentFreq);
-        float phasorOut = (phasor.processSingleSample() + 1.0f) / 2.0f;
-        float statorOut = stator.process (currentFreq);
-        float rotorOut = rotor.process (phasorOut);
-        float resonatorOut{};
-        switch (resMode)
+        for (int i = 0; i < numSamples; i++)
         {
-        default:
-            resonatorOut = resonator.process (rotor.getRotorLevel() * rotor.getCurrentEnvVal(), phasorOut);
-            break;
-        case 1:
-            resonatorOut = resonator.process (rotor.getRotorLevel(), phasorOut);
-            break;
+            SampleType envelopeVal = envelope.process();
+            SampleType jitter = (2.0f * (random.nextFloat() - 1.0f)) * phasorJitterAmount;
+            currentFreq = (envelopeVal * (maxSpeeds != nullptr ? maxSpeeds[i] : maxSpeed)) + jitter;
+
+            // a frequency at or below 0 (jitter while at rest) keeps the last increment, as the driving phasor always has
+            if (currentFreq > 0)
+            {
+                phasorFreq = currentFreq;
+                phaseDelta = phasorFreq / sampleRate;
+            }
+
+            // the driving phasor is a band limited (polyBLEP) sawtooth from 0 to 1, and the stator turns once every 4 of its cycles
+            SampleType phasorOut = phase - ((SampleType) 0.5 * polyBLEP (phase));
+            SampleType statorOut = stator.process ((cycleCount + phase) * (SampleType) 0.25);
+            SampleType rotorOut = rotor.process (phasorOut);
+            SampleType resonatorExcitation{};
+
+            if (useExternalExcitation)
+                resonatorExcitation = excitations != nullptr ? excitations[i] : excitation;
+            else if (resMode == 1)
+                resonatorExcitation = rotor.getRotorLevel();
+            else
+                resonatorExcitation = rotor.getRotorLevel() * rotor.getCurrentEnvVal();
+
+            SampleType resonatorOut = resonator.process (resonatorExcitation, phasorOut);
+
+            output[i] = (statorOut + rotorOut + resonatorOut) * envelopeVal;
+            speeds[i] = currentFreq;
+            envelopes[i] = envelopeVal;
+
+            phase += phaseDelta;
+
+            if (phase >= 1)
+            {
+                phase -= 1;
+                cycleCount = (cycleCount + 1) & 3;
+            }
         }
 
-        float sampleOut = (statorOut + rotorOut + resonatorOut) * envelopeVal;
+        smoothedGain.applyGain (output, numSamples);
+        gainVal = smoothedGain.getCurrentValue();
+    }
+
+    SampleType getEnvelope() const { return envelope.getCurrentValue(); }
+
+    SampleType getCurrentSpeed() const { return currentFreq; }
+
+    /** Writes the complete DSP state of the motor and its components to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        rotor.saveState (writer);
+        stator.saveState (writer);
+        resonator.saveState (writer);
+        envelope.saveState (writer);
+        writer.write (sampleRate, phase, phasorFreq, phaseDelta, cycleCount);
+        writer.write (gainVal, smoothedGain, random, phasorJitterAmount, resMode, maxSpeed, currentFreq, useExternalExcitation, excitation);
+    }
 
-        gainVal = smoothedGain.getNextValue();
-        return sampleOut * gainVal;
+    /** Reads the complete DSP state of the motor and its components from a snapshot taken from a motor at the same sample rate
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        rotor.loadState (reader);
+        stator.loadState (reader);
+        resonator.loadState (reader);
+        envelope.loadState (reader);
+        reader.read (sampleRate, phase, phasorFreq, phaseDelta, cycleCount);
+        reader.read (gainVal, smoothedGain, random, phasorJitterAmount, resMode, maxSpeed, currentFreq, useExternalExcitation, excitation);
     }
 
-    float getEnvelope() { return envelope.getCurrentValue(); }
+    /** Returns the memory used by the motor and all of its components (the motor has no buffers, so this is all object state)
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
 
-    float getCurrentSpeed() { return currentFreq; }
+    /** Returns the memory used by each component of the motor
+    */
+    jr::MemoryFootprint getRotorFootprint() const { return rotor.getMemoryFootprint(); }
+    jr::MemoryFootprint getStatorFootprint() const { return stator.getMemoryFootprint(); }
+    jr::MemoryFootprint getResonatorFootprint() const { return resonator.getMemoryFootprint(); }
+    jr::MemoryFootprint getEnvelopeFootprint() const { return envelope.getMemoryFootprint(); }
 
 private:
-    float gainVal{};                           // master gain for motor (0-1)
-    juce::SmoothedValue<float> smoothedGain;   // smoothed gain
-    Rotor rotor;
-    Stator stator;
-    MotorFMResonator resonator;
-    MotorEnvelope envelope;
-    jr::polyblepOscillator phasor;
+
+    /** Returns the polyBLEP correction of the driving phasor's sawtooth around its wrap, as jr::polyblepOscillator
+    * @param t - phase (0-1)
+    */
+    SampleType polyBLEP (SampleType t) const
+    {
+        if (t < phaseDelta)
+        {
+            t /= phaseDelta;
+            return (t + t - (t * t) - 1);
+        }
+        else if (t > (1 - phaseDelta))
+        {
+            t = (t - 1) / phaseDelta;
+            return ((t * t) + t + t + 1);
+        }
+
+        return 0;
+    }
+
+    SampleType gainVal{};                           // master gain for motor (0-1)
+    jr::Ramp<SampleType> smoothedGain;              // smoothed gain
+    Rotor<SampleType> rotor;
+    Stator<SampleType> stator;
+    MotorFMResonator<SampleType> resonator;
+    MotorEnvelope<SampleType> envelope;
+
+    SampleType sampleRate{ 44100 };         // sample rate, Hz
+    SampleType phase{};                     // phase of the driving phasor (0-1)
+    SampleType phasorFreq{ 440 };           // frequency of the driving phasor, Hz: the last one above 0, from jr::Oscillator's default of 440
+    SampleType phaseDelta{};                // phase increment of the driving phasor per sample
+    int cycleCount{};                       // cycles of the driving phasor completed, counted 0-3 (the stator turns once every 4)
 
     juce::Random random;                    // random number generator used to generate white noise
-    float phasorJitterAmount{};             // amount of jitter to add to the frequency of the driving phasor (0-1)
+    SampleType phasorJitterAmount{};        // amount of jitter to add to the frequency of the driving phasor (0-1)
     int resMode{};                          // 0 or 1 value indicating whether rotor signal is sent to resonator before or after its volume envelope
 
-    float maxSpeed{ 80.0f };                // max speed of the motor, controls the maximum frequency the motor will spin at
-    float currentFreq{};                    // stores the current frequency value of the driving phasor
+    SampleType maxSpeed{ 80.0f };           // max speed of the motor, controls the maximum frequency the motor will spin at
+    SampleType currentFreq{};               // stores the current frequency value of the driving phasor
+    bool useExternalExcitation{ false };    // true if the resonator is excited by the external signal in place of the rotor
+    SampleType excitation{};                // current sample of the external excitation signal
 };
\ No newline at end of file
@@ -9,56 +9,83 @@
 */
 
 #pragma once
-#include "jr_PolyBLEP_Oscillators.h"        // used for jr::Oscillator
+#include <cmath>                            // used for std::cos()
+#include "jr_QuadraturePhasor.h"            // used for jr::QuadraturePhasor
+#include "jr_IIRFilter.h"                   // used for jr::IIRCascade
+#include "jr_MemoryArena.h"                 // used for jr::MemoryFootprint
 
-/** A class to physically model the resonant casing of an electric DC motor, using FM to model the resonance similar to a tube
+/** A class to physically model the resonant casing of an electric DC motor, using FM to model the resonance similar to a tube.
+The fixed carrier is advanced by a rotating complex multiply rather than a sin() per sample
 */
+template <typename SampleType>
 class MotorFMResonator
 {
 public:
 
-    MotorFMResonator() { carrierOsc.setMuted (false); }
-
     /** Sets the sample rate
     * @param sr - sample rate, Hz
     */
-    void setSampleRate (float sr)
+    void setSampleRate (SampleType sr)
     {
-        carrierOsc.setSampleRate (sr);
-        carrierOsc.setFrequency (carrierFreq);
+        carrier.setSampleRate (sr);
+        carrier.setFrequency (carrierFreq);
 
-        hpf.setCoefficients (juce::IIRCoefficients::makeHighPass (sr, filterFreq));
+        hpf.setCoefficients (jr::IIRCoefficients<SampleType>::makeHighPass (sr, filterFreq));     // both stages
     }
 
     /** Sets the resonance amount
     * @param level - volume level for the resonator (0-1)
     */
-    void setResonanceAmount (float level) { resonanceAmount = level; }
+    void setResonanceAmount (SampleType level) { resonanceAmount = level; }
 
     /** Returns the next sample out value for the resonator
     * @param rotorVal - current sample value for the signal to be used as the excitor for the resonator (generally the current rotor sample out value before or after enveloping)
     * @param phasorVal - current sample value for the driving phasor
     */
-    float process (float rotorVal, float phasorVal)
+    SampleType process (SampleType rotorVal, SampleType phasorVal)
     {
-        float output{};
+        SampleType output{};
 
-        output = rotorVal * carrierOsc.processSingleSample();
+        output = rotorVal * carrier.getSine();
+        carrier.advance();
 
         output += phasorVal;
 
-        output = cos (output);
+        output = std::cos (output);
 
-        for (size_t i = 0; i < 2; i++)
-            output = hpf.processSingleSampleRaw (output);
+        output = hpf.processSingleSampleRaw (output);
 
         return output * resonanceAmount;
     }
 
+    /** Writes the carrier oscillator, filter state and resonance amount to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        carrier.saveState (writer);
+        hpf.saveState (writer);
+        writer.write (resonanceAmount);
+    }
+
+    /** Reads the carrier oscillator, filter state and resonance amount from a snapshot
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        carrier.loadState (reader);
+        hpf.loadState (reader);
+        reader.read (resonanceAmount);
+    }
+
+    /** Returns the memory used by the resonator
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
+
 private:
-    jr::Oscillator carrierOsc;          // carrier frequency for FM (kept fixed)
-    juce::IIRFilter hpf;                // high pass filter
-    float carrierFreq{ 178 };           // frequency of carrier, Hz
-    float filterFreq{ 180 };            // cutoff frequency for high pass filters, Hz
-    float resonanceAmount{};            // volume level of the resonance
+    jr::QuadraturePhasor<SampleType> carrier;   // carrier for FM (kept at a fixed frequency)
+    jr::IIRCascade<SampleType, 2> hpf;          // two high pass stages in series, each with its own state
+    SampleType carrierFreq{ 178 };              // frequency of carrier, Hz
+    SampleType filterFreq{ 180 };               // cutoff frequency for high pass filters, Hz
+    SampleType resonanceAmount{};               // volume level of the resonance
 };
\ No newline at end of file
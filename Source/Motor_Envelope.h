@@ -9,20 +9,27 @@
 */
 
 #pragma once
+#include "jr_MemoryArena.h"                 // used for jr::MemoryFootprint
+#include "jr_Snapshot.h"                    // used for jr::SnapshotWriter / SnapshotReader
+#include "jr_Ramp.h"                        // used for jr::Ramp
+#include "jr_PowerCurveTable.h"              // used for jr::PowerCurveTable
 
 /** A class to simulate the behaviour of an electric DC motor as it turns on and off, by modelling an envelope of its frequency and volume
 * use setSampleRate() before use, then call process() every sample, and call powerOn() and powerOff() to cause envelope to rise or fall
 */
+template <typename SampleType>
 class MotorEnvelope
 {
 public:
 
+    MotorEnvelope() : powerCurve (&jr::PowerCurveTable<SampleType>::getShared()) {}
+
     //================== mutators ===================//
 
     /** Sets the sample rate
     * @param sr - sample rate, Hz
     */
-    void setSampleRate (float sr) 
+    void setSampleRate (SampleType sr) 
     { 
         sampleRate = sr;
         volDelta = 1.0f / (powerDownTimeSeconds * sampleRate);
@@ -31,12 +38,12 @@ public:
     /** Sets the time in seconds that it takes for the envelope to reach its max value from 0
     * @param time - power up time, seconds
     */
-    void setPowerUpTime (float time) { powerUpTimeSeconds = time; }
+    void setPowerUpTime (SampleType time) { powerUpTimeSeconds = time; }
 
     /** Sets the time in seconds that it takes for the envelope to fall from its max value to 0
     * @param time - power down time, seconds
     */
-    void setPowerDownTime (float time) 
+    void setPowerDownTime (SampleType time) 
     { 
         powerDownTimeSeconds = time; 
         volDelta = 1.0f / (powerDownTimeSeconds * sampleRate);
@@ -45,7 +52,7 @@ public:
     /** Sets the acceleration rate of the envelope
     * @param rate - 0-1 value, where 0 is the minimum acceleration rate, and 1 is the max
     */
-    void setAccelRate (float rate) { accelRate = rate; }
+    void setAccelRate (SampleType rate) { accelRate = rate; }
 
     //=============== actions ===============//
 
@@ -68,21 +75,28 @@ public:
         phase.setCurrentAndTargetValue (0.0f);
     }
 
+    /** Puts the envelope straight into its fully on or fully off state, as if the motor had been in that state for longer than the power up/down time
+    * @param isPoweredOn - true for fully on, false for fully off
+    */
+    void setSteadyState (bool isPoweredOn)
+    {
+        poweringOff = false;
+        phase.reset (sampleRate, powerUpTimeSeconds);
+        phase.setCurrentAndTargetValue (isPoweredOn ? 0.5f : 0.0f);
+        currentEnvValue = isPoweredOn ? 1.0f : 0.0f;
+    }
+
     /** processes the envelope, updating the currentEnvValue and then returning this value
     * @return currentEnvValue
     */
-    float process()
+    SampleType process()
     {
         if (!poweringOff)
         {
-            float currentPhaseVal = phase.getNextValue() * 2.0;
-
-            float risingVal = 1.0f - juce::jmin (1.0f, currentPhaseVal);
-            risingVal = pow (risingVal, (3.0f + (accelRate * 6.0f)));
+            // the phase rises from 0 to 1 over the power up time, the curve is read from the shared table
+            SampleType currentPhaseVal = phase.getNextValue() * 2.0;
 
-            float fallingVal = juce::jmax (1.0f, currentPhaseVal) - 1.0f;
-
-            currentEnvValue = 1.0f + (-1.0f * (risingVal + fallingVal));
+            currentEnvValue = powerCurve->getValue (accelRate, currentPhaseVal);
         }
         else
         {
@@ -100,15 +114,36 @@ public:
 
     //================ accessors ================//
 
-    float getCurrentValue() { return currentEnvValue; }
+    SampleType getCurrentValue() const { return currentEnvValue; }
+
+    /** Writes the envelope's phase, settings and power off state to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        writer.write (phase, powerUpTimeSeconds, powerDownTimeSeconds, volDelta, accelRate, currentEnvValue, poweringOff);
+    }
+
+    /** Reads the envelope's phase, settings and power off state from a snapshot
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        reader.read (phase, powerUpTimeSeconds, powerDownTimeSeconds, volDelta, accelRate, currentEnvValue, poweringOff);
+    }
+
+    /** Returns the memory used by the envelope
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
 
 private:
-    juce::SmoothedValue<float> phase;
-    float powerUpTimeSeconds{ 1.5f };           // time in seconds for envelope to rise to max value
-    float powerDownTimeSeconds{ 1.5f };         // time in seconds for envelope to fall from max value
-    float volDelta{};                           // increment needed to linearly decrease volume from 1 to 0 over desired power down time
-    float accelRate{ 0.5f };                    // rate at which the envelope rises exponentially - 0-1 value, 0 is min rate, 1 is max
-    float sampleRate{};
-    float currentEnvValue{};                    // current value of the envelope
+    jr::Ramp<SampleType> phase;
+    const jr::PowerCurveTable<SampleType>* powerCurve;     // shared table of the power up curve
+    SampleType powerUpTimeSeconds{ 1.5f };      // time in seconds for envelope to rise to max value
+    SampleType powerDownTimeSeconds{ 1.5f };    // time in seconds for envelope to fall from max value
+    SampleType volDelta{};                      // increment needed to linearly decrease volume from 1 to 0 over desired power down time
+    SampleType accelRate{ 0.5f };               // rate at which the envelope rises exponentially - 0-1 value, 0 is min rate, 1 is max
+    SampleType sampleRate{};
+    SampleType currentEnvValue{};               // current value of the envelope
     bool poweringOff{ false };
 };
\ No newline at end of file
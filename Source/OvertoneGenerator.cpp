@@ -16,84 +16,106 @@
 
 //===================== mutator functions ===================//
 
-OvertoneGenerator::OvertoneGenerator()
+template <typename SampleType>
+size_t OvertoneGenerator<SampleType>::getRequiredMemory (SampleType sr) const
 {
-    setSampleRate (44100);
+    return jr::DelayLine<SampleType>::getRequiredMemory ((0.5 * sr) + maxBlockSize, storage);
 }
 
-void OvertoneGenerator::setSampleRate (float sr)
+template <typename SampleType>
+void OvertoneGenerator<SampleType>::prepare (SampleType sr, jr::MemoryArena& arena)
 {
-    if (sr != sampleRate)
-    {
-        sampleRate = sr;
-
-        delaySpecs.numChannels = 1;
-        delaySpecs.maximumBlockSize = 512;
-        delaySpecs.sampleRate = sampleRate;
-        
-        delay.prepare(delaySpecs);
-        delay.setMaximumDelayInSamples (0.5 * sampleRate);
-    }
+    sampleRate = sr;
+
+    for (size_t i = 0; i < (size_t) maxOvertones; i++)
+        updateDelayInSamples (i);
+
+    // the driving phasor is in the range 0-1, and the delay has room for a block more than the longest transmission delay so processBlock() can write a block at once
+    delay.prepare ((0.5 * sampleRate) + maxBlockSize, arena, storage, 1.0f);
 }
 
-void OvertoneGenerator::setOvertoneParams (size_t overtoneNum, float del, float p, float freq, float a)
+template <typename SampleType>
+void OvertoneGenerator<SampleType>::setOvertoneParams (size_t overtoneNum, SampleType del, SampleType p, SampleType freq, SampleType a)
 {
-    if (overtoneNum < 0 || overtoneNum > 2)
+    if (overtoneNum >= (size_t) maxOvertones)
         return;
 
     transmissionDelayVals[overtoneNum] = (del / 1000.0f);
     phaseShiftVals[overtoneNum] = p;
     freqVals[overtoneNum] = freq;
     ampVals[overtoneNum] = a;
+
+    rangeScales[overtoneNum] = 1.0f / (1.0f - p);
+    freqScales[overtoneNum] = p * freq * 12;
+    ampScales[overtoneNum] = 12.0f * a;
+    updateDelayInSamples (overtoneNum);
 }
 
-void OvertoneGenerator::process (float driveIn)
+template <typename SampleType>
+void OvertoneGenerator<SampleType>::setFrequencyModifier (size_t overtoneNum, SampleType modifier)
 {
+    if (overtoneNum >= (size_t) maxOvertones || modifier < 1)
+        return;
 
-    // write new value into delay buffer
-    delay.pushSample (0, driveIn);
-
-    for (size_t i = 0; i < 3; i++)
-    {
-        bool updateReadPos = false;
-        if (i == 2)
-            updateReadPos = true;
-
-        float drive = (delay.popSample (0, transmissionDelayVals[i] * sampleRate, updateReadPos) * modVals[i]);
+    modVals[overtoneNum] = modifier;
+}
 
-        while (drive > 1)
-            drive -= 1;
+template <typename SampleType>
+void OvertoneGenerator<SampleType>::process (SampleType driveIn)
+{
+    // write new value into delay buffer, then read every overtone's transmission delay from it
+    delay.pushSample (driveIn);
+    delay.popSamples (delayInSamples, driveVals, numOvertones);
 
-        overtoneSampleVals[i] = generateOvertone (drive, phaseShiftVals[i], freqVals[i], ampVals[i]);
-    }
+    // every lane is evaluated, so the loop has a fixed length and vectorises fully (lanes past numOvertones are never read)
+    for (int i = 0; i < maxOvertones; i++)
+        overtoneSampleVals[i] = getOvertoneValue (i, driveVals[i]);
 }
 
-float OvertoneGenerator::generateOvertone (float driveIn, float pShiftIn, float freqIn, float ampIn)
+template <typename SampleType>
+void OvertoneGenerator<SampleType>::processBlock (const SampleType* drives, SampleType* const* outputs, int numOutputs, int numSamples)
 {
-    // ignores phasor values below pShiftIn value
-    float output = (driveIn > pShiftIn ? driveIn : pShiftIn) - pShiftIn;
+    for (int blockStart = 0; blockStart < numSamples; blockStart += maxBlockSize)
+    {
+        int numInBlock = juce::jmin (maxBlockSize, numSamples - blockStart);
+
+        // the whole block is written to the delay buffer first, then each overtone reads its delay for every sample of the block in one pass
+        delay.pushSamples (drives + blockStart, numInBlock);
 
-    // shifts range back to 0-1
-    output *= (1.0f / (1.0f - pShiftIn));
+        for (int overtone = 0; overtone < numOvertones; overtone++)
+        {
+            delay.readBlock (delayInSamples[overtone], overtoneBlock, numInBlock);
 
-    // apply frequency shift
-    output *= (pShiftIn * freqIn * 12);
+            for (int i = 0; i < numInBlock; i++)
+                overtoneBlock[i] = getOvertoneValue (overtone, overtoneBlock[i]);
 
-    // wrap output into -0.5 to 0.5 range
-    while (output >  1)
-        output -= 1;
+            if (overtone < numOutputs)
+                juce::FloatVectorOperations::copy (outputs[overtone] + blockStart, overtoneBlock, numInBlock);
 
-    output -= 0.5f;
+            overtoneSampleVals[overtone] = overtoneBlock[numInBlock - 1];
+        }
+
+        delay.skipSamples (numInBlock);
+    }
+}
 
-    // apply parabolic transform
-    output *= output;
-    output = (((output) * -4.0f) + 1.0f) * 0.5f;
+template <typename SampleType>
+void OvertoneGenerator<SampleType>::saveState (jr::SnapshotWriter& writer) const
+{
+    delay.saveState (writer);
+    writer.write (numOvertones, transmissionDelayVals, delayInSamples, phaseShiftVals, freqVals, ampVals);
+    writer.write (rangeScales, freqScales, ampScales, modVals, overtoneSampleVals);
+}
 
-    // use driveIn to cause a linear decay
-    output *= (1.0f - driveIn);
+template <typename SampleType>
+void OvertoneGenerator<SampleType>::loadState (jr::SnapshotReader& reader)
+{
+    delay.loadState (reader);
+    reader.read (numOvertones, transmissionDelayVals, delayInSamples, phaseShiftVals, freqVals, ampVals);
+    reader.read (rangeScales, freqScales, ampScales, modVals, overtoneSampleVals);
+}
 
-    // apply amplitude control
-    output *= (12.0f * ampIn);
+//======================= Explicit Instantiations =========================//
 
-    return output;
-}
\ No newline at end of file
+template class OvertoneGenerator<float>;
+template class OvertoneGenerator<double>;
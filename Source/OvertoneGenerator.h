@@ -10,61 +10,162 @@
 
 #pragma once
 #include <JuceHeader.h>
-using juceDelay = juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::Linear>;
+#include "jr_Delay.h"               // used for jr::DelayLine
+#include "jr_MemoryArena.h"         // used for jr::MemoryArena
+#include "jr_Snapshot.h"            // used for jr::SnapshotWriter / SnapshotReader
 
-/** A class that models the generation of 3 separate overtones, each to be fed into the circular waveguide of an Engine model
+/** A class that models the generation of a number of separate overtones (3 by default, up to maxOvertones), each to be fed into the circular waveguide of an Engine model.
+The parameters of each overtone are held in arrays (one per parameter), so every overtone is read from the drive delay in one multi-tap pass and evaluated
+in a single branch-free loop the compiler can vectorise. processBlock() writes a block of the drive to the delay at once, then works through each overtone a block at a time
 */
+template <typename SampleType>
 class OvertoneGenerator
 {
 public:
 
-    /** Constructor
+    static constexpr int maxOvertones{ 16 };    // most overtones the generator can hold
+    static constexpr int maxBlockSize{ 64 };    // most samples processBlock() writes to the delay at once, longer blocks are split
+
+    /** Sets the number of overtones generated
+    * @param num - number of overtones (1 to maxOvertones)
     */
-    OvertoneGenerator();
+    void setNumOvertones (int num) { numOvertones = juce::jlimit (1, maxOvertones, num); }
 
     /** Sets the parameter values for a specified overtone
-    * @param overtoneNum - index of overtone to set parameters for (0, 1 or 2)
+    * @param overtoneNum - index of overtone to set parameters for (0 to maxOvertones - 1)
     * @param del - transmission delay (0-100), ms
     * @param p - phase shift (0-1)
     * @param freq - frequency control (0-1)
     * @param a - amplitude control (0-1)
     */
-    void setOvertoneParams (size_t overtoneNum, float del, float p, float freq, float a);
+    void setOvertoneParams (size_t overtoneNum, SampleType del, SampleType p, SampleType freq, SampleType a);
+
+    /** Sets how many times faster than the driving phasor an overtone repeats. The first three default to 16, 4 and 8, and later overtones repeat that pattern
+    * @param overtoneNum - index of overtone (0 to maxOvertones - 1)
+    * @param modifier - frequency modifier, a whole number of at least 1
+    */
+    void setFrequencyModifier (size_t overtoneNum, SampleType modifier);
+
+    /** Sets whether the drive delay line is stored as 16-bit fixed point (half the memory) instead of floats - call before getRequiredMemory() and prepare()
+    * @param isCompact - true for compact storage
+    */
+    void setCompactStorage (bool isCompact) { storage = isCompact ? jr::DelayStorage::FIXED16 : jr::DelayStorage::FULL_PRECISION; }
 
-    /** Sets the sample rate
+    /** Returns the number of bytes of arena memory the generator's delay line needs
     * @param sr - sample rate, Hz
     */
-    void setSampleRate (float sr);
-    
-    /** Processes the generator, updating the values for the 3 overtones
+    size_t getRequiredMemory (SampleType sr) const;
+
+    /** Sets the sample rate and takes the delay line from the arena - call before use
+    * @param sr - sample rate, Hz
+    * @param arena - arena with room for getRequiredMemory() bytes
+    */
+    void prepare (SampleType sr, jr::MemoryArena& arena);
+
+    /** Processes the generator, updating the values for every overtone
     * @param driveIn - current sample value for driving phasor
     */
-    void process (float driveIn);
+    void process (SampleType driveIn);
+
+    /** Processes a block of the generator, giving the same overtone values as a process() call for each sample
+    * @param drives - sample values for driving phasor
+    * @param outputs - array for each of the first numOutputs overtones to write its sample values to
+    * @param numOutputs - number of overtones written to outputs (0 to getNumOvertones())
+    * @param numSamples - number of samples
+    */
+    void processBlock (const SampleType* drives, SampleType* const* outputs, int numOutputs, int numSamples);
+
+    /** Returns the number of overtones generated
+    */
+    int getNumOvertones() const { return numOvertones; }
 
     /** Returns the current sample value of a specified overtone
-    * @param overtoneNum - index of desired overtone (0, 1, 2)
+    * @param overtoneNum - index of desired overtone (0 to getNumOvertones() - 1)
+    */
+    SampleType getOvertoneVal (size_t overtoneNum) { return overtoneSampleVals[overtoneNum]; }
+
+    /** Returns the current sample values of every overtone, getNumOvertones() values
+    */
+    const SampleType* getOvertoneVals() const { return overtoneSampleVals; }
+
+    /** Writes the complete DSP state of the generator to a snapshot
+    * @param writer - snapshot writer
     */
-    float getOvertoneVal (size_t overtoneNum) { return overtoneSampleVals[overtoneNum]; }
+    void saveState (jr::SnapshotWriter& writer) const;
+
+    /** Reads the complete DSP state of the generator from a snapshot taken from a generator prepared the same way
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader);
+
+    /** Returns the memory used by the generator, including its delay line in the arena
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), delay.getMemoryFootprint().bufferBytes }; }
 
 private:
 
-    /** Returns the corresponding sample value for an overtone generated from input phasor and parameters
-    * @param driveIn - current sample value for driving phasor
-    * @param pShiftIn - phase shift amount (0-1)
-    * @param freqIn - frequency control value (0-1)
-    * @param ampIn - amplitude control value (0-1)
+    /** Returns a value wrapped into the range 0-1 without a loop or branch, giving exactly what subtracting 1 while above 1 would (so whole numbers wrap to 1)
+    * @param value - value to wrap
+    */
+    static SampleType wrap (SampleType value)
+    {
+        // the ceiling is worked out in integers, as float selects and std::ceil() stop the process loop vectorising
+        int whole = (int) value;
+        int ceiling = whole + (value > (SampleType) whole ? 1 : 0);
+        return value + (SampleType) (1 - (ceiling > 1 ? ceiling : 1));
+    }
+
+    /** Returns the sample value of an overtone for a delayed driving phasor value, called for each overtone by process() and processBlock()
+    * @param overtoneNum - index of overtone
+    * @param driveVal - driving phasor, delayed by the overtone's transmission delay
+    */
+    SampleType getOvertoneValue (int overtoneNum, SampleType driveVal) const
+    {
+        SampleType drive = wrap (driveVal * modVals[overtoneNum]);
+        SampleType pShift = phaseShiftVals[overtoneNum];
+
+        // ignores phasor values below the phase shift value, then shifts range back to 0-1
+        SampleType output = (drive > pShift ? drive : pShift) - pShift;
+        output *= rangeScales[overtoneNum];
+
+        // apply frequency shift
+        output *= freqScales[overtoneNum];
+
+        // wrap output into -0.5 to 0.5 range
+        output = wrap (output) - 0.5f;
+
+        // apply parabolic transform
+        output *= output;
+        output = (((output) * -4.0f) + 1.0f) * 0.5f;
+
+        // use drive to cause a linear decay
+        output *= (1.0f - drive);
+
+        // apply amplitude control
+        return output * ampScales[overtoneNum];
+    }
+
+    /** Updates the transmission delay of an overtone in samples, called when its delay or the sample rate changes
+    * @param overtoneNum - index of overtone
     */
-    float generateOvertone (float driveIn, float pShiftIn, float freqIn, float ampIn);
+    void updateDelayInSamples (size_t overtoneNum) { delayInSamples[overtoneNum] = transmissionDelayVals[overtoneNum] * sampleRate; }
 
 private:
-    float sampleRate{};                 // sample rate, Hz
-    juceDelay delay;                    // delay buffer holding driving phasor output
-    juce::dsp::ProcessSpec delaySpecs;  // specifications to initialise the delay line
-    float transmissionDelayVals[3]{};   // array of transmission delay values coresponding to the 3 overtones (each 0-100ms)
-    float phaseShiftVals[3]{};          // array of phase shift values coresponding to the 3 overtones (each 0-1)
-    float freqVals[3]{};                // array of frequency control values coresponding to the 3 overtones (each 0-1)
-    float ampVals[3]{};                 // array of amplitude control values coresponding to the 3 overtones (each 0-1)
-    float overtoneSampleVals[3]{};      // array of current sample values corresponding to the 3 overtones
-    float modVals[3]{ 16.0f, 4.0f, 8.0f }; // array of frequency modifiers corresponding to each overtone
-    bool initialised{ false };          // bool returns true once delay buffer has been initiated to stop to size being set multiple times
-};
\ No newline at end of file
+    SampleType sampleRate{};                                    // sample rate, Hz
+    jr::DelayLine<SampleType> delay;                            // delay buffer holding driving phasor output
+    jr::DelayStorage storage{ jr::DelayStorage::FULL_PRECISION };  // sample format of delay buffer
+    int numOvertones{ 3 };                                      // number of overtones generated
+
+    SampleType transmissionDelayVals[maxOvertones]{};           // transmission delay of each overtone (each 0-0.1), seconds
+    SampleType delayInSamples[maxOvertones]{};                  // transmission delay of each overtone, samples
+    SampleType phaseShiftVals[maxOvertones]{};                  // phase shift of each overtone (each 0-1)
+    SampleType freqVals[maxOvertones]{};                        // frequency control of each overtone (each 0-1)
+    SampleType ampVals[maxOvertones]{};                         // amplitude control of each overtone (each 0-1)
+    SampleType rangeScales[maxOvertones]{};                     // 1 / (1 - phase shift) of each overtone, shifting its range back to 0-1
+    SampleType freqScales[maxOvertones]{};                      // phase shift * frequency control * 12 of each overtone
+    SampleType ampScales[maxOvertones]{};                       // amplitude control * 12 of each overtone
+    SampleType modVals[maxOvertones]{ 16.0f, 4.0f, 8.0f, 16.0f, 4.0f, 8.0f, 16.0f, 4.0f, 8.0f, 16.0f, 4.0f, 8.0f, 16.0f, 4.0f, 8.0f, 16.0f };   // frequency modifier of each overtone
+    SampleType driveVals[maxOvertones]{};                       // delayed driving phasor read for each overtone this sample
+    SampleType overtoneBlock[maxBlockSize]{};                   // delayed driving phasor, then sample value, of one overtone for the current block
+    SampleType overtoneSampleVals[maxOvertones]{};              // current sample value of each overtone
+};
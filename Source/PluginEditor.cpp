@@ -9,13 +9,39 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    /** Returns a line of text describing a footprint in kilobytes
+    */
+    juce::String describeFootprint (const juce::String& name, jr::MemoryFootprint footprint)
+    {
+        return name + ": " + juce::String (footprint.getTotalBytes() / 1024.0, 1) + " KB ("
+               + juce::String (footprint.stateBytes / 1024.0, 1) + " KB state, "
+               + juce::String (footprint.bufferBytes / 1024.0, 1) + " KB buffers)";
+    }
+}
+
 //==============================================================================
 MechanicalModellingAudioProcessorEditor::MechanicalModellingAudioProcessorEditor (MechanicalModellingAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), parameterEditor (p)
 {
+    addAndMakeVisible (parameterEditor);
+
+    memoryLabel.setFont (juce::Font (12.0f));
+    memoryLabel.setJustificationType (juce::Justification::topLeft);
+    addAndMakeVisible (memoryLabel);
+
+    compactStorageButton.setButtonText ("Compact delay storage (applied when playback is next prepared)");
+    compactStorageButton.setToggleState (audioProcessor.getCompactDelayStorage(), juce::dontSendNotification);
+    compactStorageButton.onClick = [this] { audioProcessor.setCompactDelayStorage (compactStorageButton.getToggleState()); };
+    addAndMakeVisible (compactStorageButton);
+
+    timerCallback();
+    startTimerHz (1);
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (parameterEditor.getWidth(), parameterEditor.getHeight() + memoryLabelHeight + compactStorageButtonHeight);
 }
 
 MechanicalModellingAudioProcessorEditor::~MechanicalModellingAudioProcessorEditor()
@@ -27,14 +53,24 @@ void MechanicalModellingAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 void MechanicalModellingAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto bounds = getLocalBounds();
+
+    compactStorageButton.setBounds (bounds.removeFromBottom (compactStorageButtonHeight).reduced (4, 0));
+    memoryLabel.setBounds (bounds.removeFromBottom (memoryLabelHeight).reduced (4));
+    parameterEditor.setBounds (bounds);
+}
+
+void MechanicalModellingAudioProcessorEditor::timerCallback()
+{
+    juce::String text;
+    text << describeFootprint ("Instance", audioProcessor.getMemoryFootprint()) << "\n"
+         << describeFootprint ("Engine", audioProcessor.getEngineFootprint()) << "\n"
+         << describeFootprint ("Motor", audioProcessor.getMotorFootprint()) << "\n"
+         << describeFootprint ("Fan", audioProcessor.getFanFootprint());
+
+    memoryLabel.setText (text, juce::dontSendNotification);
 }
@@ -14,7 +14,8 @@
 //==============================================================================
 /**
 */
-class MechanicalModellingAudioProcessorEditor  : public juce::AudioProcessorEditor
+class MechanicalModellingAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                                 private juce::Timer
 {
 public:
     MechanicalModellingAudioProcessorEditor (MechanicalModellingAudioProcessor&);
@@ -25,9 +26,19 @@ public:
     void resized() override;
 
 private:
+    /** Refreshes the memory footprint text, which changes whenever the host calls prepareToPlay()
+    */
+    void timerCallback() override;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     MechanicalModellingAudioProcessor& audioProcessor;
 
+    juce::GenericAudioProcessorEditor parameterEditor;     // sliders/buttons for every parameter
+    juce::Label memoryLabel;                                // shows the memory footprint of this instance
+    juce::ToggleButton compactStorageButton;                // switches compact (16-bit) storage of long delay lines on/off
+    static constexpr int memoryLabelHeight{ 70 };           // height of memory footprint area, pixels
+    static constexpr int compactStorageButtonHeight{ 24 };  // height of compact storage toggle, pixels
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MechanicalModellingAudioProcessorEditor)
 };
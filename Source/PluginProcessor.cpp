@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "jr_RealtimeChecker.h"
 
 //==============================================================================
 MechanicalModellingAudioProcessor::MechanicalModellingAudioProcessor()
@@ -18,6 +19,9 @@ MechanicalModellingAudioProcessor::MechanicalModellingAudioProcessor()
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                       .withOutput ("Engine", juce::AudioChannelSet::stereo(), false)
+                       .withOutput ("Motor", juce::AudioChannelSet::stereo(), false)
+                       .withOutput ("Fan", juce::AudioChannelSet::stereo(), false)
                      #endif
                        ),
 #endif
@@ -53,7 +57,11 @@ MechanicalModellingAudioProcessor::MechanicalModellingAudioProcessor()
         std::make_unique<juce::AudioParameterFloat>("engineLength", "Engine Exhaust Length", 0.0f, 1.0f, 0.65f),
         std::make_unique<juce::AudioParameterFloat>("engineOT1", "Engine Overtone 1 Level", 0.0f, 1.0f, 0.5f),
         std::make_unique<juce::AudioParameterFloat>("engineOT2", "Engine Overtone 2 Level", 0.0f, 1.0f, 0.27),
-        std::make_unique<juce::AudioParameterFloat>("engineOT3", "Engine Overtone 3 Level", 0.0f, 1.0f, 0.42f)
+        std::make_unique<juce::AudioParameterFloat>("engineOT3", "Engine Overtone 3 Level", 0.0f, 1.0f, 0.42f),
+
+        // Input Params
+        std::make_unique<juce::AudioParameterChoice>("inputMode", "Input Mode", juce::StringArray { "Off", "Waveguide Exciter", "Resonator Exciter", "Motor Speed" }, 0),
+        std::make_unique<juce::AudioParameterFloat>("inputGain", "Input Level", 0.0f, 4.0f, 1.0f)
         })
 {
     // Global Params
@@ -88,76 +96,292 @@ MechanicalModellingAudioProcessor::MechanicalModellingAudioProcessor()
     engineOT1Param = parameters.getRawParameterValue("engineOT1");
     engineOT2Param = parameters.getRawParameterValue("engineOT2");
     engineOT3Param = parameters.getRawParameterValue("engineOT3");
+
+    // Input Params
+    inputModeParam = parameters.getRawParameterValue("inputMode");
+    inputGainParam = parameters.getRawParameterValue("inputGain");
 }
 
 MechanicalModellingAudioProcessor::~MechanicalModellingAudioProcessor()
 {
+    clearTelemetry();
 }
 
 void MechanicalModellingAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    smoothedGain.reset(sampleRate, 0.1f);
-    smoothedMaxSpeed.reset(sampleRate, 0.55f);
-
-    engine.setSampleRate(sampleRate);
-    fan.setSampleRate(sampleRate);
-    motor.setSampleRate(sampleRate);
+    // find where each source goes in the main output layout
+    auto outputLayout = getChannelLayoutOfBus (false, 0);
+    outputRouting.left = outputLayout.getChannelIndexForType (juce::AudioChannelSet::left);
+    outputRouting.right = outputLayout.getChannelIndexForType (juce::AudioChannelSet::right);
+    outputRouting.centre = outputLayout.getChannelIndexForType (juce::AudioChannelSet::centre);
+    outputRouting.numChannels = outputLayout.size();
+
+    if (! outputRouting.isStereo() && outputRouting.centre < 0)
+        outputRouting.centre = 0;
+
+    // the machine renders in chunks of its own fixed size, so the arena doesn't depend on the host's block size
+    juce::ignoreUnused (samplesPerBlock);
+
+    // only the models for the precision the host has chosen take memory from the arena
+    if (isUsingDoublePrecision())
+        prepareMachine (doubleMachine, sampleRate);
+    else
+        prepareMachine (floatMachine, sampleRate);
 }
 
 void MechanicalModellingAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processMachine (floatMachine, buffer, midiMessages);
+}
+
+void MechanicalModellingAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processMachine (doubleMachine, buffer, midiMessages);
+}
+
+void MechanicalModellingAudioProcessor::setRandomSeed (juce::int64 seed)
+{
+    floatMachine.setRandomSeed (seed);
+    doubleMachine.setRandomSeed (seed);
+}
+
+void MechanicalModellingAudioProcessor::saveState (jr::SnapshotWriter& writer) const
+{
+    writer.write (midiControls);
+
+    if (isUsingDoublePrecision())
+        doubleMachine.saveState (writer);
+    else
+        floatMachine.saveState (writer);
+}
+
+void MechanicalModellingAudioProcessor::loadState (jr::SnapshotReader& reader)
+{
+    reader.read (midiControls);
+
+    if (isUsingDoublePrecision())
+        doubleMachine.loadState (reader);
+    else
+        floatMachine.loadState (reader);
+}
+
+MachineParams MechanicalModellingAudioProcessor::getParams() const
+{
+    MachineParams params;
+
+    // Global Params
+    params.trigger = *triggerParam >= 0.5f;
+    params.masterGain = *gainParam;
+    params.powerUpTime = *powerUpParam;
+    params.powerDownTime = *powerDownParam;
+    params.acceleration = *accelerationParam;
+
+    // Motor Params
+    params.motorGain = *motorGainParam;
+    params.motorMaxSpeed = *motorMaxSpeedParam;
+    params.motorCasingSize = *motorCasingSizeParam;
+    params.motorRotorLevel = *motorRotorParam;
+    params.motorSparksLevel = *motorSparksParam;
+    params.motorHum = *motorHumParam >= 0.5f;
+
+    // Fan Params
+    params.fanGain = *fanGainParam;
+    params.fanRatio = *fanRatioParam;
+    params.fanToneLevel = *fanToneParam;
+    params.fanNoiseLevel = *fanNoiseParam;
+    params.fanStereoWidth = *fanStereoParam;
+    params.fanDoppler = *fanDopplerParam >= 0.5f;
+
+    // Engine Params
+    params.engineGain = *engineGainParam;
+    params.engineRevs = *engineRevsParam;
+    params.engineWidth = *engineWidthParam;
+    params.engineLength = *engineLengthParam;
+    params.engineOT1 = *engineOT1Param;
+    params.engineOT2 = *engineOT2Param;
+    params.engineOT3 = *engineOT3Param;
+
+    // Input Params
+    params.inputMode = (MachineInputMode) juce::roundToInt (inputModeParam->load());
+    params.inputGain = *inputGainParam;
+
+    return params;
+}
+
+void MechanicalModellingAudioProcessor::handleMidiMessage (const juce::MidiMessage& message)
+{
+    if (message.isNoteOn())
+    {
+        if (! midiControls.heldNotes[message.getNoteNumber()])
+        {
+            midiControls.heldNotes[message.getNoteNumber()] = true;
+            midiControls.numNotesHeld++;
+        }
+    }
+    else if (message.isNoteOff())
+    {
+        if (midiControls.heldNotes[message.getNoteNumber()])
+        {
+            midiControls.heldNotes[message.getNoteNumber()] = false;
+            midiControls.numNotesHeld--;
+        }
+    }
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        midiControls.heldNotes.fill (false);
+        midiControls.numNotesHeld = 0;
+    }
+    else if (message.isControllerOfType (1))
+    {
+        midiControls.revs = message.getControllerValue() / 127.0f;
+    }
+    else if (message.isPitchWheel())
+    {
+        float bend = (message.getPitchWheelValue() - 8192) / 8192.0f;     // -1 to 1
+        midiControls.speedScale = std::exp2 (bend);
+    }
+}
+
+MachineParams MechanicalModellingAudioProcessor::applyMidiControls (MachineParams params) const
+{
+    params.trigger = params.trigger || midiControls.numNotesHeld > 0;
+    params.engineRevs = juce::jlimit (0.0f, 1.0f, params.engineRevs + midiControls.revs);
+    params.motorMaxSpeed = juce::jlimit (60.0f, 800.0f, params.motorMaxSpeed * midiControls.speedScale);
+
+    return params;
+}
+
+bool MechanicalModellingAudioProcessor::loadTelemetry (const juce::File& file)
+{
+    auto telemetry = std::make_unique<jr::TelemetryLog>();
+
+    if (! telemetry->open (file))
+        return false;
+
+    swapTelemetry (std::move (telemetry));
+    return true;
+}
+
+void MechanicalModellingAudioProcessor::clearTelemetry()
+{
+    swapTelemetry (nullptr);
+}
+
+juce::File MechanicalModellingAudioProcessor::getTelemetryFile() const
+{
+    auto* telemetry = activeTelemetry.load();
+    return telemetry != nullptr ? telemetry->getFile() : juce::File();
+}
+
+void MechanicalModellingAudioProcessor::swapTelemetry (std::unique_ptr<jr::TelemetryLog> newTelemetry)
+{
+    std::unique_ptr<jr::TelemetryLog> oldTelemetry (activeTelemetry.exchange (newTelemetry.release()));
+
+    // the audio thread raises the flag before reading the pointer, so once the flag is down it can't still hold the old log
+    while (isReadingTelemetry)
+        juce::Thread::yield();
+}
+
+template <typename SampleType>
+void MechanicalModellingAudioProcessor::prepareMachine (Machine<SampleType>& machine, double sampleRate)
+{
+    machine.setCompactStorage (compactDelayStorage);
+
+    // lay out every delay line in one block, allocated here so nothing is allocated during processBlock()
+    arena.prepare (machine.getRequiredMemory (sampleRate));
+
+    machine.prepare (sampleRate, arena);
+}
+
+template <typename SampleType>
+void MechanicalModellingAudioProcessor::processMachine (Machine<SampleType>& machine, juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    jr::realtime::ScopedAudioThreadCheck realtimeCheck;    // debug builds: flags any allocation or lock taken during the callback
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
+    // the machine reads the input a chunk at a time before overwriting that part of the main output
     int numSamples = buffer.getNumSamples();
+    auto mainBuffer = getBusBuffer (buffer, false, 0);
+    SampleType* const* outputChannels = mainBuffer.getArrayOfWritePointers();
 
-    float* leftChannel = buffer.getWritePointer(0);
-    float* rightChannel = buffer.getWritePointer(1);
+    auto inputBuffer = getBusCount (true) > 0 ? getBusBuffer (buffer, true, 0) : juce::AudioBuffer<SampleType>();
+    const SampleType* const* inputChannels = inputBuffer.getArrayOfReadPointers();
+    int numInputChannels = inputBuffer.getNumChannels();
 
-    // update smoothed value targets
-    smoothedGain.setTargetValue(*gainParam);
-    smoothedMaxSpeed.setTargetValue(*motorMaxSpeedParam);
+    // any enabled stem buses get each model on its own
+    typename Machine<SampleType>::Stems stems;
+    SampleType** stemChannels[] = { stems.engine, stems.motor, stems.fan };
 
-    //=============================== DSP LOOP ===============================//
-    for (int i = 0; i < numSamples; i++)
+    for (int stem = 0; stem < 3; stem++)
     {
-        motorMaxSpeedVal = smoothedMaxSpeed.getNextValue();
-        int resMode = *motorHumParam;
-        motor.setMappedParams(*powerUpParam, *powerDownParam, *accelerationParam, *motorGainParam, motorMaxSpeedVal, *motorCasingSizeParam, *motorRotorParam, *motorSparksParam, *motorHumParam);
+        if (auto* bus = getBus (false, stemBusIndex + stem))
+        {
+            if (bus->isEnabled())
+            {
+                auto stemBuffer = getBusBuffer (buffer, false, stemBusIndex + stem);
+                stemChannels[stem][0] = stemBuffer.getWritePointer (0);
+                stemChannels[stem][1] = stemBuffer.getNumChannels() > 1 ? stemBuffer.getWritePointer (1) : nullptr;
+            }
+        }
+    }
 
-        fan.setMappedParams(*fanGainParam, motor.getCurrentSpeed() / (*fanRatioParam), * fanToneParam, * fanNoiseParam, * fanStereoParam, *fanDopplerParam);
+    MachineParams params = getParams();
 
-        if (*triggerParam && !isPlaying)
+    // telemetry follows the host's transport, and only drives the machine while the host is playing
+    isReadingTelemetry = true;
+    const jr::TelemetryLog* telemetry = activeTelemetry.load();
+    double telemetryTime = 0.0;
+    int telemetryStep = numSamples;
+
+    if (telemetry != nullptr)
+    {
+        auto hostPosition = getPlayHead() != nullptr ? getPlayHead()->getPosition() : juce::Optional<juce::AudioPlayHead::PositionInfo>();
+        auto timeInSeconds = hostPosition.hasValue() ? hostPosition->getTimeInSeconds() : juce::Optional<double>();
+
+        if (hostPosition.hasValue() && hostPosition->getIsPlaying() && timeInSeconds.hasValue())
         {
-            isPlaying = true;
-            motor.powerOn();
+            telemetryTime = *timeInSeconds;
+            telemetryStep = juce::jmax (1, (int) (getSampleRate() / telemetry->getFrameRate()));
         }
-        else if (isPlaying && !(*triggerParam))
+        else
         {
-            isPlaying = false;
-            motor.powerOff();
+            telemetry = nullptr;
         }
+    }
 
-        float motorOut = motor.process();
-        fan.process();
+    // render from the current position up to a sample, updating the values from the telemetry once per frame
+    int position = 0;
 
-        float revsVal = *engineRevsParam;
-        if (*triggerParam == false)
-            revsVal = 0;
+    auto renderUpTo = [&] (int endPosition)
+    {
+        while (position < endPosition)
+        {
+            int numToRender = juce::jmin (telemetryStep, endPosition - position);
+            MachineParams blockParams = params;
 
-        float engineSpeedVal = (0.10 + (0.25 * motor.getEnvelope())) * (1.0f + (revsVal * 1.37f));
-        engine.setMappedParams(*engineGainParam, engineSpeedVal, 0.5f, *engineWidthParam, *engineLengthParam, *engineOT1Param, *engineOT2Param, *engineOT3Param);
-        float engineOut = engine.process();
+            if (telemetry != nullptr)
+                telemetry->applyTo (blockParams, telemetryTime + (position / getSampleRate()));
 
-        gainVal = smoothedGain.getNextValue();
+            machine.setParams (applyMidiControls (blockParams));
+            machine.process (outputChannels, outputRouting, position, numToRender, stems, inputChannels, numInputChannels);
+            position += numToRender;
+        }
+    };
 
-        leftChannel[i] = gainVal * (engineOut + motorOut + (motor.getEnvelope() * fan.getLeftSample()));
-        rightChannel[i] = gainVal * (engineOut + motorOut + (motor.getEnvelope() * fan.getRightSample()));
+    // render up to each MIDI event, then apply it, so that note on/off and controller changes land on the sample they were sent for
+    for (const auto metadata : midiMessages)
+    {
+        renderUpTo (juce::jlimit (position, numSamples, metadata.samplePosition));
+        handleMidiMessage (metadata.getMessage());
     }
+
+    renderUpTo (numSamples);
+    isReadingTelemetry = false;
 }
 //==============================================================================
 const juce::String MechanicalModellingAudioProcessor::getName() const
@@ -236,12 +460,12 @@ bool MechanicalModellingAudioProcessor::isBusesLayoutSupported (const BusesLayou
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // The main output can be mono, or any speaker layout with a left and right channel (stereo, LCR, 5.1, 7.1 etc.).
+    // Ambisonic and unnamed discrete layouts aren't supported as there is nowhere to place the sources.
+    auto mainOutput = layouts.getMainOutputChannelSet();
+
+    if (mainOutput != juce::AudioChannelSet::mono()
+     && (mainOutput.getChannelIndexForType (juce::AudioChannelSet::left) < 0 || mainOutput.getChannelIndexForType (juce::AudioChannelSet::right) < 0))
         return false;
 
     // This checks if the input layout matches the output layout
@@ -250,6 +474,15 @@ bool MechanicalModellingAudioProcessor::isBusesLayoutSupported (const BusesLayou
         return false;
    #endif
 
+    // stem buses are off, mono or stereo
+    for (int stem = 0; stem < 3; stem++)
+    {
+        auto stemSet = layouts.getChannelSet (false, stemBusIndex + stem);
+
+        if (! stemSet.isDisabled() && stemSet != juce::AudioChannelSet::mono() && stemSet != juce::AudioChannelSet::stereo())
+            return false;
+    }
+
     return true;
   #endif
 }
@@ -263,8 +496,7 @@ bool MechanicalModellingAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* MechanicalModellingAudioProcessor::createEditor()
 {
-    //return new MechanicalModellingAudioProcessorEditor (*this);
-    return new juce::GenericAudioProcessorEditor (*this);
+    return new MechanicalModellingAudioProcessorEditor (*this);
 }
 
 //==============================================================================
@@ -272,6 +504,8 @@ void MechanicalModellingAudioProcessor::getStateInformation (juce::MemoryBlock&
 {
     // getStateInformation
     auto state = parameters.copyState();
+    state.setProperty ("compactDelayStorage", compactDelayStorage.load(), nullptr);
+    state.setProperty ("telemetryFile", getTelemetryFile().getFullPathName(), nullptr);
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
 }
@@ -284,7 +518,15 @@ void MechanicalModellingAudioProcessor::setStateInformation (const void* data, i
     {
         if (xmlState->hasTagName(parameters.state.getType()))
         {
-            parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+            auto state = juce::ValueTree::fromXml(*xmlState);
+            compactDelayStorage = (bool) state.getProperty ("compactDelayStorage", false);
+
+            juce::String telemetryPath = state.getProperty ("telemetryFile", juce::String());
+
+            if (telemetryPath.isEmpty() || ! loadTelemetry (juce::File (telemetryPath)))
+                clearTelemetry();
+
+            parameters.replaceState(state);
         }
     }
 }
@@ -8,10 +8,12 @@
 
 #pragma once
 
+#include <array>
 #include <JuceHeader.h>
-#include "jr_Engine.h"
-#include "ElectricMotorDC.h"
-#include "jr_SimpleFan.h"
+#include "jr_Machine.h"
+#include "jr_MemoryArena.h"
+#include "jr_Snapshot.h"
+#include "jr_Telemetry.h"
 
 //==============================================================================
 /**
@@ -32,6 +34,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -56,18 +60,124 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    /** Returns the size of the arena holding every delay line of this instance, in bytes
+    */
+    size_t getArenaSizeInBytes() const { return arena.getSizeInBytes(); }
+
+    /** Sets whether the long delay lines (engine drive delays, fan delay) use 16-bit fixed point storage to halve their memory.
+    Takes effect the next time the host calls prepareToPlay()
+    * @param isCompact - true for compact storage
+    */
+    void setCompactDelayStorage (bool isCompact) { compactDelayStorage = isCompact; }
+
+    /** Returns true if compact delay storage is enabled (or will be, after the next prepareToPlay())
+    */
+    bool getCompactDelayStorage() const { return compactDelayStorage; }
+
+    /** Seeds every noise generator in the models, so that a render from the same parameters and seed is identical each time.
+    Call from the message thread before processing starts (e.g. when setting up an offline render)
+    * @param seed - seed value
+    */
+    void setRandomSeed (juce::int64 seed);
+
+    /** Writes the complete DSP state of the models (in the precision currently being processed) to a snapshot.
+    Use with jr::Snapshot to checkpoint an offline render; call from the thread that calls processBlock(), between blocks
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const;
+
+    /** Restores the DSP state of the models from a snapshot taken by saveState() at the same sample rate, precision and storage settings
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader);
+
+    /** Opens a telemetry log which drives the trigger, engine revs and motor max speed while the host is playing, following the host's
+    transport position. Replaces any log already open. Call from the message thread
+    * @param file - binary log (see jr::TelemetryLog::convertCsv())
+    * @return true if the log was opened
+    */
+    bool loadTelemetry (const juce::File& file);
+
+    /** Closes the telemetry log, handing control back to the parameters. Call from the message thread
+    */
+    void clearTelemetry();
+
+    /** Returns the file of the open telemetry log, or a default File if there is none. Call from the message thread
+    */
+    juce::File getTelemetryFile() const;
+
+    /** Returns the memory used by each model of this instance, in the precision currently being processed
+    */
+    jr::MemoryFootprint getEngineFootprint() const { return isUsingDoublePrecision() ? doubleMachine.getEngineFootprint() : floatMachine.getEngineFootprint(); }
+    jr::MemoryFootprint getMotorFootprint() const { return isUsingDoublePrecision() ? doubleMachine.getMotorFootprint() : floatMachine.getMotorFootprint(); }
+    jr::MemoryFootprint getFanFootprint() const { return isUsingDoublePrecision() ? doubleMachine.getFanFootprint() : floatMachine.getFanFootprint(); }
+
+    /** Returns the memory used by the whole instance: the processor object (which holds the models) and its arena
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), arena.getSizeInBytes() }; }
+
 private:
-    
-    ElectricMotorDC motor;
-    FanPropeller fan;
-    Engine engine;
 
+    /** Reads the current value of every parameter
+    */
+    MachineParams getParams() const;
+
+    /** Updates the MIDI controls from a message: any held note switches the machine on, the mod wheel (CC 1) adds to the engine revs and
+    pitch bend scales the motor max speed by up to an octave either way
+    * @param message - MIDI message
+    */
+    void handleMidiMessage (const juce::MidiMessage& message);
+
+    /** Returns a set of parameter values with the MIDI controls applied
+    * @param params - values read from the parameters
+    */
+    MachineParams applyMidiControls (MachineParams params) const;
+
+    /** Makes a telemetry log the active one and deletes the previous log once the audio thread has finished with it
+    * @param newTelemetry - log to use, or nullptr for none
+    */
+    void swapTelemetry (std::unique_ptr<jr::TelemetryLog> newTelemetry);
+
+    /** Sizes the arena for a machine and prepares it
+    * @param machine - float or double machine
+    * @param sampleRate - sample rate, Hz
+    */
+    template <typename SampleType>
+    void prepareMachine (Machine<SampleType>& machine, double sampleRate);
+
+    /** Renders a block of audio from a machine, splitting it at each MIDI event so that events take effect on the right sample,
+    and at each telemetry frame while a telemetry log is open and the host is playing
+    * @param machine - float or double machine, matching the buffer
+    * @param buffer - buffer to write output to
+    * @param midiMessages - MIDI events for the block
+    */
+    template <typename SampleType>
+    void processMachine (Machine<SampleType>& machine, juce::AudioBuffer<SampleType>& buffer, const juce::MidiBuffer& midiMessages);
+
+    static constexpr int stemBusIndex{ 1 };    // index of the first stem output bus (engine, then motor, then fan)
+
+    /** Performance controls received over MIDI, applied on top of the parameters
+    */
+    struct MidiControls
+    {
+        std::array<bool, 128> heldNotes{};  // true for each note number currently held
+        int numNotesHeld{};                 // number of notes held, the machine is on while any note is held
+        float revs{};                       // engine revs from the mod wheel, added to the revs parameter (0-1)
+        float speedScale{ 1.0f };           // motor max speed multiplier from pitch bend (0.5-2)
+    };
+
+private:
+    
+    jr::MemoryArena arena;              // holds all delay buffers for the models, sized in prepareToPlay()
+    std::atomic<bool> compactDelayStorage{ false };    // true to store long delay lines as 16-bit fixed point, applied in prepareToPlay()
+    Machine<float> floatMachine;        // models used when the host processes in single precision
+    Machine<double> doubleMachine;      // models used when the host processes in double precision
+    MidiControls midiControls;          // controls received over MIDI, only used on the audio thread
+    MachineOutputRouting outputRouting; // channel of the main output for each source, set in prepareToPlay()
 
-    bool isPlaying{ false };            // true if start trigger/switch is on
-    float gainVal{};                    // current master gain value
-    float motorMaxSpeedVal{};           // current motor max speed value
-    juce::SmoothedValue<float> smoothedGain; // smoothed gain value
-    juce::SmoothedValue<float> smoothedMaxSpeed; // smoothed motor max speed value
+    std::atomic<jr::TelemetryLog*> activeTelemetry{ nullptr };     // telemetry log in use, owned here and swapped on the message thread
+    std::atomic<bool> isReadingTelemetry{ false };                  // true while the audio thread may be using activeTelemetry
 
     juce::AudioProcessorValueTreeState parameters;
 
@@ -108,6 +218,11 @@ private:
     std::atomic<float>* engineOT2Param;
     std::atomic<float>* engineOT3Param;
 
+    //===================== Input Parameters ======================//
+
+    std::atomic<float>* inputModeParam;
+    std::atomic<float>* inputGainParam;
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MechanicalModellingAudioProcessor)
 };
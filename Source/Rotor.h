@@ -1,7 +1,11 @@
 #pragma once
+#include "jr_StateVariableFilter.h"     // used for jr::StateVariableFilter
+#include "jr_MemoryArena.h"            // used for jr::MemoryFootprint
+#include "jr_Snapshot.h"               // used for jr::SnapshotWriter / SnapshotReader
 
 /** A class that represents the physical model of an electric brush used in an electric DC motor that produces noise each time it makes a contact
 */
+template <typename SampleType>
 class Brush
 {
 public:
@@ -9,41 +13,71 @@ public:
 	/** Sets sample rate
 	* @param sr - sample rate, Hz
 	*/
-	void setSampleRate (float sr) { sampleRate = sr; }
+	void setSampleRate (SampleType sr) { bpFilter.setSampleRate (sr); bpFilter.setResonance (1.0); }
 
 	/** Sets the cutoff frequency of the band-pass filter
 	* @param freq - cutoff frequency, Hz
 	*/
-	void setFilterFrequency (float freq) { filterFreq = freq; }
+	void setFilterFrequency (SampleType freq) { filterFreq = freq; }
 
 	/** Sets the level of the brush by controlling the volume of the noise (0-1)
 	* @param levelIn - volume level (0-1)
 	*/
-	void setLevel (float levelIn) { level = levelIn; }
+	void setLevel (SampleType levelIn) { level = levelIn; }
+
+	/** Seeds the noise generator, so that renders can be repeated exactly
+	* @param seed - seed value
+	*/
+	void setRandomSeed (juce::int64 seed) { random.setSeed (seed); }
 
 	/** returns the next sample value for the brush
 	* @return sampleOut
 	*/
-	float process()
+	SampleType process()
 	{
-		float whiteNoise = 2.0 * (random.nextFloat() - 0.5);	// white noise val between -1 and 1
+		SampleType whiteNoise = 2.0 * (random.nextFloat() - 0.5);	// white noise val between -1 and 1
+
+		// the state variable filter follows a sweeping frequency without being redesigned
+		if (filterFreq != bpFilterFreq)
+		{
+			bpFilter.setCutoff (filterFreq);
+			bpFilterFreq = filterFreq;
+		}
 
-		bpFilter.setCoefficients (juce::IIRCoefficients::makeBandPass (sampleRate, filterFreq, 1.0));
+		return bpFilter.processSample (whiteNoise, jr::SVFType::BAND_PASS) * level;
+	}
 
-		return bpFilter.processSingleSampleRaw (whiteNoise) * level;
+	/** Writes the noise generator, filter and settings to a snapshot
+	* @param writer - snapshot writer
+	*/
+	void saveState (jr::SnapshotWriter& writer) const
+	{
+		bpFilter.saveState (writer);
+		writer.write (random, filterFreq, level);
+	}
+
+	/** Reads the noise generator, filter and settings from a snapshot
+	* @param reader - snapshot reader
+	*/
+	void loadState (jr::SnapshotReader& reader)
+	{
+		bpFilter.loadState (reader);
+		reader.read (random, filterFreq, level);
+		bpFilterFreq = -1;
 	}
 
 private:
-	float sampleRate;
 	juce::Random random;
-	juce::IIRFilter bpFilter;
-	float filterFreq{ 4000.0 };
-	float level{};
+	jr::StateVariableFilter<SampleType> bpFilter;
+	SampleType filterFreq{ 4000.0 };
+	SampleType bpFilterFreq{ -1 };	// frequency the filter is set to, -1 to set it on the next sample
+	SampleType level{};
 };
 
 /** A class that is a physical model of the rotor component of an electrical DC motor, consisting of a brush causing clicks, and the DC of the rotor itself, all enveloped by the 4th power of the driving phasor
 * use setSampleRate() before use, and setBrushLevel() and setRotorLevel() to control the volume of the two components
 */
+template <typename SampleType>
 class Rotor
 {
 public:
@@ -51,31 +85,36 @@ public:
 	/** Sets the sample rate
 	* @param sr - sample rate, Hz
 	*/
-	void setSampleRate (float sr) { brush.setSampleRate (sr); }
+	void setSampleRate (SampleType sr) { brush.setSampleRate (sr); }
 
 	/** Sets the output volume of the brush component
 	* @param brushLevel - volume value (0-1)
 	*/
-	void setBrushLevel (float brushLevel) { brush.setLevel (brushLevel); }
+	void setBrushLevel (SampleType brushLevel) { brush.setLevel (brushLevel); }
 
 	/** Sets the output volume of the rotor component's DC signal
 	* @param rotorLevelIn - volume value (0-1)
 	*/
-	void setRotorLevel (float rotorLevelIn) { rotorLevel = rotorLevelIn; }
+	void setRotorLevel (SampleType rotorLevelIn) { rotorLevel = rotorLevelIn; }
 
 	/** Sets the cutoff frequency value for the Band Pass Filter in the brush component
 	* @param freq - cutoff frequency, Hz
 	*/
-	void setBrushFreqeuncy (float freq) { brush.setFilterFrequency (freq); }
+	void setBrushFreqeuncy (SampleType freq) { brush.setFilterFrequency (freq); }
+
+	/** Seeds the brush's noise generator, so that renders can be repeated exactly
+	* @param seed - seed value
+	*/
+	void setRandomSeed (juce::int64 seed) { brush.setRandomSeed (seed); }
 
 	/** Returns the next sample value of the rotor component, synched to the input value of the driving phasor signal
 	* @param phasorVal - current sample value for the driving phasor signal that controls the motor system
 	* @return output - next sample value out for the rotor component
 	*/
-	float process (float phasorVal)
+	SampleType process (SampleType phasorVal)
 	{
-		float brushOut = brush.process();
-		float output = brushOut + rotorLevel;
+		SampleType brushOut = brush.process();
+		SampleType output = brushOut + rotorLevel;
 
 		currentEnvVal = envelopeVal (phasorVal);
 
@@ -84,23 +123,46 @@ public:
 
 	//=========== accessors =============//
 
-	float getRotorLevel() { return rotorLevel; }
+	SampleType getRotorLevel() { return rotorLevel; }
+
+	SampleType getCurrentEnvVal() { return currentEnvVal; }
+
+	/** Writes the state of the rotor and its brush to a snapshot
+	* @param writer - snapshot writer
+	*/
+	void saveState (jr::SnapshotWriter& writer) const
+	{
+		brush.saveState (writer);
+		writer.write (rotorLevel, currentEnvVal);
+	}
 
-	float getCurrentEnvVal() { return currentEnvVal; }
+	/** Reads the state of the rotor and its brush from a snapshot
+	* @param reader - snapshot reader
+	*/
+	void loadState (jr::SnapshotReader& reader)
+	{
+		brush.loadState (reader);
+		reader.read (rotorLevel, currentEnvVal);
+	}
+
+	/** Returns the memory used by the rotor, including its brush
+	*/
+	jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
 
 private:
-	Brush brush;			// brush component, that makes noise each time it comes into contact with material whilst the motor spins
-	float rotorLevel{};		// volume level of the rotor components DC, used as a constant signal value
-	float currentEnvVal{};	// current value of the envelope
+	Brush<SampleType> brush;	// brush component, that makes noise each time it comes into contact with material whilst the motor spins
+	SampleType rotorLevel{};	// volume level of the rotor components DC, used as a constant signal value
+	SampleType currentEnvVal{};	// current value of the envelope
 
 private:
 
 	/** Returns the 4th power of the phasor signal in, creating the desired envelope synced to the phasor
 	* @return currentEnvelopeValue
 	*/
-	float envelopeVal (float phasorValIn)
+	SampleType envelopeVal (SampleType phasorValIn)
 	{
-		return pow (phasorValIn, 4);
+		SampleType squared = phasorValIn * phasorValIn;
+		return squared * squared;
 	}
 
 };
\ No newline at end of file
@@ -9,50 +9,54 @@
 */
 
 #pragma once
-#include "jr_PolyBLEP_Oscillators.h"        // used for jr::Oscillator
+#include <cmath>                            // used for std::cos()
+#include "jr_MemoryArena.h"                 // used for jr::MemoryFootprint
+#include "jr_Snapshot.h"                    // used for jr::SnapshotWriter / SnapshotReader
 
-/** A physical model of the stator that surrounds an electric DC motor and resonates with the spinning motor
+/** A physical model of the stator that surrounds an electric DC motor and resonates with the spinning motor.
+The stator turns at 1/4 the speed of the motor's driving phasor, so its phase is derived from that phasor (see ElectricMotorDC) rather than run by an oscillator of its own
 */
+template <typename SampleType>
 class Stator
 {
 public:
 
-    Stator() { phasor.setMode (jr::Oscillator::OscillatorMode::SAW); }
-
-    /** Sets the sample rate
-    * @param sr - sample rate, Hz
-    */
-    void setSampleRate (float sr) 
-    { 
-        phasor.setSampleRate (sr);
-        phasor.setMuted (false);
-    }
-    
     /** Sets the stator level
     * @param level - volume level of the stator component (0-1)
     */
-    void setStatorLevel (float level) { statorLevel = level; }
+    void setStatorLevel (SampleType level) { statorLevel = level; }
 
     /** returns the next sample out value for the stator
-    * @param freq - current frequency of the driving phasor
+    * @param statorPhase - current phase of the stator (0-1), turning at 1/4 the frequency of the driving phasor
     */
-    float process (float freq)
+    SampleType process (SampleType statorPhase)
     {
-        phasor.setFrequency (freq / 4.0);
-
-        float output{};
-
-        output = phasor.processSingleSample() + 1.0;
+        // a sawtooth at twice the stator's speed, 0-1
+        SampleType output = 2 * statorPhase;
 
         if (output >= 1)
             output -= 1;
 
-        output = (1.0 / (pow (cos (output), 2) + 1.0)) - 0.5;
+        SampleType cosine = std::cos (output);
+        output = ((SampleType) 1 / ((cosine * cosine) + 1)) - (SampleType) 0.5;
 
         return output * statorLevel;
     }
 
+    /** Writes the stator's level to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const { writer.write (statorLevel); }
+
+    /** Reads the stator's level from a snapshot
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader) { reader.read (statorLevel); }
+
+    /** Returns the memory used by the stator
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
+
 private:
-    float statorLevel{};        // volume level out of stator (0-1)
-    jr::Oscillator phasor;      // phasor that controls the resonating, set to 1/4 frequency of driving phasor of the motor
+    SampleType statorLevel{};           // volume level out of stator (0-1)
 };
\ No newline at end of file
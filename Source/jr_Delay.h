@@ -9,45 +9,272 @@
 #pragma once
 
 #include <cmath>        // included for floor()
+#include <limits>       // used for std::numeric_limits
 #include <JuceHeader.h>
+#include "jr_MemoryArena.h"     // used for jr::MemoryArena
+#include "jr_Snapshot.h"        // used for jr::SnapshotWriter / SnapshotReader
+
+namespace jr {
+
+    /** Sample format used to store a delay buffer: full precision samples, or 16-bit fixed point at half (float) or a quarter (double) of the memory
+    (suited to smooth, control-like signals such as a driving phasor or filtered noise)
+    */
+    enum class DelayStorage {
+        FULL_PRECISION = 0,
+        FIXED16
+    };
+
+    /** The circular buffer behind the delay classes, held in a jr::MemoryArena in either full precision or compact 16-bit fixed point format.
+    Values are converted on write() and read(), so the delay classes behave the same whichever format is used. The block versions of write and read
+    convert a run of samples in one loop the compiler can vectorise, giving exactly the values of the single sample versions.
+    */
+    template <typename SampleType>
+    class DelayBuffer
+    {
+    public:
+
+        /** Returns the number of bytes of arena memory a buffer needs
+        * @param numSamples - buffer length, samples
+        * @param storageType - sample format
+        */
+        static size_t getRequiredMemory (int numSamples, DelayStorage storageType)
+        {
+            if (storageType == DelayStorage::FIXED16)
+                return MemoryArena::getRequiredBytes<juce::int16> (numSamples);
+
+            return MemoryArena::getRequiredBytes<SampleType> (numSamples);
+        }
+
+        /** Takes the buffer from the arena and clears it
+        * @param numSamplesIn - buffer length, samples
+        * @param storageType - sample format
+        * @param range - largest magnitude that can be stored in FIXED16 format (larger values are clipped), ignored for FULL_PRECISION
+        * @param arena - arena with room for getRequiredMemory() bytes
+        */
+        void prepare (int numSamplesIn, DelayStorage storageType, SampleType range, MemoryArena& arena)
+        {
+            numSamples = numSamplesIn;
+            storage = storageType;
+            fixedRange = range;
+            toFixed = (SampleType) 32767 / range;
+            fromFixed = range / (SampleType) 32767;
+
+            if (storage == DelayStorage::FIXED16)
+            {
+                fixedData = arena.allocate<juce::int16> (numSamples);
+                sampleData = nullptr;
+            }
+            else
+            {
+                sampleData = arena.allocate<SampleType> (numSamples);
+                fixedData = nullptr;
+            }
+
+            clear();
+        }
+
+        /** Returns the sample at an index
+        */
+        SampleType read (int index) const
+        {
+            if (storage == DelayStorage::FIXED16)
+                return (SampleType) fixedData[index] * fromFixed;
+
+            return sampleData[index];
+        }
+
+        /** Reads a run of samples from consecutive indices
+        * @param index - first index read (the run must not pass the end of the buffer)
+        * @param dest - array to write the samples to
+        * @param numSamplesToRead - number of samples
+        */
+        void read (int index, SampleType* dest, int numSamplesToRead) const
+        {
+            if (storage == DelayStorage::FIXED16)
+            {
+                const juce::int16* source = fixedData + index;
+                SampleType scale = fromFixed;
+
+                for (int i = 0; i < numSamplesToRead; i++)
+                    dest[i] = (SampleType) source[i] * scale;
+            }
+            else
+            {
+                juce::FloatVectorOperations::copy (dest, sampleData + index, numSamplesToRead);
+            }
+        }
+
+        /** Writes a sample to an index
+        */
+        void write (int index, SampleType sample)
+        {
+            if (storage == DelayStorage::FIXED16)
+                fixedData[index] = convertToFixed (sample, fixedRange, toFixed);
+            else
+                sampleData[index] = sample;
+        }
+
+        /** Writes a run of samples to consecutive indices in reverse order, the first sample to the highest index, which is the order jr::DelayLine writes in
+        * @param index - lowest index written (the run must not pass the end of the buffer)
+        * @param source - samples to write
+        * @param numSamplesToWrite - number of samples
+        */
+        void writeReversed (int index, const SampleType* source, int numSamplesToWrite)
+        {
+            if (storage == DelayStorage::FIXED16)
+            {
+                juce::int16* dest = fixedData + index;
+                SampleType range = fixedRange, scale = toFixed;
+
+                for (int i = 0; i < numSamplesToWrite; i++)
+                    dest[numSamplesToWrite - 1 - i] = convertToFixed (source[i], range, scale);
+            }
+            else
+            {
+                SampleType* dest = sampleData + index;
+
+                for (int i = 0; i < numSamplesToWrite; i++)
+                    dest[numSamplesToWrite - 1 - i] = source[i];
+            }
+        }
+
+        /** Sets every sample to 0
+        */
+        void clear()
+        {
+            if (fixedData != nullptr)
+                std::fill (fixedData, fixedData + numSamples, (juce::int16) 0);
+
+            if (sampleData != nullptr)
+                juce::FloatVectorOperations::clear (sampleData, numSamples);
+        }
+
+        /** Returns the number of bytes the buffer occupies in the arena, or 0 if it hasn't been prepared
+        */
+        size_t getNumBytes() const
+        {
+            if (sampleData == nullptr && fixedData == nullptr)
+                return 0;
+
+            return getRequiredMemory (numSamples, storage);
+        }
+
+        /** Writes the buffer contents to a snapshot, in the buffer's storage format
+        */
+        void saveState (SnapshotWriter& writer) const
+        {
+            writer.write (numSamples, storage);
+            writer.writeBytes (getStorage(), getBytesInUse());
+        }
+
+        /** Reads the buffer contents from a snapshot. Fails the reader if the snapshot was taken from a buffer of a different size or format
+        */
+        void loadState (SnapshotReader& reader)
+        {
+            int savedNumSamples{};
+            DelayStorage savedStorage{};
+            reader.read (savedNumSamples, savedStorage);
+
+            if (savedNumSamples != numSamples || savedStorage != storage)
+            {
+                reader.fail();
+                return;
+            }
+
+            reader.readBytes (getStorage(), getBytesInUse());
+        }
+
+    private:
+        /** Returns a sample in FIXED16 format, clipped to the range and rounded to the nearest step with ties to even, as std::lrint() rounds.
+        Adding and taking away 1.5 * 2 ^ (mantissa bits) does the rounding without a library call, so loops of it vectorise (this needs strict floating point, not fast-math)
+        * @param sample - sample to convert
+        * @param range - largest magnitude stored
+        * @param scale - scale from SampleType to FIXED16
+        */
+        static juce::int16 convertToFixed (SampleType sample, SampleType range, SampleType scale)
+        {
+            constexpr SampleType roundingOffset = (SampleType) 1.5 * (SampleType) (1LL << (std::numeric_limits<SampleType>::digits - 1));
+            SampleType scaled = juce::jlimit (-range, range, sample) * scale;
+
+            return (juce::int16) (int) ((scaled + roundingOffset) - roundingOffset);
+        }
+
+        /** Returns the buffer memory in its current format
+        */
+        void* getStorage() const
+        {
+            if (storage == DelayStorage::FIXED16)
+                return fixedData;
+
+            return sampleData;
+        }
+
+        /** Returns the number of bytes of the buffer holding samples (without the arena's alignment padding)
+        */
+        size_t getBytesInUse() const
+        {
+            if (getStorage() == nullptr)
+                return 0;
+
+            return (size_t) numSamples * (storage == DelayStorage::FIXED16 ? sizeof (juce::int16) : sizeof (SampleType));
+        }
+
+    private:
+        SampleType* sampleData{ nullptr };                      // FULL_PRECISION buffer (owned by the arena)
+        juce::int16* fixedData{ nullptr };                      // FIXED16 buffer (owned by the arena)
+        int numSamples{};                                       // buffer length, samples
+        DelayStorage storage{ DelayStorage::FULL_PRECISION };   // current sample format
+        SampleType fixedRange{ 1 };                             // largest magnitude stored in FIXED16 format
+        SampleType toFixed{ 32767 };                            // scale from SampleType to FIXED16
+        SampleType fromFixed{ (SampleType) 1 / 32767 };         // scale from FIXED16 to SampleType
+    };
+}
 
 /**
 A delay class using a Fractional Delay Line for smoother delay time variation. Use setSampleRate(), setSize() and setDelayTime() before use - the call process() each sample for output
+* @tparam SampleType - float or double
 */
+template <typename SampleType>
 class FractionalDelay
 {
 public:
     /**
-    * Destructor, releases buffer memory on instance destruction
+    * sets the sample rate
     * 
-    * @return
+    * @param sr - sample rate, Hz
     */
-    ~FractionalDelay()
+    void setSampleRate (SampleType sr)
     {
-        delete[] buffer;
+        sampleRate = sr;
     }
 
     /**
-    * sets the sample rate
-    * 
+    * returns the number of bytes of arena memory needed by setSize() for a given sample rate and maximum delay time
+    *
     * @param sr - sample rate, Hz
+    * @param maxDelayTime - maximum delay time/length, seconds
+    * @return numBytes - size of the delay buffer in the arena
     */
-    void setSampleRate (float sr)
+    static size_t getRequiredMemory (SampleType sr, SampleType maxDelayTime, jr::DelayStorage storage = jr::DelayStorage::FULL_PRECISION)
     {
-        sampleRate = sr;
+        return jr::DelayBuffer<SampleType>::getRequiredMemory (sizeInSamples (sr, maxDelayTime), storage);
     }
 
     /**
-    * sets the size of the delay buffer, which is effectively the maximum possible delay time
+    * sets the size of the delay buffer, which is effectively the maximum possible delay time, taking the buffer from the arena
     *
     * @param maxDelayTime - maximum delay time/length, seconds
+    * @param arena - arena prepared with room for getRequiredMemory() bytes
+    * @param storage - sample format of the buffer
+    * @param range - largest magnitude stored when using FIXED16 storage
     */
-    void setSize (float maxDelayTime)
+    void setSize (SampleType maxDelayTime, jr::MemoryArena& arena, jr::DelayStorage storage = jr::DelayStorage::FULL_PRECISION, SampleType range = 1)
     {
-        if (maxDelayTime < 0.01) size = 0.01 * sampleRate;
-        else                     size = maxDelayTime * sampleRate;
-        buffer = new float[size];
+        size = sizeInSamples (sampleRate, maxDelayTime);
+        buffer.prepare (size, storage, range, arena);
 
+        readPos = 0;
+        writePos = 0;
         clearBuffer();
     }
 
@@ -56,7 +283,7 @@ public:
     * 
     * @param delayTime - delay time, seconds
     */
-    void setDelayTime (float delayTime)
+    void setDelayTime (SampleType delayTime)
     {
         delayTimeInSamples = delayTime * sampleRate;
 
@@ -70,7 +297,7 @@ public:
     *
     * @param delayTimeInSamplesIn - delay time, samples
     */
-    void setDelayTimeInSamples (float delayTimeInSamplesIn)
+    void setDelayTimeInSamples (SampleType delayTimeInSamplesIn)
     {
         delayTimeInSamples = delayTimeInSamplesIn;
 
@@ -84,7 +311,7 @@ public:
     *
     * @param feedback - feedback amount, (0 - 1)
     */
-    void setFeedback (float feedback)
+    void setFeedback (SampleType feedback)
     {
         if (feedback > 1) feedbackAmt = 1;
         if (feedback < 0) feedbackAmt = 0;
@@ -95,7 +322,7 @@ public:
     * Sets the wet mix of the delay (0 = dry signal only, 1 = wet signal only)
     * @param mix - wet/dry mix (0-1)
     */
-    void setWetMix (float mix)
+    void setWetMix (SampleType mix)
     {
         if (mix > 1) wetMix = 1;
         if (mix < 0) wetMix = 0;
@@ -109,9 +336,9 @@ public:
     * @param drySignal - current sample value for the incoming dry signal
     * @return nextSample - next sample value of wet/dry mixed signal
     */
-    float process (float drySignal)
+    SampleType process (SampleType drySignal)
     {
-        float output = readVal();
+        SampleType output = readVal();
 
         writeVal ((output * feedbackAmt) + drySignal);
 
@@ -123,9 +350,9 @@ public:
     * 
     * @return readV - sample value for readPos
     */
-    float readVal()
+    SampleType readVal()
     {
-        float readV = linearInterpolation (readPos);
+        SampleType readV = linearInterpolation (readPos);
 
         readPos++;
 
@@ -142,9 +369,9 @@ public:
     * 
     * @param sampleIn - sample value to be written into delay buffer
     */
-    void writeVal (float sampleIn)
+    void writeVal (SampleType sampleIn)
     {
-        buffer[writePos] = sampleIn;
+        buffer.write (writePos, sampleIn);
 
         writePos++;
 
@@ -153,14 +380,43 @@ public:
     }
 
     /**
-    * sets all buffer values to 0.0f
+    * sets all buffer values to 0
     */
     void clearBuffer()
     {
-        for (int i = 0; i < size; i++)
-        {
-            buffer[i] = 0.0f;
-        }
+        buffer.clear();
+    }
+
+    /**
+    * returns the memory used by the delay, including its buffer in the arena
+    *
+    * @return footprint
+    */
+    jr::MemoryFootprint getMemoryFootprint() const
+    {
+        return { sizeof (*this), buffer.getNumBytes() };
+    }
+
+    /**
+    * writes the delay's buffer, positions and settings to a snapshot
+    *
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        buffer.saveState (writer);
+        writer.write (delayTimeInSamples, feedbackAmt, readPos, writePos, wetMix);
+    }
+
+    /**
+    * reads the delay's buffer, positions and settings from a snapshot
+    *
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        buffer.loadState (reader);
+        reader.read (delayTimeInSamples, feedbackAmt, readPos, writePos, wetMix);
     }
 
     /**
@@ -169,7 +425,7 @@ public:
     * @param readPosIn - index value to be evaluated
     * @return interpolatedSample - the interpolated sample value that correlates to _readPos
     */
-    float linearInterpolation (float readPosIn)
+    SampleType linearInterpolation (SampleType readPosIn)
     {
         int indexA = floor (readPosIn);
         int indexB = indexA + 1;
@@ -180,20 +436,252 @@ public:
         jassert(indexA >= 0 && indexA <= size);
         jassert(indexB >= 0 && indexB <= size);
 
-        float remainder = readPosIn - indexA;
+        SampleType remainder = readPosIn - indexA;
 
-        float interpolatedSample = (remainder * buffer[indexB]) + ((1 - remainder) * buffer[indexA]);
+        SampleType interpolatedSample = (remainder * buffer.read (indexB)) + ((1 - remainder) * buffer.read (indexA));
 
         return interpolatedSample;
     }
 
 private:
-    float sampleRate;            // sample rate, Hz
-    float* buffer;               // delay buffer, array of floats
-    int size;                    // size of delay buffer in samples (maximum delay length in samples)
-    float delayTimeInSamples;    // current delay time/length in samples
-    float feedbackAmt{ 0.0f };   // feedback amount (0 - 1), amount of wet signal fed back through the delay line
-    float readPos{ 0.0f };       // index of delay buffer array where output is currently being output from
+    /**
+    * returns the buffer size in samples for a maximum delay time (minimum of 10ms)
+    */
+    static int sizeInSamples (SampleType sr, SampleType maxDelayTime)
+    {
+        if (maxDelayTime < 0.01) return 0.01 * sr;
+        else                     return maxDelayTime * sr;
+    }
+
+private:
+    SampleType sampleRate;            // sample rate, Hz
+    jr::DelayBuffer<SampleType> buffer;// delay buffer (owned by the arena passed to setSize())
+    int size{};                  // size of delay buffer in samples (maximum delay length in samples)
+    SampleType delayTimeInSamples;    // current delay time/length in samples
+    SampleType feedbackAmt{ 0 };   // feedback amount (0 - 1), amount of wet signal fed back through the delay line
+    SampleType readPos{ 0 };       // index of delay buffer array where output is currently being output from
     int writePos{ 0 };           // index of delay buffer array where delayed signal is currently being written to
-    float wetMix{ 0.33f };       // dry/wet mix of wet signal vs. dry signal, 0 = only dry, 1 = only wet
-};
\ No newline at end of file
+    SampleType wetMix{ (SampleType) 0.33 };       // dry/wet mix of wet signal vs. dry signal, 0 = only dry, 1 = only wet
+};
+
+namespace jr {
+
+    /** A mono delay line with linear interpolation whose buffer lives in a jr::MemoryArena. Behaves the same as
+    juce::dsp::DelayLine<SampleType, Linear>: pushSample() writes the newest sample, popSample() reads the sample 'delay' samples behind it.
+    Use getRequiredMemory() to size the arena, then prepare() before use.
+    */
+    template <typename SampleType>
+    class DelayLine
+    {
+    public:
+
+        /** Returns the number of bytes of arena memory needed for a maximum delay length
+        * @param maxDelayInSamples - maximum delay, samples
+        */
+        static size_t getRequiredMemory (int maxDelayInSamples, DelayStorage storage = DelayStorage::FULL_PRECISION)
+        {
+            return DelayBuffer<SampleType>::getRequiredMemory (bufferSize (maxDelayInSamples), storage);
+        }
+
+        /** Sets the maximum delay length and takes the buffer from the arena, clearing the delay line
+        * @param maxDelayInSamples - maximum delay, samples
+        * @param arena - arena prepared with room for getRequiredMemory() bytes
+        * @param storage - sample format of the buffer
+        * @param range - largest magnitude stored when using FIXED16 storage
+        */
+        void prepare (int maxDelayInSamples, jr::MemoryArena& arena, DelayStorage storage = DelayStorage::FULL_PRECISION, SampleType range = 1)
+        {
+            totalSize = bufferSize (maxDelayInSamples);
+            buffer.prepare (totalSize, storage, range, arena);
+            reset();
+        }
+
+        /** Returns the memory used by the delay line, including its buffer in the arena
+        */
+        MemoryFootprint getMemoryFootprint() const
+        {
+            return { sizeof (*this), buffer.getNumBytes() };
+        }
+
+        /** Writes the buffer, positions and delay to a snapshot
+        */
+        void saveState (SnapshotWriter& writer) const
+        {
+            buffer.saveState (writer);
+            writer.write (writePos, readPos, delay, delayInt, delayFrac);
+        }
+
+        /** Reads the buffer, positions and delay from a snapshot
+        */
+        void loadState (SnapshotReader& reader)
+        {
+            buffer.loadState (reader);
+            reader.read (writePos, readPos, delay, delayInt, delayFrac);
+        }
+
+        /** Clears the buffer and resets read/write positions
+        */
+        void reset()
+        {
+            writePos = 0;
+            readPos = 0;
+
+            buffer.clear();
+        }
+
+        /** Sets the delay length
+        * @param delayInSamples - delay, samples (0 to the maximum set in prepare())
+        */
+        void setDelay (SampleType delayInSamples)
+        {
+            auto upperLimit = (SampleType) (totalSize - 2);
+            jassert (delayInSamples >= 0 && delayInSamples <= upperLimit);
+
+            delay = juce::jlimit ((SampleType) 0, upperLimit, delayInSamples);
+            delayInt = (int) std::floor (delay);
+            delayFrac = delay - (SampleType) delayInt;
+        }
+
+        /** Writes a new sample into the delay line
+        * @param sample - sample value in
+        */
+        void pushSample (SampleType sample)
+        {
+            buffer.write (writePos, sample);
+            writePos = (writePos + totalSize - 1) % totalSize;
+        }
+
+        /** Returns the interpolated sample at the current delay
+        * @param delayInSamples - new delay in samples, or a negative value to keep the current delay
+        * @param updateReadPointer - true to move the read position on, false to allow several reads per pushed sample
+        * @return sampleOut
+        */
+        SampleType popSample (SampleType delayInSamples = -1, bool updateReadPointer = true)
+        {
+            if (delayInSamples >= 0)
+                setDelay (delayInSamples);
+
+            auto index1 = readPos + delayInt;
+            auto index2 = index1 + 1;
+
+            if (index2 >= totalSize)
+            {
+                index1 %= totalSize;
+                index2 %= totalSize;
+            }
+
+            auto value1 = buffer.read (index1);
+            auto value2 = buffer.read (index2);
+
+            if (updateReadPointer)
+                readPos = (readPos + totalSize - 1) % totalSize;
+
+            return value1 + delayFrac * (value2 - value1);
+        }
+
+        /** Reads several taps at once and moves the read position on, giving the same values as a popSample() call per tap with only
+        the last moving the read position. The current delay (see setDelay()) is left unchanged
+        * @param delaysInSamples - delay of each tap, samples (0 to the maximum set in prepare())
+        * @param dest - array to write the interpolated sample of each tap to
+        * @param numTaps - number of taps
+        */
+        void popSamples (const SampleType* delaysInSamples, SampleType* dest, int numTaps)
+        {
+            auto upperLimit = (SampleType) (totalSize - 2);
+
+            for (int tap = 0; tap < numTaps; tap++)
+            {
+                auto tapDelay = juce::jlimit ((SampleType) 0, upperLimit, delaysInSamples[tap]);
+                auto tapDelayInt = (int) tapDelay;
+
+                // the delay is below the buffer length, so one wrap is enough
+                auto index1 = readPos + tapDelayInt;
+                index1 -= index1 >= totalSize ? totalSize : 0;
+                auto index2 = index1 + 1;
+                index2 -= index2 >= totalSize ? totalSize : 0;
+
+                auto value1 = buffer.read (index1);
+                auto value2 = buffer.read (index2);
+
+                dest[tap] = value1 + (tapDelay - (SampleType) tapDelayInt) * (value2 - value1);
+            }
+
+            readPos = (readPos + totalSize - 1) % totalSize;
+        }
+
+        /** Writes a block of samples, leaving the buffer as a pushSample() call for each would. Each run up to the start of the buffer is converted in one loop
+        * @param samples - samples to write, oldest first
+        * @param numSamples - number of samples
+        */
+        void pushSamples (const SampleType* samples, int numSamples)
+        {
+            while (numSamples > 0)
+            {
+                // the write position moves backwards, so a run ends at index 0
+                int runLength = juce::jmin (numSamples, writePos + 1);
+                buffer.writeReversed (writePos - runLength + 1, samples, runLength);
+
+                writePos = (writePos - runLength + totalSize) % totalSize;
+                samples += runLength;
+                numSamples -= runLength;
+            }
+        }
+
+        /** Reads a block at one delay after a block has been written with pushSamples(), for a delay line read once per sample written.
+        Gives, for each sample of the block, the value popSample() would have returned straight after that sample's pushSample(). The read position
+        is left where it was, so several delays can be read from the same block - call skipSamples() once they have all been read
+        * @param delayInSamples - delay, samples (0 to the maximum set in prepare(), less the block length)
+        * @param dest - array to write the interpolated sample for each sample of the block to
+        * @param numSamples - number of samples in the block written
+        */
+        void readBlock (SampleType delayInSamples, SampleType* dest, int numSamples) const
+        {
+            auto blockDelay = juce::jlimit ((SampleType) 0, (SampleType) (totalSize - 2), delayInSamples);
+            auto blockDelayInt = (int) blockDelay;
+            auto blockDelayFrac = blockDelay - (SampleType) blockDelayInt;
+            jassert (blockDelayInt + numSamples <= totalSize - 1);
+
+            SampleType values[readChunkSize + 1];
+
+            for (int chunkStart = 0; chunkStart < numSamples; chunkStart += readChunkSize)
+            {
+                int chunkLength = juce::jmin (readChunkSize, numSamples - chunkStart);
+
+                // sample j reads index readPos - j + blockDelayInt and the one after it, so a chunk reads one run of chunkLength + 1 values, last sample first
+                int firstIndex = (readPos - (chunkStart + chunkLength - 1) + blockDelayInt + totalSize) % totalSize;
+                int runLength = juce::jmin (chunkLength + 1, totalSize - firstIndex);
+                buffer.read (firstIndex, values, runLength);
+                buffer.read (0, values + runLength, chunkLength + 1 - runLength);
+
+                for (int j = 0; j < chunkLength; j++)
+                {
+                    auto value1 = values[chunkLength - 1 - j];
+                    auto value2 = values[chunkLength - j];
+
+                    dest[chunkStart + j] = value1 + blockDelayFrac * (value2 - value1);
+                }
+            }
+        }
+
+        /** Moves the read position on as a popSample() call for each of a number of samples would
+        * @param numSamples - number of samples
+        */
+        void skipSamples (int numSamples) { readPos = (readPos - (numSamples % totalSize) + totalSize) % totalSize; }
+
+    private:
+        static constexpr int readChunkSize{ 64 };   // most samples readBlock() converts from the buffer at once
+
+        /** Returns the buffer length needed for a maximum delay, matching juce::dsp::DelayLine
+        */
+        static int bufferSize (int maxDelayInSamples) { return juce::jmax (4, maxDelayInSamples + 2); }
+
+    private:
+        DelayBuffer<SampleType> buffer; // delay buffer (owned by the arena passed to prepare())
+        int totalSize{ 4 };             // length of buffer in samples
+        int writePos{};                 // index the next sample is written to (moves backwards through the buffer)
+        int readPos{};                  // index of the most recently written sample for the current read
+        SampleType delay{};             // current delay, samples
+        int delayInt{};                 // integer part of delay
+        SampleType delayFrac{};         // fractional part of delay
+    };
+}
@@ -12,48 +12,75 @@
 
 //=========================== Constructors ==============================//
 
-Engine::Engine()
+template <typename SampleType>
+Engine<SampleType>::Engine()
 {
-    phasor.setMode (jr::Oscillator::OscillatorMode::SAW);
+    phasor.setMode (jr::Oscillator<SampleType>::OscillatorMode::SAW);
     phasor.setMuted (false);
-    setSampleRate (44100);
 }
 
 //========================= mutator functions ===========================//
 
-void Engine::setMappedParams (float gainIn, float speedIn, float aggressionIn, float widthIn, float lengthIn, float ot1LevelIn, float ot2LevelIn, float ot3LevelIn)
+template <typename SampleType>
+void Engine<SampleType>::setMappedParams (SampleType gainIn, SampleType speedIn, SampleType aggressionIn, SampleType widthIn, SampleType lengthIn, SampleType ot1LevelIn, SampleType ot2LevelIn, SampleType ot3LevelIn)
 {
-    float warpVal = 0.4 + (aggressionIn * 0.32);
-    float widthVal = 4 + (widthIn * 20.0f);
-    float lengthVal = 4 + (lengthIn * 20.0f);
-    float otL1 = 0.1 + (ot1LevelIn * 0.2);      // overtone level 1 mapped
-    float otL2 = 0.1 + (ot2LevelIn * 0.2);      // overtone level 2 mapped
-    float otL3 = 0.1 + (ot3LevelIn * 0.2);      // overtone level 3 mapped
-    setParams (gainIn, 0.6f, 30.0f, 0.2f, 0.8f, otL1, 55.0f, 0.6f, 0.2f, otL2, 75.0f, 0.85f, 0.5f, otL3, widthVal, widthVal, lengthVal, lengthVal, 0.35f, 50.0f, 0.5f, 50.0f, warpVal, 1.0f);
+    setMappedParams (gainIn, aggressionIn, widthIn, lengthIn, ot1LevelIn, ot2LevelIn, ot3LevelIn);
     setSpeed (speedIn);
 }
 
-void Engine::setSampleRate (float sr)
+template <typename SampleType>
+void Engine<SampleType>::setMappedParams (SampleType gainIn, SampleType aggressionIn, SampleType widthIn, SampleType lengthIn, SampleType ot1LevelIn, SampleType ot2LevelIn, SampleType ot3LevelIn)
+{
+    SampleType warpVal = 0.4 + (aggressionIn * 0.32);
+    SampleType widthVal = 4 + (widthIn * 20.0f);
+    SampleType lengthVal = 4 + (lengthIn * 20.0f);
+    SampleType otL1 = 0.1 + (ot1LevelIn * 0.2);      // overtone level 1 mapped
+    SampleType otL2 = 0.1 + (ot2LevelIn * 0.2);      // overtone level 2 mapped
+    SampleType otL3 = 0.1 + (ot3LevelIn * 0.2);      // overtone level 3 mapped
+    setParams (gainIn, 0.6f, 30.0f, 0.2f, 0.8f, otL1, 55.0f, 0.6f, 0.2f, otL2, 75.0f, 0.85f, 0.5f, otL3, widthVal, widthVal, lengthVal, lengthVal, 0.35f, 50.0f, 0.5f, 50.0f, warpVal, 1.0f);
+}
+
+template <typename SampleType>
+void Engine<SampleType>::setCompactStorage (bool isCompact)
 {
-    if (sampleRate == sr)
-        return;
+    overtoneGenerator.setCompactStorage (isCompact);
+    waveguide.setCompactStorage (isCompact);
+}
 
+template <typename SampleType>
+size_t Engine<SampleType>::getRequiredMemory (SampleType sr) const
+{
+    return overtoneGenerator.getRequiredMemory (sr) + waveguide.getRequiredMemory (sr) + FourStrokeEngine<SampleType>::getRequiredMemory (sr);
+}
+
+template <typename SampleType>
+void Engine<SampleType>::prepare (SampleType sr, jr::MemoryArena& arena)
+{
     sampleRate = sr;
-    overtoneGenerator.setSampleRate (sampleRate);
-    waveguide.setSampleRate (sampleRate);
-    fourStrokeEngine.init (sampleRate);
+    phasor.setSampleRate (sampleRate);
+    overtoneGenerator.prepare (sampleRate, arena);
+    waveguide.prepare (sampleRate, arena);
+    fourStrokeEngine.init (sampleRate, arena);
     frequency.reset (sampleRate, smoothingTimeInSeconds);
     engineLevel.reset (sampleRate, smoothingTimeInSeconds);
     engineLevel.setCurrentAndTargetValue (0);
     smoothedGain.reset (sampleRate, 0.1);
 
-    lpf.setCoefficients (juce::IIRCoefficients::makeLowPass(sampleRate, 8000));
+    lpf.setCoefficients (jr::IIRCoefficients<SampleType>::makeLowPass(sampleRate, 8000));
+}
+
+template <typename SampleType>
+void Engine<SampleType>::setRandomSeed (juce::int64 seed)
+{
+    randomNoise.setSeed (seed);
+    fourStrokeEngine.setRandomSeed (seed + 1);
 }
 
-void Engine::setSpeed (float speedIn)
+template <typename SampleType>
+void Engine<SampleType>::setSpeed (SampleType speedIn)
 {
 
-    float noise = (randomNoise.nextFloat() - 0.5f) / 5.0f; // white noise values scaled down
+    SampleType noise = (randomNoise.nextFloat() - 0.5f) / 5.0f; // white noise values scaled down
 
     speed = speedIn + (noise * speedJitter);
     if (speed > 1)
@@ -62,10 +89,11 @@ void Engine::setSpeed (float speedIn)
     frequency.setTargetValue (speed * 40.0f);
 }
 
-void Engine::setParams (float gain, float cylinderMix, float transmissionDelay1, float phaseShift1, float freq1, float amp1, float transmissionDelay2, 
-                        float phaseShift2, float freq2, float amp2, float transmissionDelay3, float phaseShift3, 
-                        float freq3, float amp3, float width1, float width2, float length1, float length2, float feedbackAmt,
-                        float parabolicDelay, float parabolicMix, float warpDelay, float waveguideWarp, float jitterAmt)
+template <typename SampleType>
+void Engine<SampleType>::setParams (SampleType gain, SampleType cylinderMix, SampleType transmissionDelay1, SampleType phaseShift1, SampleType freq1, SampleType amp1, SampleType transmissionDelay2, 
+                        SampleType phaseShift2, SampleType freq2, SampleType amp2, SampleType transmissionDelay3, SampleType phaseShift3, 
+                        SampleType freq3, SampleType amp3, SampleType width1, SampleType width2, SampleType length1, SampleType length2, SampleType feedbackAmt,
+                        SampleType parabolicDelay, SampleType parabolicMix, SampleType warpDelay, SampleType waveguideWarp, SampleType jitterAmt)
 {
     smoothedGain.setTargetValue (gain);
     speedJitter = jitterAmt;
@@ -80,12 +108,45 @@ void Engine::setParams (float gain, float cylinderMix, float transmissionDelay1,
     waveguide.setParams (parabolicDelay, parabolicMix, warpDelay, waveguideWarp);
 }
 
-float Engine::process()
+//========================= accessor functions ===========================//
+
+template <typename SampleType>
+jr::MemoryFootprint Engine<SampleType>::getMemoryFootprint() const
+{
+    size_t bufferBytes = overtoneGenerator.getMemoryFootprint().bufferBytes + waveguide.getMemoryFootprint().bufferBytes + fourStrokeEngine.getMemoryFootprint().bufferBytes;
+
+    return { sizeof (*this), bufferBytes };
+}
+
+template <typename SampleType>
+void Engine<SampleType>::saveState (jr::SnapshotWriter& writer) const
+{
+    overtoneGenerator.saveState (writer);
+    waveguide.saveState (writer);
+    fourStrokeEngine.saveState (writer);
+    lpf.saveState (writer);
+    phasor.saveState (writer);
+    writer.write (speed, frequency, speedJitter, randomNoise, engineLevelVal, engineMasterGain, smoothedGain, engineLevel, count, useExternalExcitation, excitation);
+}
+
+template <typename SampleType>
+void Engine<SampleType>::loadState (jr::SnapshotReader& reader)
+{
+    overtoneGenerator.loadState (reader);
+    waveguide.loadState (reader);
+    fourStrokeEngine.loadState (reader);
+    lpf.loadState (reader);
+    phasor.loadState (reader);
+    reader.read (speed, frequency, speedJitter, randomNoise, engineLevelVal, engineMasterGain, smoothedGain, engineLevel, count, useExternalExcitation, excitation);
+}
+
+template <typename SampleType>
+SampleType Engine<SampleType>::processDrive()
 {
     // attenuate volume with speed
     if (speed < 0.4)
     {
-        float mod = 10.0f * (0.2 - (speed - 0.2));   // speed value between 0.2 and 0.4 mapped to 2 - 0
+        SampleType mod = 10.0f * (0.2 - (speed - 0.2));   // speed value between 0.2 and 0.4 mapped to 2 - 0
         engineLevel.setTargetValue (exp (pow (mod, 2) * -1.0f));
         if (speed < 0.2)
             engineLevel.setTargetValue (0);
@@ -95,16 +156,83 @@ float Engine::process()
 
     engineLevelVal = engineLevel.getNextValue();
 
-    float frequencyVal = frequency.getNextValue();
+    SampleType frequencyVal = frequency.getNextValue();
     phasor.setFrequency (frequencyVal);
-    float drive = 0.5f * (phasor.processSingleSample() + 1.0f);     // saw osc output converted to phasor 0-1
+    return 0.5f * (phasor.processSingleSample() + 1.0f);     // saw osc output converted to phasor 0-1
+}
 
-    overtoneGenerator.process (drive);
-    float waveguideOut = waveguide.process (speed, drive, overtoneGenerator.getOvertoneVal (0), overtoneGenerator.getOvertoneVal (1), overtoneGenerator.getOvertoneVal (2));
+template <typename SampleType>
+SampleType Engine<SampleType>::processOutput (SampleType waveguideOut, SampleType speedVal, SampleType drive, SampleType levelVal)
+{
     waveguideOut = lpf.processSingleSampleRaw (waveguideOut);
-    float fourStrokeEngineOut = fourStrokeEngine.process (speed, drive);
+    SampleType fourStrokeEngineOut = fourStrokeEngine.process (speedVal, drive);
     
 
-    float gainVal = smoothedGain.getNextValue();
-    return ((0.5f * (waveguideOut + fourStrokeEngineOut)) * engineLevelVal) * gainVal;
+    SampleType gainVal = smoothedGain.getNextValue();
+    return ((0.5f * (waveguideOut + fourStrokeEngineOut)) * levelVal) * gainVal;
 }
+
+template <typename SampleType>
+SampleType Engine<SampleType>::process()
+{
+    SampleType drive = processDrive();
+
+    SampleType waveguideOut{};
+
+    if (useExternalExcitation)
+    {
+        waveguideOut = waveguide.process (speed, drive, excitation, excitation, excitation);
+    }
+    else
+    {
+        overtoneGenerator.process (drive);
+        waveguideOut = waveguide.process (speed, drive, overtoneGenerator.getOvertoneVal (0), overtoneGenerator.getOvertoneVal (1), overtoneGenerator.getOvertoneVal (2));
+    }
+
+    return processOutput (waveguideOut, speed, drive, engineLevelVal);
+}
+
+template <typename SampleType>
+void Engine<SampleType>::processBlock (SampleType* output, const SampleType* speeds, const SampleType* excitations, int numSamples)
+{
+    for (int blockStart = 0; blockStart < numSamples; blockStart += blockSize)
+    {
+        int numInBlock = juce::jmin (blockSize, numSamples - blockStart);
+
+        // the driving phasor and the waveguide inputs don't depend on the waveguide, so they are worked out for the whole block first
+        for (int i = 0; i < numInBlock; i++)
+        {
+            setSpeed (speeds[blockStart + i]);
+            driveBlock[i] = processDrive();
+            speedBlock[i] = speed;
+            levelBlock[i] = engineLevelVal;
+
+            if (excitations != nullptr)
+                excitation = excitations[blockStart + i];
+
+            if (useExternalExcitation)
+            {
+                overtoneBlocks[0][i] = excitation;
+                overtoneBlocks[1][i] = excitation;
+                overtoneBlocks[2][i] = excitation;
+            }
+        }
+
+        // the overtones only depend on the driving phasor, so the generator works through the block in one go
+        if (! useExternalExcitation)
+        {
+            SampleType* overtoneOutputs[3]{ overtoneBlocks[0], overtoneBlocks[1], overtoneBlocks[2] };
+            overtoneGenerator.processBlock (driveBlock, overtoneOutputs, 3, numInBlock);
+        }
+
+        waveguide.processBlock (waveguideBlock, speedBlock, driveBlock, overtoneBlocks[0], overtoneBlocks[1], overtoneBlocks[2], numInBlock);
+
+        for (int i = 0; i < numInBlock; i++)
+            output[blockStart + i] = processOutput (waveguideBlock[i], speedBlock[i], driveBlock[i], levelBlock[i]);
+    }
+}
+
+//======================= Explicit Instantiations =========================//
+
+template class Engine<float>;
+template class Engine<double>;
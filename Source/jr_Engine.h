@@ -13,10 +13,15 @@
 #include "4_stroke_engine.h"                // used for FourStrokeEngine class
 #include "OvertoneGenerator.h"              // used for OvertoneGenerator class
 #include "CircularWaveguide.h"              // used for CircularWaveguide class
+#include "jr_MemoryArena.h"                 // used for jr::MemoryArena
+#include "jr_Snapshot.h"                    // used for jr::SnapshotWriter / SnapshotReader
+#include "jr_IIRFilter.h"                   // used for jr::IIRFilter
+#include "jr_Ramp.h"                        // used for jr::Ramp
 
 /** Physical Model of a combustion engine based on the system laid out by Andy Farnell in 'Designing Sound' (2010), p.507-516
-Use setSampleRate() before use, then setMappedParams() to set params, and call process() each sample for output
+Use prepare() before use, then setMappedParams() to set params, and call process() each sample or processBlock() (taking the speed each sample) for output
 */
+template <typename SampleType>
 class Engine
 {
 public:
@@ -25,19 +30,53 @@ public:
 
     /** Sets the engine parameters via a smaller set of parameters that the others are mapped to
     * @param gainIn - engine gain (0-1)
-    * @param speedIn - engine speed
+    * @param speedIn - engine speed (0-1)
+    * @param aggressionIn - amount the exhaust waveguide is warped by the driving phasor (0-1), mapped to a warp of 0.4-0.72
+    * @param widthIn - width of the exhaust waveguide (0-1), mapped to both widths of 4-24ms
+    * @param lengthIn - length of the exhaust waveguide (0-1), mapped to both lengths of 4-24ms
+    * @param ot1LevelIn - level of overtone 1 (0-1), mapped to 0.1-0.3
+    * @param ot2LevelIn - level of overtone 2 (0-1), mapped to 0.1-0.3
+    * @param ot3LevelIn - level of overtone 3 (0-1), mapped to 0.1-0.3
     */
-    void setMappedParams (float gainIn, float speedIn, float aggressionIn, float widthIn, float lengthIn, float ot1LevelIn, float ot2LevelIn, float ot3LevelIn);
+    void setMappedParams (SampleType gainIn, SampleType speedIn, SampleType aggressionIn, SampleType widthIn, SampleType lengthIn, SampleType ot1LevelIn, SampleType ot2LevelIn, SampleType ot3LevelIn);
 
-    /** Sets the sample rate
+    /** Sets the engine parameters other than speed via the smaller set of mapped parameters, for use with processBlock() which takes the speed each sample
+    * @param gainIn - engine gain (0-1)
+    * @param aggressionIn - amount the exhaust waveguide is warped by the driving phasor (0-1), mapped to a warp of 0.4-0.72
+    * @param widthIn - width of the exhaust waveguide (0-1), mapped to both widths of 4-24ms
+    * @param lengthIn - length of the exhaust waveguide (0-1), mapped to both lengths of 4-24ms
+    * @param ot1LevelIn - level of overtone 1 (0-1), mapped to 0.1-0.3
+    * @param ot2LevelIn - level of overtone 2 (0-1), mapped to 0.1-0.3
+    * @param ot3LevelIn - level of overtone 3 (0-1), mapped to 0.1-0.3
+    */
+    void setMappedParams (SampleType gainIn, SampleType aggressionIn, SampleType widthIn, SampleType lengthIn, SampleType ot1LevelIn, SampleType ot2LevelIn, SampleType ot3LevelIn);
+
+    /** Sets whether the long driving phasor delay lines (overtone generator and waveguide) use 16-bit fixed point storage, halving their memory.
+    Call before getRequiredMemory() and prepare()
+    * @param isCompact - true for compact storage
+    */
+    void setCompactStorage (bool isCompact);
+
+    /** Returns the number of bytes of arena memory needed by the engine and its components
     * @param sr - sample rate, Hz
     */
-    void setSampleRate (float sr);
+    size_t getRequiredMemory (SampleType sr) const;
+
+    /** Sets the sample rate and takes all delay lines from the arena
+    * @param sr - sample rate, Hz
+    * @param arena - arena with room for getRequiredMemory() bytes
+    */
+    void prepare (SampleType sr, jr::MemoryArena& arena);
+
+    /** Seeds every noise generator in the engine, so that renders can be repeated exactly
+    * @param seed - seed value
+    */
+    void setRandomSeed (juce::int64 seed);
 
     /** sets the speed of the engine
     * @param speedIn - speed (0-1)
     */
-    void setSpeed (float speedIn);
+    void setSpeed (SampleType speedIn);
 
     /** Sets all parameters for engine
     * @param cylinderMix - output level of four stroke engine cylinders (0-1)
@@ -63,33 +102,95 @@ public:
     * @param warpDelay - delay in ms for 'fm1' and 'fm2' (0-100) (for waveguide)
     * @param waveguideWarp - amount of driving signal sent to 'fm1' and 'fm2' (0-1) (for waveguide)
     */
-    void setParams (float gain, float cylinderMix, float transmissionDelay1, float phaseShift1, float freq1, float amp1, float transmissionDelay2,
-        float phaseShift2, float freq2, float amp2, float transmissionDelay3, float phaseShift3,
-        float freq3, float amp3, float width1, float width2, float length1, float length2, float feedbackAmt,
-        float parabolicDelay, float parabolicMix, float warpDelay, float waveguideWarp, float jitterAmt);
+    void setParams (SampleType gain, SampleType cylinderMix, SampleType transmissionDelay1, SampleType phaseShift1, SampleType freq1, SampleType amp1, SampleType transmissionDelay2,
+        SampleType phaseShift2, SampleType freq2, SampleType amp2, SampleType transmissionDelay3, SampleType phaseShift3,
+        SampleType freq3, SampleType amp3, SampleType width1, SampleType width2, SampleType length1, SampleType length2, SampleType feedbackAmt,
+        SampleType parabolicDelay, SampleType parabolicMix, SampleType warpDelay, SampleType waveguideWarp, SampleType jitterAmt);
+
+    /** Sets whether the waveguide is excited by an external signal (see setExcitation()) in place of the overtones. The overtone generator isn't processed while it is
+    * @param isExternal - true to excite the waveguide with the external signal
+    */
+    void setExternalExcitation (bool isExternal) { useExternalExcitation = isExternal; }
+
+    /** Sets the current sample of the external excitation signal - call each sample before process()
+    * @param sample - excitation sample value
+    */
+    void setExcitation (SampleType sample) { excitation = sample; }
 
     /** Returns the next sample value for the engine
     * @return sampleOut
     */
-    float process();
+    SampleType process();
+
+    /** Processes a block of samples, giving the same output as calling setSpeed() and process() for each. The driving phasor and overtones are
+    worked out a block at a time, so the waveguide can process its delays as blocks
+    * @param output - array to write the engine output to
+    * @param speeds - speed for each sample, as passed to setSpeed() (0-1)
+    * @param excitations - external excitation for each sample (see setExternalExcitation()), or nullptr to keep the one set by setExcitation()
+    * @param numSamples - number of samples
+    */
+    void processBlock (SampleType* output, const SampleType* speeds, const SampleType* excitations, int numSamples);
+
+    /** Writes the complete DSP state of the engine and its components to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const;
+
+    /** Reads the complete DSP state of the engine from a snapshot taken from an engine prepared the same way
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader);
+
+    /** Returns the memory used by the engine and all of its components, including delay lines in the arena
+    */
+    jr::MemoryFootprint getMemoryFootprint() const;
+
+    /** Returns the memory used by each component of the engine
+    */
+    jr::MemoryFootprint getOvertoneGeneratorFootprint() const { return overtoneGenerator.getMemoryFootprint(); }
+    jr::MemoryFootprint getWaveguideFootprint() const { return waveguide.getMemoryFootprint(); }
+    jr::MemoryFootprint getFourStrokeEngineFootprint() const { return fourStrokeEngine.getMemoryFootprint(); }
+
+private:
+
+    /** Moves the speed smoothing and driving phasor on a sample, returning the driving phasor (0-1)
+    */
+    SampleType processDrive();
+
+    /** Returns the engine output for a sample from the waveguide output, running the four stroke engine and output filter and gain
+    * @param waveguideOut - waveguide output
+    * @param speedVal - engine speed for the sample
+    * @param drive - driving phasor for the sample
+    * @param levelVal - engine volume for the sample
+    */
+    SampleType processOutput (SampleType waveguideOut, SampleType speedVal, SampleType drive, SampleType levelVal);
 
 private:
-    OvertoneGenerator overtoneGenerator;    
-    CircularWaveguide waveguide;            
-    FourStrokeEngine fourStrokeEngine;      
-
-    juce::IIRFilter lpf;                    // low pass filter for filter waveguide out
-
-    float sampleRate{};                     // sample rate, Hz
-    jr::Oscillator phasor;                  // driving phasor - important to not use a polyBLEP anti-aliasing osc, as this causes inconsistencies and clicks in the produced pulse waves
-    float speed{};                          // current speed value of engine (0-1)
-    juce::SmoothedValue<float> frequency;   // freqeuncy of phasor, Hz
-    float smoothingTimeInSeconds{ 0.55 };   // smoothing time for phasor frequency, in seconds
-    float speedJitter{ 0.1 };               // speed jitter amount (0.1 - 1)
-    juce::Random randomNoise;               // random number generator used for noise of speed jitter
-    float engineLevelVal{ 1.0f };           // engine volume (0-1) used for fade out with speed
-    float engineMasterGain{ 1.0f };         // engine master volume used for overall volume control
-    juce::SmoothedValue<float> smoothedGain;// smoothed value for gain
-    juce::SmoothedValue<float> engineLevel; // smoothed engine volume
-    int count{};                            // count used to change speed offset every set number of samples
+    OvertoneGenerator<SampleType> overtoneGenerator;    
+    CircularWaveguide<SampleType> waveguide;            
+    FourStrokeEngine<SampleType> fourStrokeEngine;      
+
+    jr::IIRFilter<SampleType> lpf;          // low pass filter for filter waveguide out
+
+    SampleType sampleRate{};                      // sample rate, Hz
+    jr::Oscillator<SampleType> phasor;            // driving phasor - important to not use a polyBLEP anti-aliasing osc, as this causes inconsistencies and clicks in the produced pulse waves
+    SampleType speed{};                           // current speed value of engine (0-1)
+    jr::Ramp<SampleType> frequency;               // freqeuncy of phasor, Hz
+    SampleType smoothingTimeInSeconds{ 0.55 };    // smoothing time for phasor frequency, in seconds
+    SampleType speedJitter{ 0.1 };                // speed jitter amount (0.1 - 1)
+    juce::Random randomNoise;                     // random number generator used for noise of speed jitter
+    SampleType engineLevelVal{ 1.0f };            // engine volume (0-1) used for fade out with speed
+    SampleType engineMasterGain{ 1.0f };          // engine master volume used for overall volume control
+    jr::Ramp<SampleType> smoothedGain;            // smoothed value for gain
+    jr::Ramp<SampleType> engineLevel;             // smoothed engine volume
+    int count{};                                  // count used to change speed offset every set number of samples
+    bool useExternalExcitation{ false };          // true if the waveguide is excited by the external signal in place of the overtones
+    SampleType excitation{};                      // current sample of the external excitation signal
+
+    static constexpr int blockSize{ 64 };         // most samples processBlock() works through at once
+    SampleType speedBlock[blockSize];             // speed for each sample of the current block, after jitter
+    SampleType driveBlock[blockSize];             // driving phasor for each sample of the current block
+    SampleType levelBlock[blockSize];             // engine volume for each sample of the current block
+    SampleType overtoneBlocks[3][blockSize];      // waveguide inputs 'b', 'c' and 'd' (overtones or excitation) for the current block
+    SampleType waveguideBlock[blockSize];         // waveguide output for the current block
 };
\ No newline at end of file
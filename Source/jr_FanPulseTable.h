@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    jr_FanPulseTable.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cmath>        // used for std::sqrt(), std::pow(), std::cos()
+#include <JuceHeader.h>
+
+namespace jr {
+
+    /** Tables of the fan tone's pulse wave, 1 / (1 + (sin (2pi * phase) * pulseWidth) ^ 2), over phase and pulse width.
+    The pulse has the Fourier series (1 + 2 * sum (r ^ n * cos (4pi * n * phase))) / sqrt (1 + pulseWidth ^ 2), so each pulse width is built from its
+    harmonics, and each mip level keeps half the harmonics of the one before so a fast fan can read a level with nothing above Nyquist.
+    The tables don't depend on the sample rate or speed, so one read-only copy serves every FanToneComponent. Values are interpolated
+    bilinearly: at whole pulse widths they are within 0.06% of the curve, and between them the neighbouring shapes are blended (within 1% above a width of 4)
+    * @tparam SampleType - float or double
+    */
+    template <typename SampleType>
+    class FanPulseTable
+    {
+    public:
+
+        static constexpr int numPhaseSteps{ 1024 };     // intervals along the phase axis, per pulse (half a revolution)
+        static constexpr int numPulseWidths{ 16 };      // pulse widths in the table, 1 to 16 in steps of 1
+        static constexpr int maxHarmonics{ 128 };       // harmonics of the pulse in the first mip level
+        static constexpr int numLevels{ 8 };            // mip levels, 128 harmonics down to 1
+
+        /** Returns the shared table, building it on first use. The first call must be made off the audio thread (FanToneComponent makes it when constructed)
+        */
+        static const FanPulseTable& getShared()
+        {
+            static const FanPulseTable table;
+            return table;
+        }
+
+        /** Returns the mip level with the most harmonics that stay below Nyquist
+        * @param revolutionsPerSample - fan speed divided by sample rate
+        */
+        static int getLevel (SampleType revolutionsPerSample)
+        {
+            // harmonic n of the pulse is at 2n revolutions per sample, as there are two pulses per revolution
+            SampleType harmonicLimit = (SampleType) 0.25 / juce::jmax (revolutionsPerSample, (SampleType) 1.0e-9);
+            int level = 0;
+
+            while (level < numLevels - 1 && (maxHarmonics >> level) > harmonicLimit)
+                level++;
+
+            return level;
+        }
+
+        /** Returns the value of the pulse wave
+        * @param level - mip level from getLevel()
+        * @param pulseWidth - pulse width, limited to 1-16
+        * @param phase - position through the revolution (0-2)
+        */
+        SampleType getPulse (int level, SampleType pulseWidth, SampleType phase) const
+        {
+            SampleType widthPosition = juce::jlimit ((SampleType) 1, (SampleType) numPulseWidths, pulseWidth) - 1;
+            int widthIndex = juce::jmin ((int) widthPosition, numPulseWidths - 2);
+            SampleType widthFraction = widthPosition - widthIndex;
+
+            SampleType phasePosition = phase * (2 * numPhaseSteps);
+            int phaseIndex = (int) phasePosition;
+            SampleType phaseFraction = phasePosition - phaseIndex;
+            phaseIndex &= numPhaseSteps - 1;
+
+            const SampleType* row = pulses + (((level * numPulseWidths) + widthIndex) * rowLength) + phaseIndex;
+            const SampleType* nextRow = row + rowLength;
+
+            SampleType value = row[0] + (phaseFraction * (row[1] - row[0]));
+            SampleType nextValue = nextRow[0] + (phaseFraction * (nextRow[1] - nextRow[0]));
+
+            return value + (widthFraction * (nextValue - value));
+        }
+
+    private:
+
+        FanPulseTable()
+        {
+            double cosines[numPhaseSteps];
+
+            for (int step = 0; step < numPhaseSteps; step++)
+                cosines[step] = std::cos (juce::MathConstants<double>::twoPi * step / numPhaseSteps);
+
+            for (int width = 0; width < numPulseWidths; width++)
+            {
+                double widthSquared = (double) (width + 1) * (width + 1);
+                double root = std::sqrt (1.0 + widthSquared);
+                double ratio = (1.0 + (widthSquared * 0.5) - root) / (widthSquared * 0.5);
+
+                // each level adds its harmonics to the sum of the level above it, starting from the level with only the fundamental
+                double sums[rowLength];
+                int numHarmonics = 0;
+
+                for (int step = 0; step <= numPhaseSteps; step++)
+                    sums[step] = 1.0 / root;
+
+                for (int level = numLevels - 1; level >= 0; level--)
+                {
+                    for (int harmonic = numHarmonics + 1; harmonic <= (maxHarmonics >> level); harmonic++)
+                    {
+                        double amplitude = 2.0 * std::pow (ratio, harmonic) / root;
+
+                        for (int step = 0; step <= numPhaseSteps; step++)
+                            sums[step] += amplitude * cosines[(harmonic * step) % numPhaseSteps];
+                    }
+
+                    numHarmonics = maxHarmonics >> level;
+                    SampleType* row = pulses + (((level * numPulseWidths) + width) * rowLength);
+
+                    for (int step = 0; step <= numPhaseSteps; step++)
+                        row[step] = (SampleType) sums[step];
+                }
+            }
+        }
+
+        static constexpr int rowLength{ numPhaseSteps + 1 };                        // values per row, the last repeating the first
+        SampleType pulses[numLevels * numPulseWidths * rowLength];                  // pulse values, a row of phases for each pulse width in each mip level
+    };
+}
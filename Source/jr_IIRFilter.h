@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+    jr_IIRFilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cmath>        // used for std::tan(), std::sin(), std::cos()
+#include <JuceHeader.h>
+#include "jr_Snapshot.h"    // used for jr::SnapshotWriter / SnapshotReader
+
+namespace jr {
+
+    /** Coefficients for a second order IIR filter, normalised by a0. The make functions use the same designs as juce::IIRCoefficients,
+    calculated in double precision and stored in the filter's sample type
+    */
+    template <typename SampleType>
+    struct IIRCoefficients
+    {
+        SampleType coefficients[5]{};       // b0, b1, b2, a1, a2 (all divided by a0)
+
+        IIRCoefficients() = default;
+
+        /** Creates coefficients from unnormalised values
+        */
+        IIRCoefficients (double b0, double b1, double b2, double a0, double a1, double a2)
+        {
+            auto a = 1.0 / a0;
+
+            coefficients[0] = (SampleType) (b0 * a);
+            coefficients[1] = (SampleType) (b1 * a);
+            coefficients[2] = (SampleType) (b2 * a);
+            coefficients[3] = (SampleType) (a1 * a);
+            coefficients[4] = (SampleType) (a2 * a);
+        }
+
+        /** Returns coefficients for a low pass filter
+        * @param sampleRate - sample rate, Hz
+        * @param frequency - cutoff frequency, Hz
+        * @param Q - resonance
+        */
+        static IIRCoefficients makeLowPass (double sampleRate, double frequency, double Q = 1.0 / juce::MathConstants<double>::sqrt2)
+        {
+            auto n = 1.0 / std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+            auto nSquared = n * n;
+            auto c1 = 1.0 / (1.0 + 1.0 / Q * n + nSquared);
+
+            return IIRCoefficients (c1, c1 * 2.0, c1, 1.0, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - 1.0 / Q * n + nSquared));
+        }
+
+        /** Returns coefficients for a high pass filter
+        * @param sampleRate - sample rate, Hz
+        * @param frequency - cutoff frequency, Hz
+        * @param Q - resonance
+        */
+        static IIRCoefficients makeHighPass (double sampleRate, double frequency, double Q = 1.0 / juce::MathConstants<double>::sqrt2)
+        {
+            auto n = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+            auto nSquared = n * n;
+            auto c1 = 1.0 / (1.0 + n / Q + nSquared);
+
+            return IIRCoefficients (c1, c1 * -2.0, c1, 1.0, c1 * 2.0 * (nSquared - 1.0), c1 * (1.0 - n / Q + nSquared));
+        }
+
+        /** Returns coefficients for a band pass filter (constant 0dB peak gain)
+        * @param sampleRate - sample rate, Hz
+        * @param frequency - centre frequency, Hz
+        * @param Q - resonance
+        */
+        static IIRCoefficients makeBandPass (double sampleRate, double frequency, double Q = 1.0 / juce::MathConstants<double>::sqrt2)
+        {
+            auto w0 = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+            auto alpha = std::sin (w0) / (Q * 2.0);
+
+            return IIRCoefficients (alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * std::cos (w0), 1.0 - alpha);
+        }
+    };
+
+    /** A second order IIR filter (transposed direct form II). Works the same as juce::IIRFilter, but in either sample type,
+    and setting coefficients is a plain copy with no lock, so it is safe to update every sample on the audio thread
+    */
+    template <typename SampleType>
+    class IIRFilter
+    {
+    public:
+
+        /** Sets the filter coefficients, keeping the current filter state
+        * @param newCoefficients - coefficients from one of the IIRCoefficients::make functions
+        */
+        void setCoefficients (const IIRCoefficients<SampleType>& newCoefficients) { coefficients = newCoefficients; }
+
+        /** Clears the filter state
+        */
+        void reset() { v1 = v2 = 0; }
+
+        /** Writes the coefficients and filter state to a snapshot
+        */
+        void saveState (SnapshotWriter& writer) const { writer.write (coefficients, v1, v2); }
+
+        /** Reads the coefficients and filter state from a snapshot
+        */
+        void loadState (SnapshotReader& reader) { reader.read (coefficients, v1, v2); }
+
+        /** Returns the next filtered sample
+        * @param in - sample value in
+        */
+        SampleType processSingleSampleRaw (SampleType in)
+        {
+            auto* c = coefficients.coefficients;
+
+            auto out = c[0] * in + v1;
+
+            // snap denormals to zero
+            if (! (out < (SampleType) -1.0e-8 || out > (SampleType) 1.0e-8))
+                out = 0;
+
+            v1 = c[1] * in - c[3] * out + v2;
+            v2 = c[2] * in - c[4] * out;
+
+            return out;
+        }
+
+        /** Filters a block of samples in place, keeping the state in registers for the whole block
+        * @param data - samples to filter
+        * @param numSamples - number of samples
+        */
+        void processBlock (SampleType* data, int numSamples)
+        {
+            const auto* c = coefficients.coefficients;
+            const SampleType b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+            SampleType s1 = v1, s2 = v2;
+
+            for (int i = 0; i < numSamples; i++)
+            {
+                const SampleType in = data[i];
+                SampleType out = b0 * in + s1;
+
+                if (! (out < (SampleType) -1.0e-8 || out > (SampleType) 1.0e-8))
+                    out = 0;
+
+                s1 = b1 * in - a1 * out + s2;
+                s2 = b2 * in - a2 * out;
+                data[i] = out;
+            }
+
+            v1 = s1;
+            v2 = s2;
+        }
+
+    private:
+        IIRCoefficients<SampleType> coefficients;      // current coefficients
+        SampleType v1{}, v2{};                          // filter state
+    };
+
+    /** A fixed number of second order IIR filters in series, each with its own coefficients and state. Per sample, the stages run one after the
+    other; per block, each stage filters the whole block before the next, so its state stays in registers
+    * @tparam SampleType - float or double
+    * @tparam numStages - number of second order stages
+    */
+    template <typename SampleType, int numStages>
+    class IIRCascade
+    {
+    public:
+
+        /** Sets the coefficients of one stage, keeping its state
+        * @param stage - stage index
+        * @param newCoefficients - coefficients from one of the IIRCoefficients::make functions
+        */
+        void setCoefficients (int stage, const IIRCoefficients<SampleType>& newCoefficients) { stages[stage].setCoefficients (newCoefficients); }
+
+        /** Sets every stage to the same coefficients, keeping their state
+        * @param newCoefficients - coefficients from one of the IIRCoefficients::make functions
+        */
+        void setCoefficients (const IIRCoefficients<SampleType>& newCoefficients)
+        {
+            for (auto& stage : stages)
+                stage.setCoefficients (newCoefficients);
+        }
+
+        /** Clears the state of every stage
+        */
+        void reset()
+        {
+            for (auto& stage : stages)
+                stage.reset();
+        }
+
+        /** Writes the coefficients and state of every stage to a snapshot, in the same layout as that many IIRFilters
+        */
+        void saveState (SnapshotWriter& writer) const
+        {
+            for (const auto& stage : stages)
+                stage.saveState (writer);
+        }
+
+        /** Reads the coefficients and state of every stage from a snapshot
+        */
+        void loadState (SnapshotReader& reader)
+        {
+            for (auto& stage : stages)
+                stage.loadState (reader);
+        }
+
+        /** Returns the next sample filtered by every stage
+        * @param in - sample value in
+        */
+        SampleType processSingleSampleRaw (SampleType in)
+        {
+            for (auto& stage : stages)
+                in = stage.processSingleSampleRaw (in);
+
+            return in;
+        }
+
+        /** Filters a block of samples in place through every stage
+        * @param data - samples to filter
+        * @param numSamples - number of samples
+        */
+        void processBlock (SampleType* data, int numSamples)
+        {
+            for (auto& stage : stages)
+                stage.processBlock (data, numSamples);
+        }
+
+    private:
+        IIRFilter<SampleType> stages[numStages];        // stages, in processing order
+    };
+}
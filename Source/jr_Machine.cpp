@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    jr_Machine.cpp
+
+  ==============================================================================
+*/
+
+#include "jr_Machine.h"
+#include <cmath>                            // used for std::exp() and std::abs()
+
+//========================= mutator functions ===========================//
+
+template <typename SampleType>
+void Machine<SampleType>::setCompactStorage (bool isCompact)
+{
+    engine.setCompactStorage (isCompact);
+    fan.setCompactStorage (isCompact);
+}
+
+template <typename SampleType>
+size_t Machine<SampleType>::getRequiredMemory (double sampleRate) const
+{
+    return engine.getRequiredMemory (sampleRate) + fan.getRequiredMemory (sampleRate);
+}
+
+template <typename SampleType>
+void Machine<SampleType>::prepare (double sampleRate, jr::MemoryArena& arena)
+{
+    smoothedGain.reset (sampleRate, 0.1f);
+    smoothedMaxSpeed.reset (sampleRate, 0.55f);
+
+    // input envelope follower, 10ms attack and 200ms release
+    followerAttack = (SampleType) std::exp (-1.0 / (0.01 * sampleRate));
+    followerRelease = (SampleType) std::exp (-1.0 / (0.2 * sampleRate));
+    inputEnvelope = 0;
+
+    engine.prepare (sampleRate, arena);
+    fan.prepare (sampleRate, arena);
+    motor.setSampleRate (sampleRate);
+}
+
+template <typename SampleType>
+void Machine<SampleType>::setRandomSeed (juce::int64 seed)
+{
+    motor.setRandomSeed (seed);
+    fan.setRandomSeed (seed + 100);
+    engine.setRandomSeed (seed + 200);
+}
+
+template <typename SampleType>
+void Machine<SampleType>::setParams (const MachineParams& newParams)
+{
+    params = newParams;
+    smoothedGain.setTargetValue (params.masterGain);
+    smoothedMaxSpeed.setTargetValue (params.motorMaxSpeed);
+}
+
+template <typename SampleType>
+void Machine<SampleType>::setSteadyState (const MachineParams& newParams)
+{
+    setParams (newParams);
+    smoothedGain.setCurrentAndTargetValue (params.masterGain);
+    smoothedMaxSpeed.setCurrentAndTargetValue (params.motorMaxSpeed);
+
+    motor.setMappedParams (params.powerUpTime, params.powerDownTime, params.acceleration, params.motorGain, params.motorMaxSpeed, params.motorCasingSize, params.motorRotorLevel, params.motorSparksLevel, params.motorHum);
+    motor.setSteadyState (params.trigger);
+    isPlaying = params.trigger;
+}
+
+//========================= processing functions ===========================//
+
+template <typename SampleType>
+void Machine<SampleType>::process (SampleType* const* channels, const MachineOutputRouting& routing, int startSample, int numSamples, const Stems& stems,
+                                   const SampleType* const* inputChannels, int numInputChannels)
+{
+    const bool isStereo = routing.isStereo();
+    const int monoChannel = routing.centre >= 0 ? routing.centre : juce::jmax (routing.left, routing.right);
+    const bool hasInput = params.inputMode != MachineInputMode::OFF;
+    fan.setStereo (isStereo);
+    engine.setExternalExcitation (params.inputMode == MachineInputMode::WAVEGUIDE);
+    motor.setExternalExcitation (params.inputMode == MachineInputMode::RESONATOR);
+
+    for (int chunkStart = startSample; chunkStart < startSample + numSamples; chunkStart += chunkSize)
+    {
+        const int numInChunk = juce::jmin (chunkSize, startSample + numSamples - chunkStart);
+        const Stems chunkStems = stems.withOffset (chunkStart);
+
+        // mix the input down to mono before this part of the output (which may be the same memory) is written
+        if (hasInput)
+        {
+            juce::FloatVectorOperations::clear (inputChunk, numInChunk);
+
+            for (int channel = 0; channel < numInputChannels; channel++)
+                juce::FloatVectorOperations::add (inputChunk, inputChannels[channel] + chunkStart, numInChunk);
+
+            if (numInputChannels > 0)
+                juce::FloatVectorOperations::multiply (inputChunk, (SampleType) (params.inputGain / numInputChannels), numInChunk);
+        }
+
+        // the smoothed controls are written a chunk at a time
+        smoothedMaxSpeed.fillBlock (maxSpeedChunk, numInChunk);
+        smoothedGain.fillBlock (gainChunk, numInChunk);
+
+        if (hasInput)
+        {
+            for (int i = 0; i < numInChunk; i++)
+            {
+                SampleType inputLevel = std::abs (inputChunk[i]);
+                SampleType coefficient = inputLevel > inputEnvelope ? followerAttack : followerRelease;
+                inputEnvelope = inputLevel + (coefficient * (inputEnvelope - inputLevel));
+
+                if (params.inputMode == MachineInputMode::MOTOR_SPEED)
+                    maxSpeedChunk[i] *= juce::jmin ((SampleType) 1, inputEnvelope);
+            }
+        }
+
+        motor.setMappedParams (params.powerUpTime, params.powerDownTime, params.acceleration, params.motorGain, params.motorMaxSpeed, params.motorCasingSize, params.motorRotorLevel, params.motorSparksLevel, params.motorHum);
+
+        if (params.trigger && !isPlaying)
+        {
+            isPlaying = true;
+            motor.powerOn();
+        }
+        else if (isPlaying && !params.trigger)
+        {
+            isPlaying = false;
+            motor.powerOff();
+        }
+
+        // the motor doesn't depend on the other sources, so it runs a chunk at a time, giving the speed and envelope that drive them.
+        // The fan follows the motor's speed one sample behind, as it always has
+        SampleType fanSpeedVal = motor.getCurrentSpeed();
+        motor.processBlock (motorChunk, motorSpeedChunk, motorEnvelopeChunk, maxSpeedChunk, hasInput ? inputChunk : nullptr, numInChunk);
+
+        // the engine only follows the motor envelope, so it runs a chunk at a time too, letting its waveguide work on blocks
+        SampleType revsVal = params.trigger ? params.engineRevs : 0.0f;
+
+        for (int i = 0; i < numInChunk; i++)
+            engineSpeedChunk[i] = getEngineSpeed (motorEnvelopeChunk[i], revsVal);
+
+        engine.setMappedParams (params.engineGain, 0.5f, params.engineWidth, params.engineLength, params.engineOT1, params.engineOT2, params.engineOT3);
+        engine.processBlock (engineChunk, engineSpeedChunk, hasInput ? inputChunk : nullptr, numInChunk);
+
+        for (int i = 0; i < numInChunk; i++)
+        {
+            SampleType motorEnvelopeVal = motorEnvelopeChunk[i];
+
+            fan.setMappedParams (params.fanGain, fanSpeedVal / params.fanRatio, params.fanToneLevel, params.fanNoiseLevel, params.fanStereoWidth, params.fanDoppler);
+            fan.process();
+            fanSpeedVal = motorSpeedChunk[i];
+
+            SampleType engineOut = engineChunk[i];
+
+            SampleType gainVal = gainChunk[i];
+            SampleType fanLeft = gainVal * motorEnvelopeVal * fan.getLeftSample();
+            SampleType fanRight = gainVal * motorEnvelopeVal * fan.getRightSample();
+            SampleType motorOut = motorChunk[i] * gainVal;
+            engineOut *= gainVal;
+
+            monoChunk[i] = engineOut + motorOut;
+            fanLeftChunk[i] = fanLeft;
+            fanRightChunk[i] = fanRight;
+
+            for (int channel = 0; channel < 2; channel++)
+            {
+                if (chunkStems.engine[channel] != nullptr)
+                    chunkStems.engine[channel][i] = engineOut;
+
+                if (chunkStems.motor[channel] != nullptr)
+                    chunkStems.motor[channel][i] = motorOut;
+            }
+
+            if (chunkStems.fan[0] != nullptr && chunkStems.fan[1] != nullptr)
+            {
+                chunkStems.fan[0][i] = fanLeft;
+                chunkStems.fan[1][i] = fanRight;
+            }
+            else if (chunkStems.fan[0] != nullptr)
+            {
+                chunkStems.fan[0][i] = 0.5f * (fanLeft + fanRight);
+            }
+        }
+
+        // mix each source into its channels, a chunk at a time
+        for (int channel = 0; channel < routing.numChannels; channel++)
+            juce::FloatVectorOperations::clear (channels[channel] + chunkStart, numInChunk);
+
+        if (routing.centre >= 0 || ! isStereo)
+        {
+            juce::FloatVectorOperations::add (channels[monoChannel] + chunkStart, monoChunk, numInChunk);
+        }
+        else
+        {
+            juce::FloatVectorOperations::add (channels[routing.left] + chunkStart, monoChunk, numInChunk);
+            juce::FloatVectorOperations::add (channels[routing.right] + chunkStart, monoChunk, numInChunk);
+        }
+
+        if (isStereo)
+        {
+            juce::FloatVectorOperations::add (channels[routing.left] + chunkStart, fanLeftChunk, numInChunk);
+            juce::FloatVectorOperations::add (channels[routing.right] + chunkStart, fanRightChunk, numInChunk);
+        }
+        else
+        {
+            juce::FloatVectorOperations::add (channels[monoChannel] + chunkStart, fanLeftChunk, numInChunk);
+        }
+    }
+}
+
+template <typename SampleType>
+void Machine<SampleType>::process (SampleType* left, SampleType* right, int numSamples, const Stems& stems)
+{
+    SampleType* channels[] = { left, right };
+    process (channels, MachineOutputRouting(), 0, numSamples, stems);
+}
+
+//========================= accessor functions ===========================//
+
+template <typename SampleType>
+void Machine<SampleType>::saveState (jr::SnapshotWriter& writer) const
+{
+    motor.saveState (writer);
+    fan.saveState (writer);
+    engine.saveState (writer);
+    writer.write (smoothedGain, smoothedMaxSpeed, params, isPlaying, inputEnvelope);
+}
+
+template <typename SampleType>
+void Machine<SampleType>::loadState (jr::SnapshotReader& reader)
+{
+    motor.loadState (reader);
+    fan.loadState (reader);
+    engine.loadState (reader);
+    reader.read (smoothedGain, smoothedMaxSpeed, params, isPlaying, inputEnvelope);
+}
+
+//======================= Explicit Instantiations =========================//
+
+template class Machine<float>;
+template class Machine<double>;
@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    jr_Machine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "jr_Engine.h"                      // used for Engine
+#include "ElectricMotorDC.h"                // used for ElectricMotorDC
+#include "jr_SimpleFan.h"                   // used for FanPropeller
+#include "jr_MemoryArena.h"                 // used for jr::MemoryArena
+#include "jr_Snapshot.h"                    // used for jr::SnapshotWriter / SnapshotReader
+#include "jr_Ramp.h"                        // used for jr::Ramp
+
+/** How the audio input is used by a Machine
+*/
+enum class MachineInputMode
+{
+    OFF = 0,                                // input is ignored
+    WAVEGUIDE,                              // input excites the engine's waveguide in place of the overtones
+    RESONATOR,                              // input excites the motor's casing resonator in place of the rotor
+    MOTOR_SPEED                             // an envelope follower on the input scales the motor's max speed
+};
+
+/** The control values of a Machine, in the same units and ranges as the plugin parameters they are read from.
+Defaults match the plugin parameter defaults
+*/
+struct MachineParams
+{
+    bool trigger{ false };                  // true while the machine is switched on
+    float masterGain{ 0.5f };               // output gain (0-1)
+    float powerUpTime{ 3.0f };              // power up time, seconds
+    float powerDownTime{ 3.0f };            // power down time, seconds
+    float acceleration{ 0.5f };             // rate of acceleration (0-1)
+
+    float motorGain{ 0.0f };                // motor level (0-1)
+    float motorMaxSpeed{ 200.0f };          // motor max speed, Hz
+    float motorCasingSize{ 0.75f };         // motor casing size (0-1)
+    float motorRotorLevel{ 0.6f };          // motor rotor level (0-1)
+    float motorSparksLevel{ 0.2f };         // motor sparks level (0-1)
+    bool motorHum{ false };                 // true if the rotor DC signal is sent to the resonator pre-envelope
+
+    float fanGain{ 0.0f };                  // fan level (0-1)
+    float fanRatio{ 20.0f };                // ratio of motor speed to fan speed (10-30)
+    float fanToneLevel{ 0.75f };            // fan tone level (0-1)
+    float fanNoiseLevel{ 0.75f };           // fan noise level (0-1)
+    float fanStereoWidth{ 0.0f };           // fan stereo width (0-1)
+    bool fanDoppler{ false };               // true to apply the doppler effect to the fan
+
+    float engineGain{ 0.0f };               // engine level (0-1)
+    float engineRevs{ 0.0f };               // engine revs (0-1)
+    float engineWidth{ 0.75f };             // engine exhaust width (0-1)
+    float engineLength{ 0.65f };            // engine exhaust length (0-1)
+    float engineOT1{ 0.5f };                // engine overtone 1 level (0-1)
+    float engineOT2{ 0.27f };               // engine overtone 2 level (0-1)
+    float engineOT3{ 0.42f };               // engine overtone 3 level (0-1)
+
+    MachineInputMode inputMode{ MachineInputMode::OFF };    // how the audio input is used
+    float inputGain{ 1.0f };                // gain applied to the audio input (0-4)
+};
+
+/** Channel indices of an output layout for each of the machine's sources, -1 for a channel the layout doesn't have.
+The engine and motor are mono and go to the centre channel, or to both left and right if there is no centre. The fan is panned
+between left and right, or goes to the centre without panning if the layout doesn't have both
+*/
+struct MachineOutputRouting
+{
+    int left{ 0 };                          // left channel (stereo by default)
+    int right{ 1 };                         // right channel
+    int centre{ -1 };                       // centre channel (the only channel of a mono layout)
+    int numChannels{ 2 };                   // number of channels in the layout, any not used by a source are cleared
+
+    /** Returns true if the layout has both a left and a right channel, so the fan is panned
+    */
+    bool isStereo() const { return left >= 0 && right >= 0; }
+};
+
+/** The complete machine: a DC motor driving a fan and an engine, mixed to stereo.
+Use setCompactStorage() and setRandomSeed() as needed, then prepare(). Call setParams() whenever the controls change (e.g. once a block)
+and process() to render
+* @tparam SampleType - float or double
+*/
+template <typename SampleType>
+class Machine
+{
+public:
+
+    /** Optional outputs of each model on its own, as pairs of channel pointers (left, right). Null pointers are skipped,
+    and a stem with only a left channel is mono. Stems are scaled by the master gain, so that they sum to the main output
+    */
+    struct Stems
+    {
+        SampleType* engine[2]{};            // engine stem channels
+        SampleType* motor[2]{};             // motor stem channels
+        SampleType* fan[2]{};               // fan stem channels
+
+        /** Returns the stems starting a number of samples later, used to render part of a block
+        * @param numSamples - offset, samples
+        */
+        Stems withOffset (int numSamples) const
+        {
+            Stems offsetStems;
+
+            for (int channel = 0; channel < 2; channel++)
+            {
+                offsetStems.engine[channel] = engine[channel] != nullptr ? engine[channel] + numSamples : nullptr;
+                offsetStems.motor[channel] = motor[channel] != nullptr ? motor[channel] + numSamples : nullptr;
+                offsetStems.fan[channel] = fan[channel] != nullptr ? fan[channel] + numSamples : nullptr;
+            }
+
+            return offsetStems;
+        }
+    };
+
+    //======================== mutators ===========================//
+
+    /** Sets whether the long delay lines (engine drive delays, fan delay) use 16-bit fixed point storage - call before getRequiredMemory() and prepare()
+    * @param isCompact - true for compact storage
+    */
+    void setCompactStorage (bool isCompact);
+
+    /** Returns the number of bytes of arena memory needed by the machine's models
+    * @param sampleRate - sample rate, Hz
+    */
+    size_t getRequiredMemory (double sampleRate) const;
+
+    /** Sets the sample rate, resets the smoothed controls and takes all delay lines from the arena
+    * @param sampleRate - sample rate, Hz
+    * @param arena - arena prepared with room for getRequiredMemory() bytes
+    */
+    void prepare (double sampleRate, jr::MemoryArena& arena);
+
+    /** Seeds every noise generator in the models (each model gets its own range of seeds so that their noise is uncorrelated)
+    * @param seed - seed value
+    */
+    void setRandomSeed (juce::int64 seed);
+
+    /** Sets the control values used from the next sample on. The master gain and motor max speed are smoothed, the trigger is acted on at the next sample
+    * @param newParams - control values
+    */
+    void setParams (const MachineParams& newParams);
+
+    /** Puts the machine straight into the steady state of a set of control values, as if they had been held for longer than the power up/down time:
+    the motor is fully on or fully off and the smoothed controls are at their targets. Used to warm start a render part way through a timeline
+    * @param newParams - control values
+    */
+    void setSteadyState (const MachineParams& newParams);
+
+    //======================== processing ===========================//
+
+    /** Renders a block of samples to the channels of an output layout, and writes any stems given.
+    Each source is rendered once and mixed into its channels a block at a time. The input may share memory with the output (as in a plugin's
+    buffer), as each part of the input is read before that part of the output is written
+    * @param channels - output channels, overwritten
+    * @param routing - channel indices for each source
+    * @param startSample - first sample of channels, stems and input to render to
+    * @param numSamples - number of samples to render
+    * @param stems - optional outputs for each model on its own
+    * @param inputChannels - optional audio input, mixed to mono and used according to the input mode
+    * @param numInputChannels - number of input channels
+    */
+    void process (SampleType* const* channels, const MachineOutputRouting& routing, int startSample, int numSamples, const Stems& stems = {},
+                  const SampleType* const* inputChannels = nullptr, int numInputChannels = 0);
+
+    /** Renders a block of samples to two channels
+    * @param left - left channel output
+    * @param right - right channel output
+    * @param numSamples - number of samples to render
+    * @param stems - optional outputs for each model on its own
+    */
+    void process (SampleType* left, SampleType* right, int numSamples, const Stems& stems = {});
+
+    //======================== accessors ===========================//
+
+    /** Writes the complete DSP state of the machine to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const;
+
+    /** Reads the complete DSP state of the machine from a snapshot taken at the same sample rate and storage settings
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader);
+
+    /** Returns true once the motor has been switched on by the trigger
+    */
+    bool isOn() const { return isPlaying; }
+
+    /** Returns the current value of the motor's power envelope (0-1)
+    */
+    SampleType getMotorEnvelope() const { return motor.getEnvelope(); }
+
+    /** Returns the current speed of the motor, Hz
+    */
+    SampleType getMotorSpeed() const { return motor.getCurrentSpeed(); }
+
+    /** Returns the engine speed the machine sets for a motor envelope and engine revs value
+    * @param motorEnvelope - motor power envelope (0-1)
+    * @param revs - engine revs (0-1), 0 while the machine is off
+    */
+    static SampleType getEngineSpeed (SampleType motorEnvelope, SampleType revs) { return (SampleType) ((0.10 + (0.25 * motorEnvelope)) * (1.0 + (revs * 1.37))); }
+
+    /** Returns the memory used by each model of the machine
+    */
+    jr::MemoryFootprint getEngineFootprint() const { return engine.getMemoryFootprint(); }
+    jr::MemoryFootprint getMotorFootprint() const { return motor.getMemoryFootprint(); }
+    jr::MemoryFootprint getFanFootprint() const { return fan.getMemoryFootprint(); }
+
+private:
+    ElectricMotorDC<SampleType> motor;
+    FanPropeller<SampleType> fan;
+    Engine<SampleType> engine;
+    jr::Ramp<SampleType> smoothedGain;                  // smoothed master gain value
+    jr::Ramp<SampleType> smoothedMaxSpeed;              // smoothed motor max speed value
+
+    MachineParams params;                               // current control values
+    bool isPlaying{ false };                            // true once the motor has been powered on by the trigger
+
+    SampleType inputEnvelope{};                         // current value of the input envelope follower
+    SampleType followerAttack{};                        // envelope follower attack coefficient
+    SampleType followerRelease{};                       // envelope follower release coefficient
+
+    static constexpr int chunkSize{ 64 };               // number of samples rendered per source before mixing into the output channels
+    SampleType inputChunk[chunkSize];                   // mono audio input for the current chunk
+    SampleType gainChunk[chunkSize];                    // smoothed master gain for the current chunk
+    SampleType maxSpeedChunk[chunkSize];                // smoothed motor max speed for the current chunk
+    SampleType motorChunk[chunkSize];                   // motor output for the current chunk, before the master gain
+    SampleType motorSpeedChunk[chunkSize];              // motor speed for the current chunk, Hz
+    SampleType motorEnvelopeChunk[chunkSize];           // motor power envelope for the current chunk
+    SampleType engineSpeedChunk[chunkSize];             // engine speed for the current chunk, from the motor envelope
+    SampleType engineChunk[chunkSize];                  // engine output for the current chunk, before the master gain
+    SampleType monoChunk[chunkSize];                    // engine and motor output for the current chunk
+    SampleType fanLeftChunk[chunkSize];                 // fan left (or mono) output for the current chunk
+    SampleType fanRightChunk[chunkSize];                // fan right output for the current chunk
+};
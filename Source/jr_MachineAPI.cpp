@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+    jr_MachineAPI.cpp
+
+  ==============================================================================
+*/
+
+#include "jr_MachineAPI.h"
+#include <atomic>                           // used for std::atomic
+#include <new>                              // used for std::nothrow
+#include <JuceHeader.h>
+#include "jr_Machine.h"                     // used for Machine / MachineParams
+#include "jr_RealtimeChecker.h"             // used for jr::realtime::ScopedAudioThreadCheck
+
+/** A machine with its arena, parameter queue and published state
+*/
+struct jr_machine
+{
+    /** A queued parameter change
+    */
+    struct Command
+    {
+        jr_machine_param param;
+        float value;
+    };
+
+    static constexpr int queueSize{ 512 };              // maximum number of parameter changes queued between render calls
+
+    Machine<float> machine;
+    jr::MemoryArena arena;                              // holds all of the machine's delay lines
+    MachineParams params;                               // parameter values, only used on the render thread
+
+    juce::AbstractFifo commandFifo{ queueSize };        // single producer, single consumer queue of parameter changes
+    Command commands[queueSize];                        // storage for the queue
+
+    std::atomic<int> isOn{ 0 };                         // state published at the end of each render call
+    std::atomic<float> motorEnvelope{ 0.0f };
+    std::atomic<float> motorSpeed{ 0.0f };
+    std::atomic<long long> numSamplesRendered{ 0 };
+};
+
+namespace
+{
+    /** Sets one field of a set of machine parameters
+    * @param params - parameters to update
+    * @param param - parameter to set
+    * @param value - new value
+    */
+    void applyParam (MachineParams& params, jr_machine_param param, float value)
+    {
+        switch (param)
+        {
+            case JR_MACHINE_TRIGGER:            params.trigger = value >= 0.5f; break;
+            case JR_MACHINE_MASTER_GAIN:        params.masterGain = value; break;
+            case JR_MACHINE_POWER_UP_TIME:      params.powerUpTime = value; break;
+            case JR_MACHINE_POWER_DOWN_TIME:    params.powerDownTime = value; break;
+            case JR_MACHINE_ACCELERATION:       params.acceleration = value; break;
+
+            case JR_MACHINE_MOTOR_GAIN:         params.motorGain = value; break;
+            case JR_MACHINE_MOTOR_MAX_SPEED:    params.motorMaxSpeed = value; break;
+            case JR_MACHINE_MOTOR_CASING_SIZE:  params.motorCasingSize = value; break;
+            case JR_MACHINE_MOTOR_ROTOR_LEVEL:  params.motorRotorLevel = value; break;
+            case JR_MACHINE_MOTOR_SPARKS_LEVEL: params.motorSparksLevel = value; break;
+            case JR_MACHINE_MOTOR_HUM:          params.motorHum = value >= 0.5f; break;
+
+            case JR_MACHINE_FAN_GAIN:           params.fanGain = value; break;
+            case JR_MACHINE_FAN_RATIO:          params.fanRatio = value; break;
+            case JR_MACHINE_FAN_TONE_LEVEL:     params.fanToneLevel = value; break;
+            case JR_MACHINE_FAN_NOISE_LEVEL:    params.fanNoiseLevel = value; break;
+            case JR_MACHINE_FAN_STEREO_WIDTH:   params.fanStereoWidth = value; break;
+            case JR_MACHINE_FAN_DOPPLER:        params.fanDoppler = value >= 0.5f; break;
+
+            case JR_MACHINE_ENGINE_GAIN:        params.engineGain = value; break;
+            case JR_MACHINE_ENGINE_REVS:        params.engineRevs = value; break;
+            case JR_MACHINE_ENGINE_WIDTH:       params.engineWidth = value; break;
+            case JR_MACHINE_ENGINE_LENGTH:      params.engineLength = value; break;
+            case JR_MACHINE_ENGINE_OT1:         params.engineOT1 = value; break;
+            case JR_MACHINE_ENGINE_OT2:         params.engineOT2 = value; break;
+            case JR_MACHINE_ENGINE_OT3:         params.engineOT3 = value; break;
+
+            case JR_MACHINE_NUM_PARAMS:
+            default:                            break;
+        }
+    }
+}
+
+//============================== C API ================================//
+
+jr_machine* jr_machine_create (double sampleRate, int compactStorage, long long randomSeed)
+{
+    if (sampleRate <= 0)
+        return nullptr;
+
+    auto* handle = new (std::nothrow) jr_machine();
+
+    if (handle == nullptr)
+        return nullptr;
+
+    handle->machine.setCompactStorage (compactStorage != 0);
+
+    if (! handle->arena.prepare (handle->machine.getRequiredMemory (sampleRate)))
+    {
+        delete handle;
+        return nullptr;
+    }
+
+    handle->machine.prepare (sampleRate, handle->arena);
+    handle->machine.setRandomSeed (randomSeed);
+    handle->machine.setSteadyState (handle->params);
+
+    return handle;
+}
+
+void jr_machine_destroy (jr_machine* machine)
+{
+    delete machine;
+}
+
+int jr_machine_set_param (jr_machine* machine, jr_machine_param param, float value)
+{
+    if (machine == nullptr || param < 0 || param >= JR_MACHINE_NUM_PARAMS)
+        return 0;
+
+    auto scope = machine->commandFifo.write (1);
+
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+        return 0;
+
+    machine->commands[scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2] = { param, value };
+    return 1;
+}
+
+void jr_machine_render (jr_machine* machine, float* const* channels, int numChannels, int numSamples)
+{
+    if (machine == nullptr || channels == nullptr || numChannels <= 0 || numSamples <= 0)
+        return;
+
+    juce::ScopedNoDenormals noDenormals;
+    jr::realtime::ScopedAudioThreadCheck realtimeCheck;    // debug builds: flags any allocation or lock taken during the render
+
+    // apply every parameter change queued since the last render
+    {
+        auto scope = machine->commandFifo.read (machine->commandFifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; i++)
+            applyParam (machine->params, machine->commands[scope.startIndex1 + i].param, machine->commands[scope.startIndex1 + i].value);
+
+        for (int i = 0; i < scope.blockSize2; i++)
+            applyParam (machine->params, machine->commands[scope.startIndex2 + i].param, machine->commands[scope.startIndex2 + i].value);
+    }
+
+    machine->machine.setParams (machine->params);
+
+    MachineOutputRouting routing;
+    routing.numChannels = numChannels;
+
+    if (numChannels == 1)
+    {
+        routing.left = -1;
+        routing.right = -1;
+        routing.centre = 0;
+    }
+
+    machine->machine.process (channels, routing, 0, numSamples);
+
+    machine->isOn = machine->machine.isOn() ? 1 : 0;
+    machine->motorEnvelope = machine->machine.getMotorEnvelope();
+    machine->motorSpeed = machine->machine.getMotorSpeed();
+    machine->numSamplesRendered += numSamples;
+}
+
+void jr_machine_get_state (const jr_machine* machine, jr_machine_state* state)
+{
+    if (machine == nullptr || state == nullptr)
+        return;
+
+    state->isOn = machine->isOn.load();
+    state->motorEnvelope = machine->motorEnvelope.load();
+    state->motorSpeed = machine->motorSpeed.load();
+    state->numSamplesRendered = machine->numSamplesRendered.load();
+}
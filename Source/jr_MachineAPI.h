@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    jr_MachineAPI.h
+
+    Plain C interface to the machine models (motor, fan and engine), for embedding in a game audio engine.
+    Built by MechanicalModellingLib.jucer as a static library with no GUI dependencies.
+
+    Threading: one thread (e.g. the game thread) sets parameters, one thread (e.g. the game's mixer thread) renders.
+    Parameter changes go through a lock-free queue and are applied at the start of the next render call. Nothing is
+    allocated or locked after jr_machine_create(), so jr_machine_render() is safe to call from a real-time thread.
+    Debug builds check this on every render (see jr_RealtimeChecker.h), replacing the global operator new/delete to do so;
+    define JR_REALTIME_CHECKS=0 if the game replaces them itself.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Opaque handle to a machine */
+typedef struct jr_machine jr_machine;
+
+/** Machine parameters, with the same ranges as the plugin parameters */
+typedef enum jr_machine_param
+{
+    JR_MACHINE_TRIGGER = 0,             /* 0 = off, 1 = on */
+    JR_MACHINE_MASTER_GAIN,             /* 0-1 */
+    JR_MACHINE_POWER_UP_TIME,           /* seconds, 0.5-10 */
+    JR_MACHINE_POWER_DOWN_TIME,         /* seconds, 0.5-10 */
+    JR_MACHINE_ACCELERATION,            /* 0-1 */
+
+    JR_MACHINE_MOTOR_GAIN,              /* 0-1 */
+    JR_MACHINE_MOTOR_MAX_SPEED,         /* Hz, 60-800 */
+    JR_MACHINE_MOTOR_CASING_SIZE,       /* 0-1 */
+    JR_MACHINE_MOTOR_ROTOR_LEVEL,       /* 0-1 */
+    JR_MACHINE_MOTOR_SPARKS_LEVEL,      /* 0-1 */
+    JR_MACHINE_MOTOR_HUM,               /* 0 = off, 1 = on */
+
+    JR_MACHINE_FAN_GAIN,                /* 0-1 */
+    JR_MACHINE_FAN_RATIO,               /* 10-30 */
+    JR_MACHINE_FAN_TONE_LEVEL,          /* 0-1 */
+    JR_MACHINE_FAN_NOISE_LEVEL,         /* 0-1 */
+    JR_MACHINE_FAN_STEREO_WIDTH,        /* 0-1 */
+    JR_MACHINE_FAN_DOPPLER,             /* 0 = off, 1 = on */
+
+    JR_MACHINE_ENGINE_GAIN,             /* 0-1 */
+    JR_MACHINE_ENGINE_REVS,             /* 0-1 */
+    JR_MACHINE_ENGINE_WIDTH,            /* 0-1 */
+    JR_MACHINE_ENGINE_LENGTH,           /* 0-1 */
+    JR_MACHINE_ENGINE_OT1,              /* 0-1 */
+    JR_MACHINE_ENGINE_OT2,              /* 0-1 */
+    JR_MACHINE_ENGINE_OT3,              /* 0-1 */
+
+    JR_MACHINE_NUM_PARAMS
+} jr_machine_param;
+
+/** State of a machine, as of the end of the last render call */
+typedef struct jr_machine_state
+{
+    int isOn;                           /* 1 if the machine has been switched on by the trigger */
+    float motorEnvelope;                /* power envelope of the motor, 0-1 */
+    float motorSpeed;                   /* current speed of the motor, Hz */
+    long long numSamplesRendered;       /* total samples rendered since creation */
+} jr_machine_state;
+
+/** Creates a machine, allocating all of its memory
+* @param sampleRate - sample rate, Hz
+* @param compactStorage - non-zero to store long delay lines as 16-bit fixed point, halving their memory
+* @param randomSeed - seed for the noise generators, so that renders can be repeated
+* @return machine - new machine, or NULL if it couldn't be created
+*/
+jr_machine* jr_machine_create (double sampleRate, int compactStorage, long long randomSeed);
+
+/** Destroys a machine. It must not be rendering or having parameters set on another thread
+* @param machine - machine to destroy
+*/
+void jr_machine_destroy (jr_machine* machine);
+
+/** Queues a parameter change, applied at the start of the next render call. Call from one thread only
+* @param machine - machine
+* @param param - parameter
+* @param value - new value
+* @return 1 if queued, 0 if the queue is full (render hasn't been called for a long time) or the parameter is invalid
+*/
+int jr_machine_set_param (jr_machine* machine, jr_machine_param param, float value);
+
+/** Renders a block into caller-provided buffers, overwriting them. One channel is mono, two are stereo; channels after the
+first two are cleared. Call from one thread only
+* @param machine - machine
+* @param channels - array of numChannels pointers, each to numSamples floats
+* @param numChannels - number of channels (1 or more)
+* @param numSamples - number of samples to render
+*/
+void jr_machine_render (jr_machine* machine, float* const* channels, int numChannels, int numSamples);
+
+/** Reads the state of a machine as of the end of the last render call. Can be called from any thread
+* @param machine - machine
+* @param state - state to fill in
+*/
+void jr_machine_get_state (const jr_machine* machine, jr_machine_state* state);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    jr_MachineImpostor.cpp
+
+  ==============================================================================
+*/
+
+#include "jr_MachineImpostor.h"
+#include <cmath>                            // used for std::sqrt(), std::sin(), std::cos()
+#include <memory>                           // used for std::unique_ptr
+
+//========================= MachineImpostorCache ===========================//
+
+template <typename SampleType>
+void MachineImpostorCache<SampleType>::build (const MachineParams& params, double sampleRate, const Settings& settings)
+{
+    const int numBuckets = juce::jlimit (2, maxBuckets, settings.numBuckets);
+    const int warmUpLength = juce::jmax (0, (int) (settings.warmUpSeconds * sampleRate));
+    loopLength = juce::jmax (1, (int) (settings.loopSeconds * sampleRate));
+    const int crossfadeLength = juce::jlimit (0, loopLength, (int) (settings.crossfadeSeconds * sampleRate));
+
+    cachedParams = params;
+
+    // the master gain is applied by each player, so the loops are rendered at unity gain
+    MachineParams heldParams = params;
+    heldParams.trigger = true;
+    heldParams.masterGain = 1.0f;
+    heldParams.inputMode = MachineInputMode::OFF;
+
+    loops.clear();
+    loops.resize ((size_t) numBuckets);
+
+    juce::AudioBuffer<SampleType> rendered (2, warmUpLength + loopLength + crossfadeLength);
+    jr::MemoryArena arena;
+
+    for (int bucket = 0; bucket < numBuckets; bucket++)
+    {
+        heldParams.engineRevs = (float) getBucketRevs (bucket);
+
+        auto machine = std::make_unique<Machine<SampleType>>();
+        arena.prepare (machine->getRequiredMemory (sampleRate));
+        machine->prepare (sampleRate, arena);
+        machine->setRandomSeed (settings.randomSeed + bucket);
+        machine->setSteadyState (heldParams);
+
+        SampleType* left = rendered.getWritePointer (0);
+        SampleType* right = rendered.getWritePointer (1);
+
+        for (int position = 0; position < rendered.getNumSamples(); position += blockSize)
+            machine->process (left + position, right + position, juce::jmin (blockSize, rendered.getNumSamples() - position));
+
+        // the loop starts by fading from what followed its last sample into its own first samples, so it plays back without a seam
+        auto& loop = loops[(size_t) bucket];
+        loop.setSize (2, loopLength);
+
+        for (int channel = 0; channel < 2; channel++)
+        {
+            const SampleType* source = rendered.getReadPointer (channel) + warmUpLength;
+            SampleType* dest = loop.getWritePointer (channel);
+
+            juce::FloatVectorOperations::copy (dest, source, loopLength);
+
+            for (int i = 0; i < crossfadeLength; i++)
+            {
+                SampleType fadePosition = (SampleType) ((i + 0.5) / crossfadeLength) * juce::MathConstants<SampleType>::halfPi;
+                dest[i] = (source[loopLength + i] * std::cos (fadePosition)) + (source[i] * std::sin (fadePosition));
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+bool MachineImpostorCache<SampleType>::canPlay (const MachineParams& params) const
+{
+    return isBuilt()
+        && params.trigger
+        && params.inputMode == MachineInputMode::OFF
+        && params.motorGain == cachedParams.motorGain
+        && params.motorMaxSpeed == cachedParams.motorMaxSpeed
+        && params.motorCasingSize == cachedParams.motorCasingSize
+        && params.motorRotorLevel == cachedParams.motorRotorLevel
+        && params.motorSparksLevel == cachedParams.motorSparksLevel
+        && params.motorHum == cachedParams.motorHum
+        && params.fanGain == cachedParams.fanGain
+        && params.fanRatio == cachedParams.fanRatio
+        && params.fanToneLevel == cachedParams.fanToneLevel
+        && params.fanNoiseLevel == cachedParams.fanNoiseLevel
+        && params.fanStereoWidth == cachedParams.fanStereoWidth
+        && params.fanDoppler == cachedParams.fanDoppler
+        && params.engineGain == cachedParams.engineGain
+        && params.engineWidth == cachedParams.engineWidth
+        && params.engineLength == cachedParams.engineLength
+        && params.engineOT1 == cachedParams.engineOT1
+        && params.engineOT2 == cachedParams.engineOT2
+        && params.engineOT3 == cachedParams.engineOT3;
+}
+
+template <typename SampleType>
+jr::MemoryFootprint MachineImpostorCache<SampleType>::getMemoryFootprint() const
+{
+    return { sizeof (*this), loops.size() * 2 * (size_t) loopLength * sizeof (SampleType) };
+}
+
+//=========================== MachineImpostor ==============================//
+
+template <typename SampleType>
+void MachineImpostor<SampleType>::prepare (const MachineImpostorCache<SampleType>& newCache, double sampleRate)
+{
+    jassert (newCache.isBuilt());
+
+    cache = &newCache;
+    smoothedRevs.reset (sampleRate, 0.1f);
+    smoothedGain.reset (sampleRate, 0.1f);
+    smoothedGain.setCurrentAndTargetValue (0);
+    setRandomSeed (1);
+}
+
+template <typename SampleType>
+void MachineImpostor<SampleType>::setRandomSeed (juce::int64 seed)
+{
+    random.setSeed (seed);
+
+    for (auto& position : positions)
+        position = cache != nullptr ? random.nextDouble() * cache->getLoopLength() : 0.0;
+}
+
+template <typename SampleType>
+void MachineImpostor<SampleType>::setParams (SampleType revs, SampleType gain)
+{
+    smoothedRevs.setTargetValue (juce::jlimit ((SampleType) 0, (SampleType) 1, revs));
+    smoothedGain.setTargetValue (gain);
+}
+
+template <typename SampleType>
+SampleType MachineImpostor<SampleType>::readLoop (const SampleType* loop, double position) const
+{
+    const int index = (int) position;
+    const int nextIndex = index + 1 < cache->getLoopLength() ? index + 1 : 0;
+    const SampleType fraction = (SampleType) (position - index);
+
+    return loop[index] + (fraction * (loop[nextIndex] - loop[index]));
+}
+
+template <typename SampleType>
+void MachineImpostor<SampleType>::process (SampleType* left, SampleType* right, int numSamples)
+{
+    jassert (cache != nullptr);
+
+    const int numBuckets = cache->getNumBuckets();
+    const double loopLength = cache->getLoopLength();
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        SampleType revs = smoothedRevs.getNextValue();
+        SampleType gain = smoothedGain.getNextValue();
+
+        // the buckets either side of the revs, each resampled to the engine speed of the revs
+        SampleType bucketPosition = revs * (numBuckets - 1);
+        int lowerBucket = juce::jlimit (0, numBuckets - 2, (int) bucketPosition);
+        SampleType weight = juce::jlimit ((SampleType) 0, (SampleType) 1, bucketPosition - lowerBucket);
+        SampleType bucketGains[2] = { gain * std::sqrt (1 - weight), gain * std::sqrt (weight) };
+        SampleType engineSpeed = Machine<SampleType>::getEngineSpeed (1, revs);
+
+        for (int side = 0; side < 2; side++)
+        {
+            int bucket = lowerBucket + side;
+            double& position = positions[bucket];
+
+            left[i] += bucketGains[side] * readLoop (cache->getLoop (bucket, 0), position);
+            right[i] += bucketGains[side] * readLoop (cache->getLoop (bucket, 1), position);
+
+            position += engineSpeed / Machine<SampleType>::getEngineSpeed (1, cache->getBucketRevs (bucket));
+
+            if (position >= loopLength)
+                position -= loopLength;
+        }
+    }
+}
+
+//======================= Explicit Instantiations =========================//
+
+template class MachineImpostorCache<float>;
+template class MachineImpostorCache<double>;
+template class MachineImpostor<float>;
+template class MachineImpostor<double>;
@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    jr_MachineImpostor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <vector>                           // used for std::vector
+#include <JuceHeader.h>
+#include "jr_Machine.h"                     // used for Machine / MachineParams
+
+/** A cache of steady-state loops of a running Machine, one per engine revs bucket, for playing distant or background machines as samples.
+Each loop is rendered from a Machine held on at the bucket's revs (at unity master gain) and made seamless by crossfading its tail into its head.
+Build the cache off the audio thread; once built it is read-only and can be shared by any number of MachineImpostor players
+* @tparam SampleType - float or double
+*/
+template <typename SampleType>
+class MachineImpostorCache
+{
+public:
+
+    static constexpr int maxBuckets{ 32 };  // most revs buckets a cache can hold
+
+    struct Settings
+    {
+        int numBuckets{ 8 };                // number of revs buckets, spread evenly from 0 to 1 (2 to maxBuckets)
+        double loopSeconds{ 1.0 };          // length of each loop, seconds
+        double warmUpSeconds{ 1.0 };        // time rendered before each loop so the filters and delays have settled, seconds
+        double crossfadeSeconds{ 0.05 };    // length of the crossfade that joins the end of each loop to its start, seconds
+        juce::int64 randomSeed{ 1 };        // seed for the machine rendering bucket n is randomSeed + n
+    };
+
+    /** Renders every loop. Allocates, so call off the audio thread, and not while any player is using the cache
+    * @param params - control values to hold, the trigger, engine revs and master gain are ignored
+    * @param sampleRate - sample rate, Hz
+    * @param settings - cache settings
+    */
+    void build (const MachineParams& params, double sampleRate, const Settings& settings);
+
+    /** Returns true if the cache has been built
+    */
+    bool isBuilt() const { return ! loops.empty(); }
+
+    /** Returns true if the cache can stand in for a machine with a set of control values: the machine is on, its audio input is off and all of its
+    values apart from the engine revs, master gain and power up/down controls (which don't affect the steady state) match those the cache was built from.
+    When this is false (e.g. the machine has been switched off) the full model should take over
+    * @param params - control values of the machine
+    */
+    bool canPlay (const MachineParams& params) const;
+
+    /** Returns the number of revs buckets
+    */
+    int getNumBuckets() const { return (int) loops.size(); }
+
+    /** Returns the engine revs a bucket was rendered at (0-1)
+    * @param bucket - bucket index
+    */
+    SampleType getBucketRevs (int bucket) const { return (SampleType) bucket / (SampleType) (getNumBuckets() - 1); }
+
+    /** Returns the length of every loop, samples
+    */
+    int getLoopLength() const { return loopLength; }
+
+    /** Returns one channel of a bucket's loop
+    * @param bucket - bucket index
+    * @param channel - 0 for left, 1 for right
+    */
+    const SampleType* getLoop (int bucket, int channel) const { return loops[(size_t) bucket].getReadPointer (channel); }
+
+    /** Returns the memory used by the loops
+    */
+    jr::MemoryFootprint getMemoryFootprint() const;
+
+private:
+    std::vector<juce::AudioBuffer<SampleType>> loops;   // stereo loop for each bucket
+    MachineParams cachedParams;                         // control values the cache was built from
+    int loopLength{};                                   // length of every loop, samples
+
+    static constexpr int blockSize{ 512 };              // number of samples rendered per call to the machine while building
+};
+
+/** Plays a machine from a MachineImpostorCache, for the cost of sample playback. The two loops either side of the engine revs are read at the rate
+that shifts their engine speed to the one the revs give, and crossfaded (equal power) by the revs' position between them. The motor and fan are shifted by
+the same rate, which is small within a bucket. Each player starts its loops at random positions so that many players of one cache don't sound in unison.
+While the machine is distant and steady, set the revs and gain here; when it comes close or MachineImpostorCache::canPlay() turns false, put a full
+Machine into the same steady state with Machine::setSteadyState() and crossfade to it
+* @tparam SampleType - float or double
+*/
+template <typename SampleType>
+class MachineImpostor
+{
+public:
+
+    //======================== mutators ===========================//
+
+    /** Sets the cache to play from, and the sample rate (which must match the one it was built at)
+    * @param newCache - built cache, which must outlive the player
+    * @param sampleRate - sample rate, Hz
+    */
+    void prepare (const MachineImpostorCache<SampleType>& newCache, double sampleRate);
+
+    /** Seeds the loop start positions, call after prepare()
+    * @param seed - seed value
+    */
+    void setRandomSeed (juce::int64 seed);
+
+    /** Sets the control values, smoothed over the next 100ms
+    * @param revs - engine revs (0-1)
+    * @param gain - output gain (0-1), as the machine's master gain
+    */
+    void setParams (SampleType revs, SampleType gain);
+
+    //======================== processing ===========================//
+
+    /** Adds a block of samples to two channels
+    * @param left - left channel output, added to
+    * @param right - right channel output, added to
+    * @param numSamples - number of samples to render
+    */
+    void process (SampleType* left, SampleType* right, int numSamples);
+
+private:
+
+    /** Reads a loop at a fractional position with linear interpolation
+    * @param loop - loop channel
+    * @param position - position in samples (0 to loopLength)
+    */
+    SampleType readLoop (const SampleType* loop, double position) const;
+
+    const MachineImpostorCache<SampleType>* cache{ nullptr };   // cache to play from
+    jr::Ramp<SampleType> smoothedRevs;                  // smoothed engine revs value
+    jr::Ramp<SampleType> smoothedGain;                  // smoothed output gain value
+    double positions[MachineImpostorCache<SampleType>::maxBuckets]{};   // read position in each bucket's loop, samples
+    juce::Random random;                                // random number generator for the start positions
+};
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    jr_MemoryArena.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cstdint>      // used for std::uintptr_t
+#include <cstring>      // used for std::memset()
+#include <JuceHeader.h>
+
+namespace jr {
+
+    /** Memory used by a model or component: the size of the object itself (parameters, filter/oscillator state, etc.)
+    and the size of the buffers it owns in a jr::MemoryArena
+    */
+    struct MemoryFootprint
+    {
+        size_t stateBytes{};        // bytes of object state, sizeof() the object including its members
+        size_t bufferBytes{};       // bytes of delay/scratch buffers held in the arena
+
+        /** Returns the total number of bytes used
+        */
+        size_t getTotalBytes() const { return stateBytes + bufferBytes; }
+
+        MemoryFootprint operator+ (const MemoryFootprint& other) const { return { stateBytes + other.stateBytes, bufferBytes + other.bufferBytes }; }
+    };
+
+    /** A single contiguous block of memory that holds all of the buffers (delay lines, scratch buffers) of a processor.
+    Work out the total size with getRequiredBytes() for each buffer, call prepare() with the total (off the audio thread), then hand out
+    blocks with allocate(). Every block starts on a cache line boundary so it can be used with SIMD loads, and nothing is allocated after prepare().
+    */
+    class MemoryArena
+    {
+    public:
+
+        static constexpr size_t alignment = 64;     // alignment of every block in bytes (cache line, wide enough for any SIMD register)
+
+        /** Returns the number of bytes a block of elements takes up in the arena, including the padding needed to keep the next block aligned
+        * @param numElements - number of elements of type T
+        * @return numBytes - size of block in bytes
+        */
+        template <typename T>
+        static size_t getRequiredBytes (size_t numElements)
+        {
+            return ((numElements * sizeof (T)) + alignment - 1) & ~(alignment - 1);
+        }
+
+        /** Makes sure the arena can hold numBytes, clears it and resets it so blocks are handed out from the start again.
+        Only reallocates when the arena needs to grow - must not be called from the audio thread
+        * @param numBytes - total size needed, the sum of getRequiredBytes() for every block that will be allocated
+        * @return success - false if the memory couldn't be allocated, the arena is then left empty and must not be used
+        */
+        bool prepare (size_t numBytes)
+        {
+            if (numBytes > capacity)
+            {
+                storage.allocate (numBytes + alignment, false);
+
+                if (storage.get() == nullptr)
+                {
+                    data = nullptr;
+                    capacity = size = used = 0;
+                    return false;
+                }
+
+                capacity = numBytes;
+
+                auto address = reinterpret_cast<std::uintptr_t> (storage.get());
+                data = reinterpret_cast<char*> ((address + alignment - 1) & ~(std::uintptr_t) (alignment - 1));
+            }
+
+            size = numBytes;
+            used = 0;
+
+            if (data != nullptr)
+                std::memset (data, 0, capacity);
+
+            return true;
+        }
+
+        /** Returns an aligned, zeroed block from the arena. Blocks are only valid until the next call to prepare()
+        * @param numElements - number of elements of type T
+        * @return block - pointer to the start of the block
+        */
+        template <typename T>
+        T* allocate (size_t numElements)
+        {
+            auto numBytes = getRequiredBytes<T> (numElements);
+
+            // the arena wasn't prepared with enough room - check the sizes passed to prepare() match what is allocated
+            jassert (used + numBytes <= size);
+
+            auto* block = reinterpret_cast<T*> (data + used);
+            used += numBytes;
+
+            return block;
+        }
+
+        /** Returns the size of the arena in bytes, as requested in the last call to prepare()
+        */
+        size_t getSizeInBytes() const { return size; }
+
+        /** Returns the number of bytes that have been handed out since the last call to prepare()
+        */
+        size_t getUsedBytes() const { return used; }
+
+    private:
+        juce::HeapBlock<char> storage;      // raw allocation, over-allocated by 'alignment' bytes so data can be aligned
+        char* data{ nullptr };              // aligned start of the arena within storage
+        size_t capacity{};                  // bytes available from data onwards
+        size_t size{};                      // bytes requested in last call to prepare()
+        size_t used{};                      // bytes handed out since last call to prepare()
+    };
+}
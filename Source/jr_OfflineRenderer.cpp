@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    jr_OfflineRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "jr_OfflineRenderer.h"
+#include <algorithm>                        // used for std::upper_bound()
+#include <atomic>                           // used for std::atomic
+#include <cmath>                            // used for std::ceil(), std::sin(), std::cos()
+#include <memory>                           // used for std::unique_ptr
+
+//=========================== MachineTimeline ==============================//
+
+void MachineTimeline::addControlPoint (double timeInSeconds, const MachineParams& params)
+{
+    auto position = std::upper_bound (points.begin(), points.end(), timeInSeconds,
+                                      [] (double time, const ControlPoint& point) { return time < point.timeInSeconds; });
+
+    points.insert (position, { timeInSeconds, params });
+}
+
+MachineParams MachineTimeline::getParamsAt (double timeInSeconds) const
+{
+    auto next = std::upper_bound (points.begin(), points.end(), timeInSeconds,
+                                  [] (double time, const ControlPoint& point) { return time < point.timeInSeconds; });
+
+    if (next == points.begin())
+        return {};
+
+    return std::prev (next)->params;
+}
+
+double MachineTimeline::getNextPointTimeAfter (double timeInSeconds) const
+{
+    auto next = std::upper_bound (points.begin(), points.end(), timeInSeconds,
+                                  [] (double time, const ControlPoint& point) { return time < point.timeInSeconds; });
+
+    if (next == points.end())
+        return lengthInSeconds + 1.0;
+
+    return next->timeInSeconds;
+}
+
+double MachineTimeline::getLastTriggerChangeAt (double timeInSeconds) const
+{
+    bool trigger = MachineParams().trigger;
+    double lastChange = -1.0;
+
+    for (const auto& point : points)
+    {
+        if (point.timeInSeconds > timeInSeconds)
+            break;
+
+        if (point.params.trigger != trigger)
+        {
+            trigger = point.params.trigger;
+            lastChange = point.timeInSeconds;
+        }
+    }
+
+    return lastChange;
+}
+
+//=========================== OfflineRenderer ==============================//
+
+template <typename SampleType>
+void OfflineRenderer<SampleType>::render (const MachineTimeline& timeline, juce::AudioBuffer<SampleType>& output, const Settings& settings)
+{
+    const int numSamples = (int) std::ceil (timeline.getLengthInSeconds() * settings.sampleRate);
+    const int segmentLength = juce::jmax (1, (int) (settings.segmentSeconds * settings.sampleRate));
+    const int crossfadeLength = juce::jlimit (0, segmentLength, (int) (settings.crossfadeSeconds * settings.sampleRate));
+    const int numSegments = (numSamples + segmentLength - 1) / segmentLength;
+
+    output.setSize (2, numSamples);
+    output.clear();
+
+    if (numSegments == 0)
+        return;
+
+    // segment n renders the crossfade overlap before its start into its own slot, so that no two segments write to the same memory
+    juce::AudioBuffer<SampleType> overlaps (2, juce::jmax (1, numSegments * crossfadeLength));
+    overlaps.clear();
+
+    SampleType* left = output.getWritePointer (0);
+    SampleType* right = output.getWritePointer (1);
+    SampleType* overlapLeft = overlaps.getWritePointer (0);
+    SampleType* overlapRight = overlaps.getWritePointer (1);
+
+    std::atomic<int> numSegmentsRemaining{ numSegments };
+    juce::WaitableEvent allSegmentsDone;
+
+    {
+        juce::ThreadPool pool (settings.numThreads > 0 ? settings.numThreads : juce::SystemStats::getNumCpus());
+
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            juce::int64 startSample = (juce::int64) segment * segmentLength;
+            juce::int64 endSample = juce::jmin ((juce::int64) numSamples, startSample + segmentLength);
+            int overlapLength = segment > 0 ? crossfadeLength : 0;
+            int overlapOffset = segment * crossfadeLength;
+
+            pool.addJob ([&, segment, startSample, endSample, overlapLength, overlapOffset]
+            {
+                renderSegment (timeline, settings, segment, startSample, endSample, left, right,
+                               overlapLeft + overlapOffset, overlapRight + overlapOffset, overlapLength);
+
+                if (--numSegmentsRemaining == 0)
+                    allSegmentsDone.signal();
+            });
+        }
+
+        allSegmentsDone.wait();
+    }
+
+    // equal power crossfade from the end of each segment into the overlap rendered by the next
+    for (int segment = 1; segment < numSegments; segment++)
+    {
+        int fadeStart = (segment * segmentLength) - crossfadeLength;
+        int overlapOffset = segment * crossfadeLength;
+
+        for (int i = 0; i < crossfadeLength; i++)
+        {
+            SampleType fadePosition = (SampleType) ((i + 0.5) / crossfadeLength) * juce::MathConstants<SampleType>::halfPi;
+            SampleType fadeOut = std::cos (fadePosition);
+            SampleType fadeIn = std::sin (fadePosition);
+
+            left[fadeStart + i] = (left[fadeStart + i] * fadeOut) + (overlapLeft[overlapOffset + i] * fadeIn);
+            right[fadeStart + i] = (right[fadeStart + i] * fadeOut) + (overlapRight[overlapOffset + i] * fadeIn);
+        }
+    }
+}
+
+template <typename SampleType>
+void OfflineRenderer<SampleType>::renderSegment (const MachineTimeline& timeline, const Settings& settings, int segmentIndex, juce::int64 startSample, juce::int64 endSample,
+                                                 SampleType* left, SampleType* right, SampleType* fadeLeft, SampleType* fadeRight, int crossfadeLength)
+{
+    juce::ScopedNoDenormals noDenormals;
+    const double sampleRate = settings.sampleRate;
+
+    auto machine = std::make_unique<Machine<SampleType>>();
+    jr::MemoryArena arena;
+
+    machine->setCompactStorage (settings.compactStorage);
+    arena.prepare (machine->getRequiredMemory (sampleRate));
+    machine->prepare (sampleRate, arena);
+    machine->setRandomSeed (settings.randomSeed + (segmentIndex * 1000));
+
+    const juce::int64 outputStartSample = startSample - crossfadeLength;
+    juce::int64 position = segmentIndex > 0 ? findWarmUpStart (timeline, settings, outputStartSample) : 0;
+
+    if (position > 0)
+        machine->setSteadyState (getParamsAt (timeline, settings, position / sampleRate));
+
+    // with telemetry, the values are updated once per telemetry frame
+    const juce::int64 maxBlockSize = settings.telemetry != nullptr ? juce::jlimit (1, blockSize, (int) (sampleRate / settings.telemetry->getFrameRate())) : blockSize;
+
+    SampleType blockLeft[blockSize];
+    SampleType blockRight[blockSize];
+
+    while (position < endSample)
+    {
+        double time = position / sampleRate;
+        machine->setParams (getParamsAt (timeline, settings, time));
+
+        // stop the block at the next control point so that it takes effect on the right sample
+        juce::int64 numToRender = juce::jmin (maxBlockSize, endSample - position);
+        double nextPointTime = timeline.getNextPointTimeAfter (time);
+
+        if (nextPointTime < timeline.getLengthInSeconds())
+            numToRender = juce::jlimit ((juce::int64) 1, numToRender, (juce::int64) std::ceil (nextPointTime * sampleRate) - position);
+
+        machine->process (blockLeft, blockRight, (int) numToRender);
+
+        for (int i = 0; i < numToRender; i++)
+        {
+            juce::int64 sample = position + i;
+
+            if (sample >= startSample)
+            {
+                left[sample] = blockLeft[i];
+                right[sample] = blockRight[i];
+            }
+            else if (sample >= outputStartSample)
+            {
+                fadeLeft[sample - outputStartSample] = blockLeft[i];
+                fadeRight[sample - outputStartSample] = blockRight[i];
+            }
+        }
+
+        position += numToRender;
+    }
+}
+
+template <typename SampleType>
+MachineParams OfflineRenderer<SampleType>::getParamsAt (const MachineTimeline& timeline, const Settings& settings, double timeInSeconds)
+{
+    MachineParams params = timeline.getParamsAt (timeInSeconds);
+
+    if (settings.telemetry != nullptr)
+        settings.telemetry->applyTo (params, timeInSeconds);
+
+    return params;
+}
+
+template <typename SampleType>
+juce::int64 OfflineRenderer<SampleType>::findWarmUpStart (const MachineTimeline& timeline, const Settings& settings, juce::int64 outputStartSample)
+{
+    const double sampleRate = settings.sampleRate;
+    juce::int64 warmUpStart = outputStartSample - (juce::int64) (settings.preRollSeconds * sampleRate);
+
+    // the machine can only be put into a steady state where the motor has finished powering up or down, so move back past any recent trigger change
+    while (warmUpStart > 0)
+    {
+        double time = warmUpStart / sampleRate;
+        MachineParams params = getParamsAt (timeline, settings, time);
+        double settleTime = juce::jmax (params.powerUpTime, params.powerDownTime);
+
+        // telemetry replaces the timeline's trigger, so only its changes count
+        double lastChange = settings.telemetry != nullptr ? settings.telemetry->getLastTriggerChangeWithin (time, settleTime)
+                                                          : timeline.getLastTriggerChangeAt (time);
+
+        if (lastChange < 0 || time - lastChange >= settleTime)
+            return warmUpStart;
+
+        warmUpStart = (juce::int64) ((lastChange - settleTime) * sampleRate);
+    }
+
+    return 0;
+}
+
+//======================= Explicit Instantiations =========================//
+
+template class OfflineRenderer<float>;
+template class OfflineRenderer<double>;
@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    jr_OfflineRenderer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <vector>                           // used for std::vector
+#include <JuceHeader.h>
+#include "jr_Machine.h"                     // used for Machine / MachineParams
+#include "jr_Telemetry.h"                   // used for jr::TelemetryLog
+
+/** An automation timeline for a Machine: a list of control points, each holding a full set of control values from its time onwards.
+Values are held (not interpolated) between points, the same as parameter changes arriving once per block; the machine's own smoothing does the rest
+*/
+class MachineTimeline
+{
+public:
+
+    /** A set of control values that applies from a time onwards
+    */
+    struct ControlPoint
+    {
+        double timeInSeconds{};             // time the values apply from, seconds
+        MachineParams params;               // control values
+    };
+
+    /** Adds a control point, keeping the points in time order. A point at the same time as an existing one is placed after it
+    * @param timeInSeconds - time the values apply from, seconds
+    * @param params - control values
+    */
+    void addControlPoint (double timeInSeconds, const MachineParams& params);
+
+    /** Sets the length of the timeline
+    * @param seconds - length, seconds
+    */
+    void setLengthInSeconds (double seconds) { lengthInSeconds = seconds; }
+
+    /** Returns the length of the timeline, seconds
+    */
+    double getLengthInSeconds() const { return lengthInSeconds; }
+
+    /** Returns the control values in effect at a time (the default MachineParams before the first point)
+    * @param timeInSeconds - time, seconds
+    */
+    MachineParams getParamsAt (double timeInSeconds) const;
+
+    /** Returns the time of the next control point after a time, or a time past the end of the timeline if there is none
+    * @param timeInSeconds - time, seconds
+    */
+    double getNextPointTimeAfter (double timeInSeconds) const;
+
+    /** Returns the time the trigger last changed at or before a time, or a negative value if it hasn't changed since the start of the timeline
+    * @param timeInSeconds - time, seconds
+    */
+    double getLastTriggerChangeAt (double timeInSeconds) const;
+
+private:
+    std::vector<ControlPoint> points;       // control points in time order
+    double lengthInSeconds{};               // length of the timeline, seconds
+};
+
+/** Renders a MachineTimeline offline using every core. The timeline is split into segments which are rendered in parallel on a thread pool,
+each with its own Machine and arena. Each segment (after the first) is warmed up before its start: its machine is put into the steady state of the
+timeline at the start of a pre-roll (moved back further if the motor was still powering up or down there) and the timeline is rendered through the
+pre-roll, so the envelopes, smoothed controls and filters have caught up by the time the segment starts. Oscillator phases and noise can't be warmed
+up this way, so each segment also renders a short overlap before its start which is crossfaded (equal power) with the end of the previous segment.
+Each segment is seeded from its index, so a render is repeatable whatever the number of threads.
+A telemetry log can drive the trigger, engine revs and motor speed on top of the timeline (set the timeline's length to the log's to render all of it)
+* @tparam SampleType - float or double
+*/
+template <typename SampleType>
+class OfflineRenderer
+{
+public:
+
+    struct Settings
+    {
+        double sampleRate{ 48000.0 };       // sample rate, Hz
+        double segmentSeconds{ 30.0 };      // length of each segment, seconds
+        double preRollSeconds{ 2.0 };       // length of the warm up before each segment, seconds
+        double crossfadeSeconds{ 0.05 };    // length of the crossfade at each seam, seconds
+        int numThreads{ 0 };                // number of threads to render on, 0 to use every core
+        bool compactStorage{ false };       // true to store long delay lines as 16-bit fixed point
+        juce::int64 randomSeed{ 1 };        // seed for the first segment, segment n uses randomSeed + (n * 1000)
+        const jr::TelemetryLog* telemetry{ nullptr };   // optional open log applied to the timeline's values, read by every thread
+    };
+
+    /** Renders a timeline into a stereo buffer, which is resized to the length of the timeline. Blocks until the render is complete
+    * @param timeline - timeline to render
+    * @param output - buffer to render into
+    * @param settings - render settings
+    */
+    static void render (const MachineTimeline& timeline, juce::AudioBuffer<SampleType>& output, const Settings& settings);
+
+private:
+
+    /** Renders one segment of the timeline: the warm up, the crossfade overlap and the segment itself
+    * @param timeline - timeline to render
+    * @param settings - render settings
+    * @param segmentIndex - index of the segment, used for its seed
+    * @param startSample - first sample of the segment
+    * @param endSample - sample after the last sample of the segment
+    * @param left - left channel of the whole render, the segment writes startSample to endSample
+    * @param right - right channel of the whole render
+    * @param fadeLeft - left channel of the crossfade overlap, crossfadeLength samples before startSample
+    * @param fadeRight - right channel of the crossfade overlap
+    * @param crossfadeLength - length of the overlap, samples (0 for the first segment)
+    */
+    static void renderSegment (const MachineTimeline& timeline, const Settings& settings, int segmentIndex, juce::int64 startSample, juce::int64 endSample,
+                               SampleType* left, SampleType* right, SampleType* fadeLeft, SampleType* fadeRight, int crossfadeLength);
+
+    /** Returns the control values at a time: the timeline's, with the telemetry log applied if there is one
+    * @param timeline - timeline to render
+    * @param settings - render settings
+    * @param timeInSeconds - time, seconds
+    */
+    static MachineParams getParamsAt (const MachineTimeline& timeline, const Settings& settings, double timeInSeconds);
+
+    /** Returns the sample to start warming up from so that the machine can be put into a steady state there
+    * @param timeline - timeline to render
+    * @param settings - render settings
+    * @param outputStartSample - first sample that will be kept
+    */
+    static juce::int64 findWarmUpStart (const MachineTimeline& timeline, const Settings& settings, juce::int64 outputStartSample);
+
+    static constexpr int blockSize{ 512 };  // number of samples rendered between checks for new control points (and telemetry frames, at most)
+};
@@ -16,11 +16,13 @@ namespace jr
 	//================================ Oscillator Class ===================================//
 
 	//initialise static member outside of class to a default value
-	double Oscillator::sampleRate{ 44100 };
+	template <typename SampleType>
+	SampleType Oscillator<SampleType>::sampleRate{ 44100 };
 
 	//====================== Mutator Functions ===========================//
 
-	void Oscillator::setSampleRate (double sr)
+	template <typename SampleType>
+	void Oscillator<SampleType>::setSampleRate (SampleType sr)
 	{
 		if (sr > 0)
 		{
@@ -30,12 +32,14 @@ namespace jr
 		}
 	}
 
-	void Oscillator::setMode (OscillatorMode mode)
+	template <typename SampleType>
+	void Oscillator<SampleType>::setMode (OscillatorMode mode)
 	{
 		oscMode = mode;
 	}
 
-	void Oscillator::setFrequency (double freq)
+	template <typename SampleType>
+	void Oscillator<SampleType>::setFrequency (SampleType freq)
 	{
 		if (freq > 0)
 		{
@@ -47,10 +51,11 @@ namespace jr
 
 	//======================= Accessor Functions =====================//
 
-	float Oscillator::processSingleSample()
+	template <typename SampleType>
+	SampleType Oscillator<SampleType>::processSingleSample()
 	{
 
-		float sampleOut{};
+		SampleType sampleOut{};
 
 		if (!isMuted)
 		{
@@ -65,33 +70,35 @@ namespace jr
 		return sampleOut;
 	}
 
-	float Oscillator::naiveWaveformForMode (OscillatorMode mode)
+	template <typename SampleType>
+	SampleType Oscillator<SampleType>::naiveWaveformForMode (OscillatorMode mode)
 	{
-		float value{};
+		SampleType value{};
 
 		switch (mode)
 		{
 		default:
 			// sine as default and case OscMode_Sine:
-			value = sin (twoPI * (phase + phaseShift));
+			value = std::sin (twoPI * (phase + phaseShift));
 			break;
 		case OscillatorMode::SAW:
-			value = 2 * ((phase + phaseShift) - 0.5);
+			value = 2 * ((phase + phaseShift) - (SampleType) 0.5);
 			break;
 		case OscillatorMode::SQUARE:
 			value = 1;
-			if ((phase + phaseShift) > 0.5)
+			if ((phase + phaseShift) > (SampleType) 0.5)
 				value = -1;
 			break;
 		case OscillatorMode::TRIANGLE:
-			value = 4 * fabs ((phase + phaseShift) - 0.5);
+			value = 4 * std::abs ((phase + phaseShift) - (SampleType) 0.5);
 			break;
 		}
 
 		return value;
 	}
 
-	void Oscillator::processNextBlock (float* buffer, int numSamples)
+	template <typename SampleType>
+	void Oscillator<SampleType>::processNextBlock (SampleType* buffer, int numSamples)
 	{
 		for (size_t i = 0; i < numSamples; i++)
 		{
@@ -103,25 +110,31 @@ namespace jr
 
 	//======================= Accessor Functions =====================//
 
-	float polyblepOscillator::processSingleSample()
+	template <typename SampleType>
+	SampleType polyblepOscillator<SampleType>::processSingleSample()
 	{
-		float sampleOut{};
+		auto& phase = this->phase;
+		auto& phaseShift = this->phaseShift;
+		auto& phaseDelta = this->phaseDelta;
+		auto oscMode = this->oscMode;
+
+		SampleType sampleOut{};
 
 		if (oscMode == OscillatorMode::SINE)
 		{
-			sampleOut = naiveWaveformForMode (oscMode);
+			sampleOut = this->naiveWaveformForMode (oscMode);
 		}
 		else if (oscMode == OscillatorMode::SAW)
 		{
-			sampleOut = naiveWaveformForMode (oscMode);
+			sampleOut = this->naiveWaveformForMode (oscMode);
 			sampleOut -= polyBLEP ((phase + phaseShift));
 		}
 		else
 		{
 			// square wave
-			sampleOut = naiveWaveformForMode (OscillatorMode::SQUARE);
+			sampleOut = this->naiveWaveformForMode (OscillatorMode::SQUARE);
 			sampleOut += polyBLEP ((phase + phaseShift));
-			sampleOut -= polyBLEP (std::fmod ((phase + phaseShift) + 0.5, 1.0));			// fmod() clamps phase between 0-1 whilst offsetting value by 0.5
+			sampleOut -= polyBLEP (std::fmod ((phase + phaseShift) + (SampleType) 0.5, (SampleType) 1));	// fmod() clamps phase between 0-1 whilst offsetting value by 0.5
 
 			if (oscMode == OscillatorMode::TRIANGLE)
 			{
@@ -137,18 +150,28 @@ namespace jr
 		return sampleOut;
 	}
 
-	double polyblepOscillator::polyBLEP (double t)
+	template <typename SampleType>
+	SampleType polyblepOscillator<SampleType>::polyBLEP (SampleType t)
 	{
+		auto phaseDelta = this->phaseDelta;
+
 		if (t < phaseDelta)
 		{
 			t /= phaseDelta;
-			return (t + t - (t * t) - 1.0);
+			return (t + t - (t * t) - 1);
 		}
-		else if (t > (1.0 - phaseDelta))
+		else if (t > (1 - phaseDelta))
 		{
-			t = (t - 1.0) / phaseDelta;
-			return ((t * t) + t + t + 1.0);
+			t = (t - 1) / phaseDelta;
+			return ((t * t) + t + t + 1);
 		}
-		else	return 0.0;
+		else	return 0;
 	}
-};
\ No newline at end of file
+
+	//============================ explicit instantiations ===============================//
+
+	template class Oscillator<float>;
+	template class Oscillator<double>;
+	template class polyblepOscillator<float>;
+	template class polyblepOscillator<double>;
+};
@@ -1,14 +1,17 @@
 #pragma once
 	
 #include <cmath>		// used for sin() and fabs() and std::fmod()
+#include "jr_Snapshot.h"	// used for jr::SnapshotWriter / SnapshotReader
 
 namespace jr {
 	
 	/** An Oscillator that can be set to either Sine, Sawtooth, Square, or Triangle mode. 
 	Oscillator starts muted so use setMuted() to unmute, and use setSampleRate() before use 
-	(static member so only needs to be set once for all instances)
+	(static member so only needs to be set once for all instances of the same sample type)
 	* Derived from Martin Finke's Oscillator class from this tutorial: http://www.martin-finke.de/blog/articles/audio-plugins-018-polyblep-oscillator/
+	* @tparam SampleType - float or double, used for the phase and all calculations
 	*/
+	template <typename SampleType>
 	class Oscillator
 	{
 	public:
@@ -22,17 +25,17 @@ namespace jr {
 
 		//==================== Constructors/Destructos =======================//
 
-		Oscillator() : oscMode (OscillatorMode::SINE), PI (2 * acos(0.0)), twoPI (2 * PI),
-			isMuted (true), frequency (440.0), phase (0.0), phaseDelta (0.0) {}
+		Oscillator() : oscMode (OscillatorMode::SINE), frequency (440.0), phase (0.0), phaseDelta (0.0),
+			isMuted (true), PI ((SampleType) (2 * acos (0.0))), twoPI (2 * PI) {}
 
-		~Oscillator() {}
+		virtual ~Oscillator() {}
 
 		//====================== Mutator Functions ===========================//
 
 		/** Sets the sample rate of all instances of Oscillator
 		* @param sr - sample rate, Hz
 		*/
-		void setSampleRate (double sr);
+		void setSampleRate (SampleType sr);
 
 		/** Sets the mode of the Oscillator to either: "SINE/SQUARE/SAW/TRIANGLE"
 		* @param mode - type OscillatorMode e.g. SINE
@@ -43,7 +46,7 @@ namespace jr {
 		* Sets the frequency of the Oscillator
 		* @param freq - frequency, Hz
 		*/
-		void setFrequency (double freq);
+		void setFrequency (SampleType freq);
 
 		/**
 		* Mutes or unmutes the Oscillator
@@ -55,12 +58,12 @@ namespace jr {
 		* Resets the Oscillator by setting the phase to 0
 		* @return
 		*/
-		inline void reset() { phase = 0.0f; }
+		inline void reset() { phase = 0; }
 
 		/** Sets the phase shift amount of the oscillator, used to stagger phase of multiple oscillators
 		* @param shiftAmount - phase shift amount (0-0.5)
 		*/
-		inline void setPhaseShift (double shiftAmount) { if (shiftAmount <= 0 && shiftAmount <= 0.5) phaseShift = shiftAmount; }
+		inline void setPhaseShift (SampleType shiftAmount) { if (shiftAmount <= 0 && shiftAmount <= 0.5) phaseShift = shiftAmount; }
 
 		//======================= Accessor Functions =====================//
 
@@ -68,38 +71,50 @@ namespace jr {
 		* Processes the Oscillator and returns the next sample value
 		* @return sampleOut
 		*/
-		virtual float processSingleSample();
+		virtual SampleType processSingleSample();
 
 		/**
 		* returns the next sample value for a naive waveform (unprotected from aliasing) according to a certain Oscillator Mode
 		* @param mode - mode corresponding to waveform type i.e. SINE (or SQUARE/SAW/TRIANGLE)
 		* @return value - next sample value for naive waveform
 		*/
-		float naiveWaveformForMode (OscillatorMode mode);
+		SampleType naiveWaveformForMode (OscillatorMode mode);
 
 		/**
 		* Processes a block of samples
 		* @param buffer - buffer to read samples into
 		* @param numSamples - buffer block size in samples
 		*/
-		void processNextBlock (float* buffer, int numSamples);
+		void processNextBlock (SampleType* buffer, int numSamples);
+
+		/**
+		* Writes the phase and settings of the Oscillator to a snapshot (the shared sample rate is not included)
+		* @param writer - snapshot writer
+		*/
+		void saveState (SnapshotWriter& writer) const { writer.write (oscMode, frequency, phase, phaseDelta, isMuted, phaseShift); }
+
+		/**
+		* Reads the phase and settings of the Oscillator from a snapshot
+		* @param reader - snapshot reader
+		*/
+		void loadState (SnapshotReader& reader) { reader.read (oscMode, frequency, phase, phaseDelta, isMuted, phaseShift); }
 
 	protected:
 
 		//============== params ===============//
 
-		static double sampleRate;			// Hz
+		static SampleType sampleRate;		// Hz
 		OscillatorMode oscMode;				// mode determining waveform type
-		double frequency;					// Hz
-		double phase;
-		double phaseDelta;
+		SampleType frequency;				// Hz
+		SampleType phase;
+		SampleType phaseDelta;
 		bool isMuted;						// true when Oscillator is muted
-		double phaseShift{};				// phase shift amount, used to stagger phase of multiple instances (0-0.5)
+		SampleType phaseShift{};			// phase shift amount, used to stagger phase of multiple instances (0-0.5)
 
 		//================= constants =============//
 
-		const double PI;					// mathematical constant pi
-		const double twoPI;					// two * mathematical constant pi
+		const SampleType PI;				// mathematical constant pi
+		const SampleType twoPI;				// two * mathematical constant pi
 
 		//================= functions =============//
 
@@ -116,22 +131,45 @@ namespace jr {
 	/** An Oscillator that uses the polyBLEP algorithm for anti-aliasing
 	* Derived from Martin Finke's Oscillator class from this tutorial: http://www.martin-finke.de/blog/articles/audio-plugins-018-polyblep-oscillator/
 	*/
-	class polyblepOscillator : public Oscillator
+	template <typename SampleType>
+	class polyblepOscillator : public Oscillator<SampleType>
 	{
 	public:
 
+		using OscillatorMode = typename Oscillator<SampleType>::OscillatorMode;
+
 		//======================= Accessor Functions =====================//
 
 		/**
 		* Processes the Oscillator and returns the next sample value
 		* @return sampleOut
 		*/
-		float processSingleSample() override;
+		SampleType processSingleSample() override;
+
+		/**
+		* Writes the phase, settings and last output of the Oscillator to a snapshot
+		* @param writer - snapshot writer
+		*/
+		void saveState (SnapshotWriter& writer) const
+		{
+			Oscillator<SampleType>::saveState (writer);
+			writer.write (lastOutput);
+		}
+
+		/**
+		* Reads the phase, settings and last output of the Oscillator from a snapshot
+		* @param reader - snapshot reader
+		*/
+		void loadState (SnapshotReader& reader)
+		{
+			Oscillator<SampleType>::loadState (reader);
+			reader.read (lastOutput);
+		}
 
 	private:
 		//============= parameters ============//
 
-		float lastOutput;		// last sample value to be output, used for triangle wave BLEP
+		SampleType lastOutput{};	// last sample value to be output, used for triangle wave BLEP
 
 		//============== functions ============//
 
@@ -140,7 +178,7 @@ namespace jr {
 		* @param t - phase (0-1)
 		* @return adjustment - sample adjustment amount
 		*/
-		double polyBLEP (double t);
+		SampleType polyBLEP (SampleType t);
 
 	};
 	
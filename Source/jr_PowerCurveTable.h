@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    jr_PowerCurveTable.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cmath>        // used for std::pow()
+#include <JuceHeader.h>
+
+namespace jr {
+
+    /** A table of the motor power up curve, 1 - (1 - phase) ^ (3 + (6 * accelRate)), over phase (0-1) and acceleration rate (0-1).
+    The curve's shape doesn't depend on the power up time or sample rate (they only set how fast the phase moves), so one read-only table
+    serves every MotorEnvelope. Values are interpolated bilinearly, within 0.03% of the curve
+    * @tparam SampleType - float or double
+    */
+    template <typename SampleType>
+    class PowerCurveTable
+    {
+    public:
+
+        static constexpr int numPhaseSteps{ 1024 };     // intervals along the phase axis
+        static constexpr int numRateSteps{ 32 };        // intervals along the acceleration rate axis
+
+        /** Returns the shared table, building it on first use. The first call must be made off the audio thread (MotorEnvelope makes it when constructed)
+        */
+        static const PowerCurveTable& getShared()
+        {
+            static const PowerCurveTable table;
+            return table;
+        }
+
+        /** Returns the exponent of the curve for an acceleration rate
+        * @param accelRate - acceleration rate (0-1)
+        */
+        static SampleType getExponent (SampleType accelRate) { return (SampleType) 3 + (accelRate * (SampleType) 6); }
+
+        /** Returns the value of the curve
+        * @param accelRate - acceleration rate (0-1)
+        * @param phase - position through the power up (0-1)
+        */
+        SampleType getValue (SampleType accelRate, SampleType phase) const
+        {
+            SampleType ratePosition = juce::jlimit ((SampleType) 0, (SampleType) 1, accelRate) * numRateSteps;
+            SampleType phasePosition = juce::jlimit ((SampleType) 0, (SampleType) 1, phase) * numPhaseSteps;
+            int rateIndex = juce::jmin ((int) ratePosition, numRateSteps - 1);
+            int phaseIndex = juce::jmin ((int) phasePosition, numPhaseSteps - 1);
+            SampleType rateFraction = ratePosition - rateIndex;
+            SampleType phaseFraction = phasePosition - phaseIndex;
+
+            const SampleType* row = table + (rateIndex * rowLength) + phaseIndex;
+            const SampleType* nextRow = row + rowLength;
+
+            SampleType value = row[0] + (phaseFraction * (row[1] - row[0]));
+            SampleType nextValue = nextRow[0] + (phaseFraction * (nextRow[1] - nextRow[0]));
+
+            return value + (rateFraction * (nextValue - value));
+        }
+
+    private:
+
+        PowerCurveTable()
+        {
+            for (int rate = 0; rate <= numRateSteps; rate++)
+            {
+                double exponent = getExponent ((SampleType) rate / numRateSteps);
+
+                for (int step = 0; step <= numPhaseSteps; step++)
+                    table[(rate * rowLength) + step] = (SampleType) (1.0 - std::pow (1.0 - ((double) step / numPhaseSteps), exponent));
+            }
+        }
+
+        static constexpr int rowLength{ numPhaseSteps + 1 };                // values per acceleration rate
+        SampleType table[(numRateSteps + 1) * rowLength];                   // curve values, a row of phases for each acceleration rate
+    };
+}
@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    jr_QuadraturePhasor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cmath>        // used for std::sin(), std::cos()
+#include <JuceHeader.h>
+#include "jr_Snapshot.h"    // used for jr::SnapshotWriter / SnapshotReader
+
+namespace jr {
+
+    /** A phasor that gives its phase along with the sine and cosine of it, without trig calls per sample. The sine and cosine are a unit vector
+    rotated each sample by a complex multiply, and the rotation is set from a polynomial of the phase increment. Every resyncInterval samples
+    the vector is set exactly from the phase, which renormalises it and keeps it locked to the phase
+    * @tparam SampleType - float or double
+    */
+    template <typename SampleType>
+    class QuadraturePhasor
+    {
+    public:
+
+        static constexpr int resyncInterval{ 256 };    // samples between exact settings of the sine and cosine
+
+        /** Sets the sample rate, keeping the frequency
+        * @param sr - sample rate, Hz
+        */
+        void setSampleRate (SampleType sr)
+        {
+            sampleRate = sr;
+            updateRotation();
+        }
+
+        /** Sets the frequency, which can be called every sample. A frequency at or below 0 is ignored, keeping the last one, so the phase only moves forwards
+        * @param frequency - frequency, Hz, accurate up to an eighth of the sample rate
+        */
+        void setFrequency (SampleType frequency)
+        {
+            if (frequency > 0 && frequency != this->frequency)
+            {
+                this->frequency = frequency;
+                updateRotation();
+            }
+        }
+
+        /** Returns the phase increment per sample
+        */
+        SampleType getPhaseDelta() const { return phaseDelta; }
+
+        /** Sets the phase to 0
+        */
+        void reset()
+        {
+            phase = 0;
+            resync();
+        }
+
+        /** Returns the phase (0-1)
+        */
+        SampleType getPhase() const { return phase; }
+
+        /** Returns sin (2pi * phase)
+        */
+        SampleType getSine() const { return sine; }
+
+        /** Returns cos (2pi * phase), which is the sine a quarter of a cycle ahead
+        */
+        SampleType getCosine() const { return cosine; }
+
+        /** Moves the phase, sine and cosine on by one sample
+        */
+        void advance()
+        {
+            phase += phaseDelta;
+
+            if (phase >= 1)
+                phase -= 1;
+
+            if (--samplesToResync <= 0)
+            {
+                resync();
+                return;
+            }
+
+            SampleType nextSine = (sine * rotationCos) + (cosine * rotationSin);
+            cosine = (cosine * rotationCos) - (sine * rotationSin);
+            sine = nextSine;
+        }
+
+        /** Writes the phase, frequency and rotation to a snapshot
+        */
+        void saveState (SnapshotWriter& writer) const { writer.write (sampleRate, frequency, phaseDelta, rotationCos, rotationSin, phase, sine, cosine, samplesToResync); }
+
+        /** Reads the phase, frequency and rotation from a snapshot
+        */
+        void loadState (SnapshotReader& reader) { reader.read (sampleRate, frequency, phaseDelta, rotationCos, rotationSin, phase, sine, cosine, samplesToResync); }
+
+    private:
+
+        /** Sets the sine and cosine exactly from the phase
+        */
+        void resync()
+        {
+            sine = std::sin (juce::MathConstants<SampleType>::twoPi * phase);
+            cosine = std::cos (juce::MathConstants<SampleType>::twoPi * phase);
+            samplesToResync = resyncInterval;
+        }
+
+        /** Updates the phase increment and the rotation per sample, called each time the sample rate or frequency is changed.
+        The rotation uses Taylor series of sin() and cos(), within 1e-8 of them up to an eighth of a cycle per sample
+        */
+        void updateRotation()
+        {
+            phaseDelta = frequency / sampleRate;
+
+            SampleType x = juce::MathConstants<SampleType>::twoPi * phaseDelta;
+            SampleType xSquared = x * x;
+
+            rotationSin = x * (1 - (xSquared / 6) * (1 - (xSquared / 20) * (1 - (xSquared / 42) * (1 - (xSquared / 72)))));
+            rotationCos = 1 - (xSquared / 2) * (1 - (xSquared / 12) * (1 - (xSquared / 30) * (1 - (xSquared / 56) * (1 - (xSquared / 90)))));
+        }
+
+        SampleType sampleRate{ 44100 };                 // sample rate, Hz
+        SampleType frequency{ 440 };                    // frequency, Hz (440 until set, as jr::Oscillator)
+        SampleType phaseDelta{};                        // phase increment per sample
+        SampleType rotationCos{ 1 }, rotationSin{};     // rotation applied to the sine and cosine each sample
+        SampleType phase{};                             // position through the current cycle (0-1)
+        SampleType sine{}, cosine{ 1 };                 // sine and cosine of the phase
+        int samplesToResync{ resyncInterval };          // samples until the sine and cosine are next set from the phase
+    };
+}
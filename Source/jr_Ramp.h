@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+
+    jr_Ramp.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cmath>        // used for std::exp(), std::log(), std::abs(), std::floor()
+#include <JuceHeader.h>
+
+namespace jr {
+
+    /** Shape of a Ramp
+    */
+    enum class RampType
+    {
+        LINEAR = 0,                         // equal steps, as juce::ValueSmoothingTypes::Linear
+        MULTIPLICATIVE                      // equal ratios, as juce::ValueSmoothingTypes::Multiplicative (values must be non-zero and of one sign)
+    };
+
+    /** A smoothed value that ramps to its target over a fixed number of samples. Per sample it behaves exactly like juce::SmoothedValue,
+    and it can also write or apply a whole block of the ramp at once: once the target is reached those are a plain (vectorised) fill or
+    multiply, skipped for a gain of 1
+    * @tparam SampleType - float or double
+    * @tparam rampType - linear or multiplicative steps
+    */
+    template <typename SampleType, RampType rampType = RampType::LINEAR>
+    class Ramp
+    {
+    public:
+
+        /** Sets the ramp length and jumps to the target
+        * @param sampleRate - sample rate, Hz
+        * @param rampLengthInSeconds - time taken to reach a new target, seconds
+        */
+        void reset (double sampleRate, double rampLengthInSeconds)
+        {
+            jassert (sampleRate > 0 && rampLengthInSeconds >= 0);
+            stepsToTarget = (int) std::floor (rampLengthInSeconds * sampleRate);
+            setCurrentAndTargetValue (target);
+        }
+
+        /** Sets the current value and the target, stopping any ramp
+        * @param newValue - value
+        */
+        void setCurrentAndTargetValue (SampleType newValue)
+        {
+            target = current = newValue;
+            countdown = 0;
+        }
+
+        /** Starts a ramp from the current value to a new target
+        * @param newValue - target value
+        */
+        void setTargetValue (SampleType newValue)
+        {
+            if (newValue == target)
+                return;
+
+            if (stepsToTarget <= 0)
+            {
+                setCurrentAndTargetValue (newValue);
+                return;
+            }
+
+            target = newValue;
+            countdown = stepsToTarget;
+
+            if (rampType == RampType::LINEAR)
+                step = (target - current) / (SampleType) countdown;
+            else
+                step = std::exp ((std::log (std::abs (target)) - std::log (std::abs (current))) / (SampleType) countdown);
+        }
+
+        /** Returns true while ramping
+        */
+        bool isSmoothing() const { return countdown > 0; }
+
+        /** Returns the current value
+        */
+        SampleType getCurrentValue() const { return current; }
+
+        /** Returns the target value
+        */
+        SampleType getTargetValue() const { return target; }
+
+        /** Moves one sample along the ramp and returns the new value
+        */
+        SampleType getNextValue()
+        {
+            if (! isSmoothing())
+                return target;
+
+            --countdown;
+
+            if (isSmoothing())
+                current = rampType == RampType::LINEAR ? current + step : current * step;
+            else
+                current = target;
+
+            return current;
+        }
+
+        /** Writes the next values of the ramp to a block, moving along it
+        * @param dest - block to write
+        * @param numSamples - number of samples
+        */
+        void fillBlock (SampleType* dest, int numSamples)
+        {
+            const int numRamp = processRamp (numSamples, [dest] (int i, SampleType value) { dest[i] = value; });
+
+            if (numRamp < numSamples)
+                juce::FloatVectorOperations::fill (dest + numRamp, target, numSamples - numRamp);
+        }
+
+        /** Multiplies a block by the next values of the ramp, moving along it. A steady gain of 1 does no work
+        * @param data - block to multiply in place
+        * @param numSamples - number of samples
+        */
+        void applyGain (SampleType* data, int numSamples)
+        {
+            const int numRamp = processRamp (numSamples, [data] (int i, SampleType value) { data[i] *= value; });
+
+            if (numRamp < numSamples && target != (SampleType) 1)
+                juce::FloatVectorOperations::multiply (data + numRamp, target, numSamples - numRamp);
+        }
+
+        /** Moves a number of samples along the ramp without producing them
+        * @param numSamples - number of samples
+        */
+        void skip (int numSamples)
+        {
+            processRamp (numSamples, [] (int, SampleType) {});
+        }
+
+    private:
+
+        /** Passes each value of the ramp to a function, up to a number of samples or the end of the ramp, and moves along it
+        * @param numSamples - most samples to produce
+        * @param function - called with the index and value of each sample
+        * @return number of samples produced
+        */
+        template <typename Function>
+        int processRamp (int numSamples, Function&& function)
+        {
+            const int numRamp = juce::jmin (numSamples, countdown);
+
+            if (numRamp <= 0)
+                return 0;
+
+            // the last sample of the ramp lands exactly on the target
+            const bool reachesTarget = numRamp == countdown;
+            const int numSteps = reachesTarget ? numRamp - 1 : numRamp;
+
+            if (rampType == RampType::LINEAR)
+            {
+                // a running sum, as juce::SmoothedValue, so the ramp matches it exactly
+                for (int i = 0; i < numSteps; i++)
+                {
+                    current += step;
+                    function (i, current);
+                }
+            }
+            else
+            {
+                for (int i = 0; i < numSteps; i++)
+                {
+                    current *= step;
+                    function (i, current);
+                }
+            }
+
+            if (reachesTarget)
+            {
+                function (numRamp - 1, target);
+                current = target;
+            }
+
+            countdown -= numRamp;
+            return numRamp;
+        }
+
+        SampleType current{};               // current value
+        SampleType target{};                // value being ramped to
+        SampleType step{};                  // amount added (linear) or ratio applied (multiplicative) each sample
+        int countdown{};                    // samples left in the ramp
+        int stepsToTarget{};                // length of a ramp, samples
+    };
+}
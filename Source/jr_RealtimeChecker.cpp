@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    jr_RealtimeChecker.cpp
+
+  ==============================================================================
+*/
+
+#include "jr_RealtimeChecker.h"
+
+#if JR_REALTIME_CHECKS
+
+#include <cstdlib>      // used for std::malloc() and std::free()
+#include <new>          // used for std::bad_alloc, std::nothrow_t and std::align_val_t
+
+#if JUCE_WINDOWS
+ #include <malloc.h>    // used for _aligned_malloc() and _aligned_free()
+#endif
+
+#if JUCE_LINUX
+ #include <dlfcn.h>     // used for dlsym()
+ #include <pthread.h>   // used for pthread_mutex_t
+#endif
+
+namespace
+{
+    // counters are only touched from the thread that owns them, and are trivially initialised so are safe to use from within operator new
+    thread_local bool isInAudioCallback{ false };      // true whilst a ScopedAudioThreadCheck is alive on this thread
+    thread_local int numAllocations{};                  // number of calls to operator new during the current callback
+    thread_local int numDeallocations{};                // number of calls to operator delete during the current callback
+    thread_local int numLocks{};                        // number of locks reported during the current callback
+
+    std::atomic<bool> allocationReported{ false };      // true once an allocation violation has been logged
+    std::atomic<bool> lockReported{ false };            // true once a lock violation has been logged
+    std::atomic<int> numViolations{};                   // number of callbacks that have allocated, deallocated or locked
+
+    /** Counts an allocation and returns memory from malloc, or nullptr if there is none
+    * @param size - number of bytes
+    */
+    void* allocate (std::size_t size) noexcept
+    {
+        if (isInAudioCallback)
+            ++numAllocations;
+
+        return std::malloc (size == 0 ? 1 : size);
+    }
+
+    /** Counts an aligned allocation and returns aligned memory, or nullptr if there is none
+    * @param size - number of bytes
+    * @param alignment - alignment, a power of 2
+    */
+    void* allocateAligned (std::size_t size, std::align_val_t alignment) noexcept
+    {
+        if (isInAudioCallback)
+            ++numAllocations;
+
+        auto align = juce::jmax ((std::size_t) alignment, sizeof (void*));
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc (size == 0 ? 1 : size, align);
+       #else
+        // aligned_alloc() needs the size to be a multiple of the alignment
+        return std::aligned_alloc (align, ((size + align - 1) / align) * align);
+       #endif
+    }
+
+    /** Counts a deallocation and frees memory from allocate()
+    * @param ptr - memory to free, or nullptr
+    */
+    void deallocate (void* ptr) noexcept
+    {
+        if (ptr != nullptr && isInAudioCallback)
+            ++numDeallocations;
+
+        std::free (ptr);
+    }
+
+    /** Counts a deallocation and frees memory from allocateAligned()
+    * @param ptr - memory to free, or nullptr
+    */
+    void deallocateAligned (void* ptr) noexcept
+    {
+        if (ptr != nullptr && isInAudioCallback)
+            ++numDeallocations;
+
+       #if JUCE_WINDOWS
+        _aligned_free (ptr);
+       #else
+        std::free (ptr);
+       #endif
+    }
+}
+
+//============================ global allocation hooks =================================//
+
+void* operator new (std::size_t size)
+{
+    if (auto* ptr = allocate (size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate (size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate (size);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    if (auto* ptr = allocateAligned (size, alignment))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    return operator new (size, alignment);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned (size, alignment);
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned (size, alignment);
+}
+
+void operator delete (void* ptr) noexcept                                                   { deallocate (ptr); }
+void operator delete[] (void* ptr) noexcept                                                 { deallocate (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept                                      { deallocate (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept                                    { deallocate (ptr); }
+void operator delete (void* ptr, const std::nothrow_t&) noexcept                            { deallocate (ptr); }
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept                          { deallocate (ptr); }
+
+void operator delete (void* ptr, std::align_val_t) noexcept                                 { deallocateAligned (ptr); }
+void operator delete[] (void* ptr, std::align_val_t) noexcept                               { deallocateAligned (ptr); }
+void operator delete (void* ptr, std::size_t, std::align_val_t) noexcept                    { deallocateAligned (ptr); }
+void operator delete[] (void* ptr, std::size_t, std::align_val_t) noexcept                  { deallocateAligned (ptr); }
+void operator delete (void* ptr, std::align_val_t, const std::nothrow_t&) noexcept          { deallocateAligned (ptr); }
+void operator delete[] (void* ptr, std::align_val_t, const std::nothrow_t&) noexcept        { deallocateAligned (ptr); }
+
+//============================ lock hook =================================//
+
+#if JUCE_LINUX
+namespace
+{
+    using LockFunction = int (*) (pthread_mutex_t*);
+
+    // looked up on first use rather than held in a function-local static, as the guard of one can take a mutex itself
+    std::atomic<LockFunction> realLock{ nullptr };      // the C library's pthread_mutex_lock()
+}
+
+/** Counts a lock and passes it on to the C library. juce::CriticalSection and std::mutex both lock through here
+*/
+extern "C" int pthread_mutex_lock (pthread_mutex_t* mutex)
+{
+    auto lock = realLock.load (std::memory_order_relaxed);
+
+    if (lock == nullptr)
+    {
+        lock = reinterpret_cast<LockFunction> (dlsym (RTLD_NEXT, "pthread_mutex_lock"));
+        realLock.store (lock, std::memory_order_relaxed);
+    }
+
+    jr::realtime::notifyLock();
+    return lock (mutex);
+}
+#endif
+
+//============================ audio thread scope =================================//
+
+namespace jr {
+namespace realtime {
+
+    ScopedAudioThreadCheck::ScopedAudioThreadCheck()
+    {
+        numAllocations = 0;
+        numDeallocations = 0;
+        numLocks = 0;
+        isInAudioCallback = true;
+    }
+
+    ScopedAudioThreadCheck::~ScopedAudioThreadCheck()
+    {
+        // stop counting before logging, as building the message allocates
+        isInAudioCallback = false;
+
+        if (numAllocations > 0 || numDeallocations > 0 || numLocks > 0)
+            ++numViolations;
+
+        if ((numAllocations > 0 || numDeallocations > 0) && ! allocationReported.exchange (true))
+        {
+            DBG ("Realtime check: " << numAllocations << " allocation(s) and " << numDeallocations << " deallocation(s) on the audio thread");
+            jassertfalse;
+        }
+
+        if (numLocks > 0 && ! lockReported.exchange (true))
+        {
+            DBG ("Realtime check: " << numLocks << " lock(s) taken on the audio thread");
+            jassertfalse;
+        }
+    }
+
+    void notifyLock()
+    {
+        if (isInAudioCallback)
+            ++numLocks;
+    }
+
+    bool isAudioThread()
+    {
+        return isInAudioCallback;
+    }
+
+    int getNumViolations()
+    {
+        return numViolations.load();
+    }
+}
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    jr_RealtimeChecker.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/** Enables the audio thread instrumentation - on by default in debug builds only, define JR_REALTIME_CHECKS=1 to force it on in other builds
+*/
+#ifndef JR_REALTIME_CHECKS
+ #if JUCE_DEBUG
+  #define JR_REALTIME_CHECKS 1
+ #else
+  #define JR_REALTIME_CHECKS 0
+ #endif
+#endif
+
+namespace jr {
+namespace realtime {
+
+    /** Marks the current thread as being inside an audio callback (e.g. processBlock()) for the lifetime of the object.
+    Whilst marked, every call to global operator new/delete (including the aligned and nothrow forms) and every lock taken is counted, and on
+    destruction any violations are logged and asserted (once per kind of violation, so the debugger isn't interrupted every block).
+    Locks are counted through notifyLock(), which the checked locks below call, and on Linux every pthread_mutex_lock() (juce::CriticalSection,
+    std::mutex) is hooked as well. In a plugin loaded by a host the host's C library is found first, so there only the checked locks are counted.
+    Scopes don't nest. Compiles to nothing when JR_REALTIME_CHECKS is 0.
+    */
+    class ScopedAudioThreadCheck
+    {
+    public:
+       #if JR_REALTIME_CHECKS
+        ScopedAudioThreadCheck();
+        ~ScopedAudioThreadCheck();
+       #else
+        ScopedAudioThreadCheck() {}
+        ~ScopedAudioThreadCheck() {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedAudioThreadCheck)
+    };
+
+    /** Reports that a lock is about to be taken. Called by the checked locks, and by the pthread_mutex_lock() hook on Linux
+    */
+   #if JR_REALTIME_CHECKS
+    void notifyLock();
+   #else
+    inline void notifyLock() {}
+   #endif
+
+    /** Returns true if the calling thread is currently inside a ScopedAudioThreadCheck
+    */
+   #if JR_REALTIME_CHECKS
+    bool isAudioThread();
+   #else
+    inline bool isAudioThread() { return false; }
+   #endif
+
+    /** Returns the number of ScopedAudioThreadChecks, on any thread, that have seen an allocation, deallocation or lock since the program started
+    (always 0 when JR_REALTIME_CHECKS is 0)
+    */
+   #if JR_REALTIME_CHECKS
+    int getNumViolations();
+   #else
+    inline int getNumViolations() { return 0; }
+   #endif
+
+    /** A lock that reports each time it is entered with notifyLock(), so that taking it from the audio thread is caught on every platform (tryEnter() never blocks, so isn't reported).
+    Use the aliases below in place of juce::CriticalSection / juce::SpinLock for any lock that could be reached from the audio thread
+    * @tparam LockType - juce::CriticalSection or juce::SpinLock
+    */
+    template <typename LockType>
+    class CheckedLock
+    {
+    public:
+        using ScopedLockType = juce::GenericScopedLock<CheckedLock>;
+
+        void enter() const noexcept         { notifyLock(); lock.enter(); }
+        bool tryEnter() const noexcept      { return lock.tryEnter(); }
+        void exit() const noexcept          { lock.exit(); }
+
+    private:
+        LockType lock;                      // the lock being checked
+    };
+
+    using CriticalSection = CheckedLock<juce::CriticalSection>;
+    using SpinLock = CheckedLock<juce::SpinLock>;
+}
+}
@@ -12,19 +12,21 @@
 
 //======================= Tone Component =========================//
 
-float FanToneComponent::process()
+template <typename SampleType>
+SampleType FanToneComponent<SampleType>::process (SampleType phase, SampleType sine)
 {
-    rawSineSignal = sineOsc.processSingleSample();
+    rawSineSignal = sine;
 
-    // waveshaping technique of 1/(1 + x^2) used to obtain narrow pulse wave
-    rawSignal = 1.0f / (1.0f + pow(rawSineSignal * pulseWidth, 2));
+    // the pulse table holds the waveshaping 1/(1 + x^2) of the sine, band limited, used to obtain narrow pulse wave
+    rawSignal = pulseTable->getPulse (tableLevel, pulseWidth, phase);
 
     return rawSignal * level;
 }
 
 //======================= Noise Component =========================//
 
-void FanNoiseComponent::setFilterParams (float freq, float q)
+template <typename SampleType>
+void FanNoiseComponent<SampleType>::setFilterParams (SampleType freq, SampleType q)
 {
     if (freq > 0)
         cutoff = freq;
@@ -33,28 +35,38 @@ void FanNoiseComponent::setFilterParams (float freq, float q)
         resonance = q;
 }
 
-float FanNoiseComponent::process (float rawSignalIn)
+template <typename SampleType>
+void FanNoiseComponent<SampleType>::updateFilter (SampleType freq, SampleType q)
 {
-    switch (filterType)
+    if (freq != filterCutoff)
     {
-    default:
-        filter.setCoefficients (juce::IIRCoefficients::makeBandPass(sampleRate, cutoff, resonance));
-        break;
-    case 1:
-        filter.setCoefficients (juce::IIRCoefficients::makeLowPass(sampleRate, cutoff, resonance));
-        break;
+        filter.setCutoff (freq);
+        filterCutoff = freq;
     }
 
-    float filteredNoise = filter.processSingleSampleRaw (random.nextFloat());
+    if (q != filterResonance)
+    {
+        filter.setResonance (q);
+        filterResonance = q;
+    }
+}
+
+template <typename SampleType>
+SampleType FanNoiseComponent<SampleType>::process (SampleType rawSignalIn)
+{
+    updateFilter (cutoff, resonance);
+
+    SampleType filteredNoise = filter.processSample (random.nextFloat(), filterType == 1 ? jr::SVFType::LOW_PASS : jr::SVFType::BAND_PASS);
 
-    float sampleOut = filteredNoise * rawSignalIn;
+    SampleType sampleOut = filteredNoise * rawSignalIn;
 
     return sampleOut * level;
 }
 
 //======================= Panner Component =========================//
 
-void FanPanner::process (float controlSignalIn)
+template <typename SampleType>
+void FanPanner<SampleType>::process (SampleType controlSignalIn)
 {
     rightLevel = (((controlSignalIn + 1.0f) / 2.0f) * panWidth) + 0.5f - (panWidth / 2.0f);
 
@@ -63,7 +75,8 @@ void FanPanner::process (float controlSignalIn)
 
 //======================= Doppler Component =========================//
 
-void FanDopplerComponent::setDopplerParams (float controlSignalIn, float range, float offset, float q)
+template <typename SampleType>
+void FanDopplerComponent<SampleType>::setDopplerParams (SampleType controlSignalIn, SampleType range, SampleType offset, SampleType q)
 {
     cutoffRange = range;
     cutoffOffset = offset;
@@ -77,45 +90,46 @@ void FanDopplerComponent::setDopplerParams (float controlSignalIn, float range,
         dopplerCutoff = 0;
 }
 
-float FanDopplerComponent::process (float rawSignalIn)
+template <typename SampleType>
+SampleType FanDopplerComponent<SampleType>::process (SampleType rawSignalIn)
 {
     if (dopplerOn)
     {
-        switch (filterType)
-        {
-        default:
-            filter.setCoefficients (juce::IIRCoefficients::makeBandPass (sampleRate, dopplerCutoff, dopplerRes));
-            break;
-        case 1:
-            filter.setCoefficients (juce::IIRCoefficients::makeLowPass (sampleRate, dopplerCutoff, dopplerRes));
-            break;
-        }
+        this->updateFilter (dopplerCutoff, dopplerRes);
 
-        float filteredNoise = filter.processSingleSampleRaw (random.nextFloat());
+        SampleType filteredNoise = this->filter.processSample (this->random.nextFloat(), this->filterType == 1 ? jr::SVFType::LOW_PASS : jr::SVFType::BAND_PASS);
 
-        float sampleOut = filteredNoise * rawSignalIn;
+        SampleType sampleOut = filteredNoise * rawSignalIn;
 
-        return sampleOut * level;
+        return sampleOut * this->level;
     }
     else
     {
-        return FanNoiseComponent::process (rawSignalIn);
+        return FanNoiseComponent<SampleType>::process (rawSignalIn);
     }
 }
 
 //======================= Delay Component =========================//
 
-void FanDelay::setSampleRate (float sr)
+template <typename SampleType>
+size_t FanDelay<SampleType>::getRequiredMemory (SampleType sr) const
+{
+    return FractionalDelay<SampleType>::getRequiredMemory (sr, 0.4f, storage);
+}
+
+template <typename SampleType>
+void FanDelay<SampleType>::prepare (SampleType sr, jr::MemoryArena& arena)
 {
     sampleRate = sr;
 
     delayLine.setSampleRate (sampleRate);
-    delayLine.setSize (0.4);
+    delayLine.setSize (0.4f, arena, storage, 2.0f);        // filtered noise from the fast blades stays well within +/-2
 }
 
-float FanDelay::process (float controlSignalIn, float audioSignalIn)
+template <typename SampleType>
+SampleType FanDelay<SampleType>::process (SampleType controlSignalIn, SampleType audioSignalIn)
 {
-    float delayTimeInMs = 200 + (controlSignalIn * chop);
+    SampleType delayTimeInMs = 200 + (controlSignalIn * chop);
 
     delayLine.setDelayTime (delayTimeInMs / 1000.0f);
 
@@ -124,39 +138,52 @@ float FanDelay::process (float controlSignalIn, float audioSignalIn)
 
 //======================= Fan Propeller =========================//
 
-FanPropeller::FanPropeller()
+template <typename SampleType>
+FanPropeller<SampleType>::FanPropeller()
 {
     fastBladesNoiseComp.setFilterType (1);
-    fastBladesToneComp.setPhaseShift (0.25);
 }
 
-void FanPropeller::setMappedParams (float gainIn, float speedIn, float toneLevelIn, float noiseLevelIn, float stereoWidthIn, bool dopplerOnIn)
+template <typename SampleType>
+void FanPropeller<SampleType>::setMappedParams (SampleType gainIn, SampleType speedIn, SampleType toneLevelIn, SampleType noiseLevelIn, SampleType stereoWidthIn, bool dopplerOnIn)
 {
     setParams (speedIn, gainIn, 1.0f, 1.0f, toneLevelIn, noiseLevelIn, toneLevelIn, noiseLevelIn, dopplerOnIn, 10.0f, stereoWidthIn);
 }
 
-void FanPropeller::setSampleRate (float sr)
+template <typename SampleType>
+size_t FanPropeller<SampleType>::getRequiredMemory (SampleType sr) const
+{
+    return fastBladesDelayComp.getRequiredMemory (sr);
+}
+
+template <typename SampleType>
+void FanPropeller<SampleType>::prepare (SampleType sr, jr::MemoryArena& arena)
 {
+    bladePhasor.setSampleRate (sr);
     mainBladesToneComp.setSampleRate (sr);
     fastBladesToneComp.setSampleRate (sr);
     mainBladesNoiseComp.setSampleRate (sr);
     fastBladesNoiseComp.setSampleRate (sr);
-    fastBladesDelayComp.setSampleRate (sr);
+    fastBladesDelayComp.prepare (sr, arena);
 }
 
-void FanPropeller::setSpeed (float speedInHz)
+template <typename SampleType>
+void FanPropeller<SampleType>::setSpeed (SampleType speedInHz)
 {
+    bladePhasor.setFrequency (speedInHz);
     mainBladesToneComp.setSpeed (speedInHz);
     fastBladesToneComp.setSpeed (speedInHz);
 }
 
-void FanPropeller::setPulseWidth (float pw)
+template <typename SampleType>
+void FanPropeller<SampleType>::setPulseWidth (SampleType pw)
 {
     mainBladesToneComp.setPulseWidth (pw);
     fastBladesToneComp.setPulseWidth (pw);
 }
 
-void FanPropeller::setParams (float speedInHz, float masterVol, float mainBladesLevelIn, float fastBladesLevelIn, float mainBladesToneLevel, float mainBladesNoiseLevel, float fastBladesToneLevel, float fastBladesNoiseLevel, bool dopplerOn, float chopIn, float panWidthIn)
+template <typename SampleType>
+void FanPropeller<SampleType>::setParams (SampleType speedInHz, SampleType masterVol, SampleType mainBladesLevelIn, SampleType fastBladesLevelIn, SampleType mainBladesToneLevel, SampleType mainBladesNoiseLevel, SampleType fastBladesToneLevel, SampleType fastBladesNoiseLevel, bool dopplerOn, SampleType chopIn, SampleType panWidthIn)
 {
     setSpeed (speedInHz);
     setLevel (masterVol);
@@ -171,21 +198,75 @@ void FanPropeller::setParams (float speedInHz, float masterVol, float mainBlades
     setPanWidth (panWidthIn);
 }
 
-void FanPropeller::process()
+template <typename SampleType>
+void FanPropeller<SampleType>::saveState (jr::SnapshotWriter& writer) const
 {
-    float mainBladesToneOut = mainBladesToneComp.process();
+    bladePhasor.saveState (writer);
+    mainBladesToneComp.saveState (writer);
+    mainBladesNoiseComp.saveState (writer);
+    pannerComp.saveState (writer);
+    fastBladesToneComp.saveState (writer);
+    fastBladesNoiseComp.saveState (writer);
+    fastBladesDelayComp.saveState (writer);
+    writer.write (level, mainBladesLevel, fastBladesLevel, currentLeftSample, currentRightSample);
+}
+
+template <typename SampleType>
+void FanPropeller<SampleType>::loadState (jr::SnapshotReader& reader)
+{
+    bladePhasor.loadState (reader);
+    mainBladesToneComp.loadState (reader);
+    mainBladesNoiseComp.loadState (reader);
+    pannerComp.loadState (reader);
+    fastBladesToneComp.loadState (reader);
+    fastBladesNoiseComp.loadState (reader);
+    fastBladesDelayComp.loadState (reader);
+    reader.read (level, mainBladesLevel, fastBladesLevel, currentLeftSample, currentRightSample);
+}
+
+template <typename SampleType>
+void FanPropeller<SampleType>::process()
+{
+    // both blade sets read the same phase and sine, so the fast blades turn in phase with the main blades
+    SampleType phase = bladePhasor.getPhase();
+    SampleType mainBladesToneOut = mainBladesToneComp.process (phase, bladePhasor.getSine());
     setDopplerParams();
-    float mainBladesOut = mainBladesLevel * (mainBladesToneOut + mainBladesNoiseComp.process (mainBladesToneComp.getRawSignal()));
+    SampleType mainBladesOut = mainBladesLevel * (mainBladesToneOut + mainBladesNoiseComp.process (mainBladesToneComp.getRawSignal()));
 
-    float fastBladesToneOut = fastBladesToneComp.process();
-    float fastBladesNoiseOut = fastBladesNoiseComp.process (fastBladesToneComp.getRawSignal());
-    float fastBladesOut = fastBladesLevel * (fastBladesToneOut + fastBladesDelayComp.process(fastBladesToneComp.getRawSine(), fastBladesNoiseOut));
+    SampleType fastBladesToneOut = fastBladesToneComp.process (phase, bladePhasor.getSine());
+    SampleType fastBladesNoiseOut = fastBladesNoiseComp.process (fastBladesToneComp.getRawSignal());
+    SampleType fastBladesOut = fastBladesLevel * (fastBladesToneOut + fastBladesDelayComp.process(fastBladesToneComp.getRawSine(), fastBladesNoiseOut));
     
-    float rawOut = level * (fastBladesOut + mainBladesOut);
+    SampleType rawOut = level * (fastBladesOut + mainBladesOut);
 
-    pannerComp.process (mainBladesToneComp.getRawSine());
+    if (isStereo)
+    {
+        pannerComp.process (mainBladesToneComp.getRawSine());
+
+        currentLeftSample = rawOut * pannerComp.getLeft();
+        currentRightSample = rawOut * pannerComp.getRight();
+    }
+    else
+    {
+        // the pan levels always sum to 1, so the centre is half of the fan's output
+        currentLeftSample = 0.5f * rawOut;
+        currentRightSample = currentLeftSample;
+    }
 
-    currentLeftSample = rawOut * pannerComp.getLeft();
-    currentRightSample = rawOut * pannerComp.getRight();
+    bladePhasor.advance();
 }
 
+//======================= Explicit Instantiations =========================//
+
+template class FanToneComponent<float>;
+template class FanToneComponent<double>;
+template class FanNoiseComponent<float>;
+template class FanNoiseComponent<double>;
+template class FanDopplerComponent<float>;
+template class FanDopplerComponent<double>;
+template class FanDelay<float>;
+template class FanDelay<double>;
+template class FanPanner<float>;
+template class FanPanner<double>;
+template class FanPropeller<float>;
+template class FanPropeller<double>;
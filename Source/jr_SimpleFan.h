@@ -9,75 +9,106 @@
 */
 
 #pragma once
-#include "jr_PolyBLEP_Oscillators.h"        // used for jr::polyblepOscillator class
 #include "jr_Delay.h"                       // used for FractionalDelay class
+#include "jr_FanPulseTable.h"               // used for jr::FanPulseTable
+#include "jr_MemoryArena.h"                 // used for jr::MemoryArena
+#include "jr_QuadraturePhasor.h"            // used for jr::QuadraturePhasor
+#include "jr_Snapshot.h"                    // used for jr::SnapshotWriter / SnapshotReader
+#include "jr_StateVariableFilter.h"         // used for jr::StateVariableFilter
 #include <JuceHeader.h>
 
 /** A class that models the toned component of a simple Propeller Fan Physical Model.
-Use setSampleRate() and before use. Call process() each sample to get audio out.
+Use setSampleRate() and before use. Call process() each sample with the fan's phase and sine to get audio out.
+The pulse wave is read from a shared jr::FanPulseTable, using the mip level with no harmonics above Nyquist at the current speed
 */
+template <typename SampleType>
 class FanToneComponent
 {
 public:
 
-    FanToneComponent() { sineOsc.setMuted (false); }
+    FanToneComponent() : pulseTable (&jr::FanPulseTable<SampleType>::getShared()) {}
 
     //================================= mutator ===================================//
 
     /** Sets the sample rate
     * @param sr - sample rate, Hz
     */
-    void setSampleRate (float sr) { sineOsc.setSampleRate (sr); }
+    void setSampleRate (SampleType sr) { sampleRate = sr; updateTableLevel(); }
 
-    /** Sets the speed of the fan in Hz
+    /** Sets the speed of the fan in Hz, ignoring a speed at or below 0 as the fan's phasor does
     * @param frequency - speed in Hz
     */
-    void setSpeed (float frequency) { sineOsc.setFrequency (frequency); }
-
-    /** Sets the phase shift of the component, used to stagger the phase of mutliple instances of the component
-    * @param shiftAmount - phase shift amount (0-0.5)
-    */
-    void setPhaseShift (float shiftAmount) { sineOsc.setPhaseShift (shiftAmount); }
+    void setSpeed (SampleType frequency) { if (frequency > 0 && frequency != speed) { speed = frequency; updateTableLevel(); } }
 
     /** Sets the pulse width of the component
-    * @param pw - pulse width
+    * @param pw - pulse width (1-16)
     */
-    void setPulseWidth (float pw) { if (pw > 0) pulseWidth = pw; }
+    void setPulseWidth (SampleType pw) { if (pw > 0) pulseWidth = pw; }
 
     /** Sets the volume level of the tone component
     * @param vol - volume level (0-1)
     */
-    void setLevel (float vol) { if (vol >= 0 && vol <= 1.0) level = vol; }
+    void setLevel (SampleType vol) { if (vol >= 0 && vol <= 1.0) level = vol; }
 
     //================================= accessor ===================================//
 
     /** returns the current sample value for the raw sine wave before it has been transformed into the tone, used to control other connected components
     * @return rawSineSignal - current sample value of raw sine signal
     */
-    float getRawSine() { return rawSineSignal; }
+    SampleType getRawSine() { return rawSineSignal; }
 
     /** returns the current sample value for the output audio signal before the volume level has been applied, used to send to noise component
     * @return rawSignal - current sample value for the raw audio output signal 
     */
-    float getRawSignal() { return rawSignal; }
+    SampleType getRawSignal() { return rawSignal; }
 
     /** Processes the tone component and returns the next sample value for the audio signal
+    * @param phase - position of the blades through the revolution (0-2)
+    * @param sine - sine of the phase, sin (2pi * phase)
     * @return sampleOut - next sample value for audio signal out
     */
-    float process();
+    SampleType process (SampleType phase, SampleType sine);
+
+    /** Writes the state of the tone component to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        writer.write (sampleRate, speed, tableLevel, pulseWidth, level, rawSineSignal, rawSignal);
+    }
+
+    /** Reads the state of the tone component from a snapshot
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        reader.read (sampleRate, speed, tableLevel, pulseWidth, level, rawSineSignal, rawSignal);
+    }
+
+    /** Returns the memory used by the tone component (the shared pulse table is not included)
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
 
 private:
-    jr::polyblepOscillator sineOsc;             // sine oscillator used as base of the tone component
-    float phaseShift{};                         // amount of phase shift (0-0.5), used to stagger phase of multiple instances
-    float pulseWidth{ 8.0 };                    // pulse width of waveform
-    float level{ 1.0f };                        // volume level of tone component (0-1)
-    float rawSineSignal{};                      // current sample value for the raw sine signal, used to control delay or doppler components that may be connected
-    float rawSignal{};                          // current sample value for the output audio signal before the volume level has been applied, used to send to an attached noise component
+
+    /** Updates the mip level of the pulse table, called each time the sample rate or speed is changed
+    */
+    void updateTableLevel() { tableLevel = jr::FanPulseTable<SampleType>::getLevel (speed / sampleRate); }
+
+    const jr::FanPulseTable<SampleType>* pulseTable;   // shared table of the pulse wave
+    SampleType sampleRate{ 44100 };             // sample rate, Hz
+    SampleType speed{ 440 };                    // speed of the fan, Hz (starts at the fan phasor's default)
+    int tableLevel{};                           // mip level of the pulse table read at the current speed
+    SampleType pulseWidth{ 8.0 };               // pulse width of waveform
+    SampleType level{ 1.0f };                   // volume level of tone component (0-1)
+    SampleType rawSineSignal{};                 // current sample value for the raw sine signal, used to control delay or doppler components that may be connected
+    SampleType rawSignal{};                     // current sample value for the output audio signal before the volume level has been applied, used to send to an attached noise component
 };
 
 /** A class that models the noise component of a simple Propeller Fan Physical Model.
 Use setSampleRate() before use. Call process() each sample to get audio out.
 */
+template <typename SampleType>
 class FanNoiseComponent
 {
 public:
@@ -87,47 +118,84 @@ public:
     /** Sets the sample rate of the component
     * @param sr - sample rate (Hz)
     */
-    void setSampleRate (float sr) { sampleRate = sr; }
+    void setSampleRate (SampleType sr) { sampleRate = sr; filter.setSampleRate (sr); }
 
     /** Sets the volume level of the component
     * @param gain - volume level (0-1)
     */
-    void setLevel (float gain) { level = gain; }
+    void setLevel (SampleType gain) { level = gain; }
 
     /** Sets the parameters of the filter
     * @param freq - cutoff frequency (Hz)
     * @param q - resonance value
     */
-    void setFilterParams (float freq, float q);
+    void setFilterParams (SampleType freq, SampleType q);
 
     /** Sets the filter type
     * @param typeIndex - filter type (0=BandPass, 1=LowPass)
     */
     void setFilterType (size_t typeIndex) { if (typeIndex == 0 || typeIndex == 1) filterType = typeIndex; }
 
+    /** Seeds the noise generator, so that renders can be repeated exactly
+    * @param seed - seed value
+    */
+    void setRandomSeed (juce::int64 seed) { random.setSeed (seed); }
+
     //================================= accessor ===================================//
 
     /** returns the next sample value for the noise component
     * @param rawSignalIn - raw signal from attached tone component
     * @return sampleOut - next sample value
     */
-    virtual float process (float rawSignalIn);
+    virtual SampleType process (SampleType rawSignalIn);
+
+    /** Writes the state of the noise component to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        filter.saveState (writer);
+        writer.write (cutoff, resonance, random, level, filterType, filterCutoff, filterResonance);
+    }
+
+    /** Reads the state of the noise component from a snapshot
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        filter.loadState (reader);
+        reader.read (cutoff, resonance, random, level, filterType, filterCutoff, filterResonance);
+    }
+
+    /** Returns the memory used by the noise component
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
 
 protected:
-    float cutoff{ 700.0f };             // cutoff frequency of filter (Hz)
-    float resonance{ 1.0f };            // resonance (Q value) of filter
-    juce::IIRFilter filter;             // filter
-    float sampleRate{};                 // sample rate of component (Hz)
+
+    /** Moves the filter to a cutoff and resonance, skipping the work when they haven't changed
+    * @param freq - cutoff frequency (Hz)
+    * @param q - resonance value
+    */
+    void updateFilter (SampleType freq, SampleType q);
+
+    SampleType cutoff{ 700.0f };        // cutoff frequency of filter (Hz)
+    SampleType resonance{ 1.0f };       // resonance (Q value) of filter
+    jr::StateVariableFilter<SampleType> filter;     // filter, its cutoff can move every sample
+    SampleType sampleRate{};            // sample rate of component (Hz)
     juce::Random random;                // random number generator for white noise
-    float level{ 1.0f };                // volume level of nosie component (0-1)
+    SampleType level{ 1.0f };           // volume level of nosie component (0-1)
     size_t filterType{};                // filter type index (0=BandPass, 1=LowPass)
+    SampleType filterCutoff{ -1 };      // cutoff the filter is set to (Hz), -1 before it is first set
+    SampleType filterResonance{ -1 };   // resonance the filter is set to, -1 before it is first set
 };
 
 /** A type of noise component class for a simple fan, where a doppler effect is created with the filter using a control signal
 Use setSampleRate() before use. Call process() each sample to get audio out. setDoppler() turns doppler on or off.
 setFilterParams() can be used to set the parameters for the noise component when dopper is turned OFF, for filter parameters that will be controlled by doppler use setDopplerParams()
 */
-class FanDopplerComponent : public FanNoiseComponent
+template <typename SampleType>
+class FanDopplerComponent : public FanNoiseComponent<SampleType>
 {
 public:
 
@@ -137,9 +205,9 @@ public:
     * @param offset - offset of cutoff frequency
     * @param q - resonance value for filter
     */
-    void setDopplerParams (float controlSignalIn, float range, float offset, float q);
+    void setDopplerParams (SampleType controlSignalIn, SampleType range, SampleType offset, SampleType q);
 
-    void setDopplerParams (float controlSignalIn) { setDopplerParams (controlSignalIn, cutoffRange, cutoffOffset, dopplerRes); }
+    void setDopplerParams (SampleType controlSignalIn) { setDopplerParams (controlSignalIn, cutoffRange, cutoffOffset, dopplerRes); }
 
     /** Sets whether or not doppler effect is processed or not
     * bool isOn - true to turn doppler effect on, false to turn off
@@ -150,48 +218,106 @@ public:
     * @param rawSignalIn - raw signal from attached tone component
     * @return sampleOut - next sample value
     */
-    float process (float rawSignalIn) override;
+    SampleType process (SampleType rawSignalIn) override;
+
+    /** Writes the state of the doppler component to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        FanNoiseComponent<SampleType>::saveState (writer);
+        writer.write (cutoffRange, cutoffOffset, dopplerCutoff, dopplerRes, dopplerOn);
+    }
+
+    /** Reads the state of the doppler component from a snapshot
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        FanNoiseComponent<SampleType>::loadState (reader);
+        reader.read (cutoffRange, cutoffOffset, dopplerCutoff, dopplerRes, dopplerOn);
+    }
+
+    /** Returns the memory used by the doppler component
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
 
 private:
-    float cutoffRange{ 500.0f };                // range of modulation of cutoff frequency (Hz)
-    float cutoffOffset{ 100.0f };               // offset of cutoff frequency (Hz)
-    float dopplerCutoff{ 700.0f };              // current cutoff frequency resulting from doppler modulation (Hz)
-    float dopplerRes{ 5.0f };                   // current resonance value for filter with doppler effect
+    SampleType cutoffRange{ 500.0f };           // range of modulation of cutoff frequency (Hz)
+    SampleType cutoffOffset{ 100.0f };          // offset of cutoff frequency (Hz)
+    SampleType dopplerCutoff{ 700.0f };         // current cutoff frequency resulting from doppler modulation (Hz)
+    SampleType dopplerRes{ 5.0f };              // current resonance value for filter with doppler effect
     bool dopplerOn{ true };                     // doppler effect on/off
 };
 
 /** A specific delay class used to create a fast blade effect for a Fan Physical Model by varying the delay length of a delay line at a set rate
-Use setSampleRate() before use. Call process() each sample for output.
+Use prepare() before use. Call process() each sample for output.
 */
+template <typename SampleType>
 class FanDelay
 {
 public:
 
-    /** Sets the sample rate and initialises the delay
+    /** Sets whether the delay line is stored as 16-bit fixed point (half the memory) instead of floats - call before getRequiredMemory() and prepare()
+    * @param isCompact - true for compact storage
+    */
+    void setCompactStorage (bool isCompact) { storage = isCompact ? jr::DelayStorage::FIXED16 : jr::DelayStorage::FULL_PRECISION; }
+
+    /** Returns the number of bytes of arena memory needed by the delay line
+    * @param sr - sample rate (Hz)
+    */
+    size_t getRequiredMemory (SampleType sr) const;
+
+    /** Sets the sample rate and initialises the delay, taking its buffer from the arena
     * @param sr - sample rate (Hz)
+    * @param arena - arena with room for getRequiredMemory() bytes
     */
-    void setSampleRate (float sr);
+    void prepare (SampleType sr, jr::MemoryArena& arena);
 
     /** Sets the amount of 'chop' to the fan blades, which is the modulation depth of the delay time in ms
     * @param chopIn - chop value (ms)
     */
-    void setChop (float chopIn) { if (chopIn >= 0 && chopIn <= 99.9) chop = chopIn; }
+    void setChop (SampleType chopIn) { if (chopIn >= 0 && chopIn <= 99.9) chop = chopIn; }
 
     /** processes the new delay length according to the control signal, and then processes the audioSignalIn, returning a mix of the dry and delayed signal
     * @param controlSignalIn - current sample value for the control signal
     * @param audioSignalIn - current sample value for the dry audio signal
     */
-    float process (float controlSignalIn, float audioSignalIn);
+    SampleType process (SampleType controlSignalIn, SampleType audioSignalIn);
+
+    /** Writes the state of the delay component to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        delayLine.saveState (writer);
+        writer.write (chop);
+    }
+
+    /** Reads the state of the delay component from a snapshot
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        delayLine.loadState (reader);
+        reader.read (chop);
+    }
+
+    /** Returns the memory used by the delay component, including its delay line in the arena
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), delayLine.getMemoryFootprint().bufferBytes }; }
 
 private:
-    float chop{ 10.0f };                        // modulation depth of the delay length in ms (0-99.9)
-    float sampleRate{};                         // sample rate, Hz
-    FractionalDelay delayLine;                  // delay line
+    SampleType chop{ 10.0f };                   // modulation depth of the delay length in ms (0-99.9)
+    SampleType sampleRate{};                    // sample rate, Hz
+    FractionalDelay<SampleType> delayLine;      // delay line
+    jr::DelayStorage storage{ jr::DelayStorage::FULL_PRECISION };  // sample format of delay line buffer
 };
 
 /** A simple stereo panner class that takes a signal value in and uses it to oscillate panning position around centre to a set pan width amount
 Use setPanWidth() before use. Call process() each sample to calculate new pan values, and then use getLeft() and getRight() to access volume levels for each channel.
 */ 
+template <typename SampleType>
 class FanPanner
 {
 public:
@@ -199,29 +325,50 @@ public:
     /** Sets the depth of the pan modulation around centre
     * @param width - pan width/depth (0-1)
     */
-    void setPanWidth (float width) { if (width >= 0 && width <= 1) panWidth = width; }
+    void setPanWidth (SampleType width) { if (width >= 0 && width <= 1) panWidth = width; }
 
     /** calculates new pan values for stereo channels using an input current sample value of a control signal
     * @param controlSignalIn - current sample value for control signal
     */
-    void process (float controlSignalIn);
+    void process (SampleType controlSignalIn);
 
     /** Returns the volume level for the left channel
     * @param leftLevel - volume level for left channel (0-1)
     */
-    float getLeft() { return leftLevel; }
+    SampleType getLeft() { return leftLevel; }
 
     /** Returns the volume level for the right channel
     * @param rightLevel - volume level for right channel (0-1)
     */
-    float getRight() { return rightLevel; }
+    SampleType getRight() { return rightLevel; }
+
+    /** Writes the state of the panner to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const
+    {
+        writer.write (panWidth, leftLevel, rightLevel);
+    }
+
+    /** Reads the state of the panner from a snapshot
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader)
+    {
+        reader.read (panWidth, leftLevel, rightLevel);
+    }
+
+    /** Returns the memory used by the panner
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), 0 }; }
 
 private:
-    float panWidth{};                   // width/depth of panning modulation around centre (0-1)
-    float leftLevel{};                  // volume level for left channel
-    float rightLevel{};                  // volume level for right channel
+    SampleType panWidth{};              // width/depth of panning modulation around centre (0-1)
+    SampleType leftLevel{};             // volume level for left channel
+    SampleType rightLevel{};             // volume level for right channel
 };
 
+template <typename SampleType>
 class FanPropeller
 {
 public:
@@ -238,32 +385,57 @@ public:
     * @param stereoWidthIn - stereo width of the fan panner (0-1)
     * @param dopplerOnIn - true if doppler effect on for fan
     */
-    void setMappedParams (float gainIn, float speedIn, float toneLevelIn, float noiseLevelIn, float stereoWidthIn, bool dopplerOnIn);
+    void setMappedParams (SampleType gainIn, SampleType speedIn, SampleType toneLevelIn, SampleType noiseLevelIn, SampleType stereoWidthIn, bool dopplerOnIn);
 
-    /** Sets the sample rate
+    /** Sets whether the fast blades delay line uses 16-bit fixed point storage, halving its memory - call before getRequiredMemory() and prepare()
+    * @param isCompact - true for compact storage
+    */
+    void setCompactStorage (bool isCompact) { fastBladesDelayComp.setCompactStorage (isCompact); }
+
+    /** Returns the number of bytes of arena memory needed by the fan's components
     * @param sr - sample rate (Hz)
     */
-    void setSampleRate (float sr);
+    size_t getRequiredMemory (SampleType sr) const;
 
-    /** Sets the speed of the fan in Hz
-    * @param speedInHz
+    /** Sets the sample rate, taking component buffers from the arena - call before use
+    * @param sr - sample rate (Hz)
+    * @param arena - arena with room for getRequiredMemory() bytes
     */
-    void setSpeed (float speedInHz);
+    void prepare (SampleType sr, jr::MemoryArena& arena);
+
+    /** Seeds the noise generators of both sets of blades, so that renders can be repeated exactly
+    * @param seed - seed value
+    */
+    void setRandomSeed (juce::int64 seed)
+    {
+        mainBladesNoiseComp.setRandomSeed (seed);
+        fastBladesNoiseComp.setRandomSeed (seed + 1);
+    }
+
+    /** Sets the speed of the fan in Hz, keeping the last speed if it is at or below 0
+    * @param speedInHz - speed in Hz
+    */
+    void setSpeed (SampleType speedInHz);
 
     /** Sets the pulse width of the tone components
     * @param pw - pulse width
     */
-    void setPulseWidth (float pw);
+    void setPulseWidth (SampleType pw);
 
     /** Sets the depth of modulation of the pan position from centre
     * @param width - modulation depth of pan from centre (0-1)
     */
-    void setPanWidth (float width) { pannerComp.setPanWidth (width); }
+    void setPanWidth (SampleType width) { pannerComp.setPanWidth (width); }
+
+    /** Sets whether the fan is panned between two channels. When it isn't, the panner doesn't run and both channels hold the centre (mono) signal
+    * @param isStereoIn - true to pan the fan
+    */
+    void setStereo (bool isStereoIn) { isStereo = isStereoIn; }
 
     /** Sets the chop value for the delay component, which is the modulation depth of the delay length
     * @param chop - modulation depth of the delay length (ms)
     */
-    void setChop (float chop) { fastBladesDelayComp.setChop (chop); }
+    void setChop (SampleType chop) { fastBladesDelayComp.setChop (chop); }
 
     /** Sets the doppler effect on or off for the cutoff frequency of the main blades noise component
     * @param isOn - true to turn doppler effect on, false to turn off
@@ -275,33 +447,33 @@ public:
     */
     void setDopplerParams() { mainBladesNoiseComp.setDopplerParams (mainBladesToneComp.getRawSine()); }
 
-    void setMainBladesLevel (float vol) { mainBladesLevel = vol; }
-    void setFastBladesLevel (float vol) { fastBladesLevel = vol; }
+    void setMainBladesLevel (SampleType vol) { mainBladesLevel = vol; }
+    void setFastBladesLevel (SampleType vol) { fastBladesLevel = vol; }
 
     /** sets the volume value for the tone component of the main blades
     * @param vol - volume level (0-1)
     */
-    void setMainToneLevel (float vol) { mainBladesToneComp.setLevel (vol); }
+    void setMainToneLevel (SampleType vol) { mainBladesToneComp.setLevel (vol); }
 
     /** sets the volume value for the tone component of the fast blades
     * @param vol - volume level (0-1)
     */
-    void setFastToneLevel (float vol) { fastBladesToneComp.setLevel (vol); }
+    void setFastToneLevel (SampleType vol) { fastBladesToneComp.setLevel (vol); }
 
     /** Sets the volume value for the noise component of the main blades
     * @param vol - volume level (0-1)
     */
-    void setMainNoiseLevel (float vol) { mainBladesNoiseComp.setLevel (vol); }
+    void setMainNoiseLevel (SampleType vol) { mainBladesNoiseComp.setLevel (vol); }
 
     /** Sets the volume value for the noise component of the fast blades
     * @param vol - volume level (0-1)
     */
-    void setFastNoiseLevel (float vol) { fastBladesNoiseComp.setLevel (vol); }
+    void setFastNoiseLevel (SampleType vol) { fastBladesNoiseComp.setLevel (vol); }
 
     /** Sets the master volume level for the fan
     * @param vol - volume (0-1)
     */ 
-    void setLevel (float vol) { level = vol; }
+    void setLevel (SampleType vol) { level = vol; }
 
     /** Sets parameters of Fan in one function
     * @param speedInHz
@@ -316,7 +488,7 @@ public:
     * @param chopIn
     * @param panWidthIn
     */
-    void setParams (float speedInHz, float masterVol, float mainBladesLevelIn, float fastBladesLevelIn, float mainBladesToneLevel, float mainBladesNoiseLevel, float fastBladesToneLevel, float fastBladesNoiseLevel, bool dopplerOn, float chopIn, float panWidthIn);
+    void setParams (SampleType speedInHz, SampleType masterVol, SampleType mainBladesLevelIn, SampleType fastBladesLevelIn, SampleType mainBladesToneLevel, SampleType mainBladesNoiseLevel, SampleType fastBladesToneLevel, SampleType fastBladesNoiseLevel, bool dopplerOn, SampleType chopIn, SampleType panWidthIn);
 
     //============================ accessors ============================//
 
@@ -328,27 +500,51 @@ public:
     /** returns the current sample value for the left channel of the fan
     * @return sampleOut
     */
-    float getLeftSample() { return currentLeftSample; }
+    SampleType getLeftSample() { return currentLeftSample; }
 
     /** returns the current sample value for the right channel of the fan
     * @return sampleOut
     */
-    float getRightSample() { return currentRightSample; }
+    SampleType getRightSample() { return currentRightSample; }
+
+    /** Writes the complete DSP state of the fan and its components to a snapshot
+    * @param writer - snapshot writer
+    */
+    void saveState (jr::SnapshotWriter& writer) const;
+
+    /** Reads the complete DSP state of the fan and its components from a snapshot taken from a fan prepared the same way
+    * @param reader - snapshot reader
+    */
+    void loadState (jr::SnapshotReader& reader);
+
+    /** Returns the memory used by the fan and all of its components, including delay lines in the arena
+    */
+    jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), fastBladesDelayComp.getMemoryFootprint().bufferBytes }; }
+
+    /** Returns the memory used by each component of the fan (main and fast blade components are the same size)
+    */
+    jr::MemoryFootprint getToneComponentFootprint() const { return mainBladesToneComp.getMemoryFootprint(); }
+    jr::MemoryFootprint getNoiseComponentFootprint() const { return mainBladesNoiseComp.getMemoryFootprint(); }
+    jr::MemoryFootprint getDelayComponentFootprint() const { return fastBladesDelayComp.getMemoryFootprint(); }
+    jr::MemoryFootprint getPannerFootprint() const { return pannerComp.getMemoryFootprint(); }
 
 private:
-    FanToneComponent mainBladesToneComp;            // tone component of main blades
-    FanDopplerComponent mainBladesNoiseComp;        // noise component of main blades with doppler capabilities
-    FanPanner pannerComp;                           // panning component for whole system (controlled by main blades)
+    jr::QuadraturePhasor<SampleType> bladePhasor;       // phase and sine of the revolution shared by both blade sets
+
+    FanToneComponent<SampleType> mainBladesToneComp;     // tone component of main blades
+    FanDopplerComponent<SampleType> mainBladesNoiseComp; // noise component of main blades with doppler capabilities
+    FanPanner<SampleType> pannerComp;                    // panning component for whole system (controlled by main blades)
 
-    FanToneComponent fastBladesToneComp;            // tone component of fast blades
-    FanNoiseComponent fastBladesNoiseComp;          // noise component of fast blades
-    FanDelay fastBladesDelayComp;                   // delay component of fast blades
+    FanToneComponent<SampleType> fastBladesToneComp;   // tone component of fast blades
+    FanNoiseComponent<SampleType> fastBladesNoiseComp; // noise component of fast blades
+    FanDelay<SampleType> fastBladesDelayComp;          // delay component of fast blades
 
     //============ params ============//
 
-    float level{ 0.5f };                            // master volume for fan
-    float mainBladesLevel{ 1.0f };                  // volume level for main blades
-    float fastBladesLevel{ 0.65f };                 // volume level for fast blades
-    float currentLeftSample{};                      // current sample value for left channel
-    float currentRightSample{};                     // current sample value for right channel
+    SampleType level{ 0.5f };                       // master volume for fan
+    SampleType mainBladesLevel{ 1.0f };             // volume level for main blades
+    SampleType fastBladesLevel{ 0.65f };            // volume level for fast blades
+    SampleType currentLeftSample{};                 // current sample value for left channel
+    SampleType currentRightSample{};                // current sample value for right channel
+    bool isStereo{ true };                          // true if the fan is panned, false to skip the panner for mono output
 };
\ No newline at end of file
@@ -0,0 +1,219 @@
+/*
+  ==============================================================================
+
+    jr_Snapshot.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cstring>          // used for std::memcpy()
+#include <type_traits>      // used for std::is_trivially_copyable
+#include <JuceHeader.h>
+
+namespace jr {
+
+    /** Writes model state into a flat block of memory owned by the caller, without allocating.
+    A writer made with the default constructor writes nothing and only counts bytes, which is how the size of a snapshot is found
+    */
+    class SnapshotWriter
+    {
+    public:
+
+        /** Creates a writer that only counts the bytes written
+        */
+        SnapshotWriter() = default;
+
+        /** Creates a writer into a block of memory
+        * @param destData - memory to write to
+        * @param numBytes - size of destData, bytes
+        */
+        SnapshotWriter (void* destData, size_t numBytes) : data (static_cast<char*> (destData)), capacity (numBytes) {}
+
+        /** Writes the raw bytes of one or more trivially copyable values (scalars, arrays, jr::Ramp, juce::Random)
+        */
+        template <typename... Types>
+        void write (const Types&... values)
+        {
+            (writeValue (values), ...);
+        }
+
+        /** Writes a block of bytes
+        * @param source - bytes to write
+        * @param numBytes - number of bytes
+        */
+        void writeBytes (const void* source, size_t numBytes)
+        {
+            if (data != nullptr)
+            {
+                if (position + numBytes > capacity)
+                {
+                    jassertfalse;       // the snapshot wasn't sized for this model
+                    failed = true;
+                    return;
+                }
+
+                std::memcpy (data + position, source, numBytes);
+            }
+
+            position += numBytes;
+        }
+
+        /** Returns the number of bytes written (or counted) so far
+        */
+        size_t getPosition() const { return position; }
+
+        /** Returns true if a write didn't fit in the destination memory
+        */
+        bool hasFailed() const { return failed; }
+
+    private:
+        template <typename Type>
+        void writeValue (const Type& value)
+        {
+            static_assert (std::is_trivially_copyable<Type>::value, "only trivially copyable state can be written directly - give the class a saveState() function");
+            writeBytes (&value, sizeof (Type));
+        }
+
+        /** juce::Random only holds its seed, but isn't guaranteed to be trivially copyable, so its bytes are copied explicitly
+        */
+        void writeValue (const juce::Random& random) { writeBytes (&random, sizeof (juce::Random)); }
+
+        char* data{ nullptr };      // destination memory, or nullptr when counting
+        size_t capacity{};          // size of destination memory, bytes
+        size_t position{};          // bytes written so far
+        bool failed{ false };       // true once a write has overrun the destination
+    };
+
+    /** Reads model state back from memory written by a SnapshotWriter, without allocating.
+    Values must be read in the same order, into a model prepared with the same sample rate and storage settings
+    */
+    class SnapshotReader
+    {
+    public:
+
+        /** Creates a reader from a block of memory
+        * @param sourceData - memory to read from
+        * @param numBytes - number of valid bytes in sourceData
+        */
+        SnapshotReader (const void* sourceData, size_t numBytes) : data (static_cast<const char*> (sourceData)), size (numBytes) {}
+
+        /** Reads the raw bytes of one or more trivially copyable values
+        */
+        template <typename... Types>
+        void read (Types&... values)
+        {
+            (readValue (values), ...);
+        }
+
+        /** Reads a block of bytes
+        * @param dest - memory to read into
+        * @param numBytes - number of bytes
+        */
+        void readBytes (void* dest, size_t numBytes)
+        {
+            if (failed || position + numBytes > size)
+            {
+                jassert (failed);       // the snapshot is smaller than the model being restored
+                failed = true;
+                return;
+            }
+
+            std::memcpy (dest, data + position, numBytes);
+            position += numBytes;
+        }
+
+        /** Marks the snapshot as not matching the model, e.g. when a delay buffer is a different size. No further values are read
+        */
+        void fail() { failed = true; }
+
+        /** Returns true if the snapshot didn't match the model being restored, in which case the model should be reset before use
+        */
+        bool hasFailed() const { return failed; }
+
+    private:
+        template <typename Type>
+        void readValue (Type& value)
+        {
+            static_assert (std::is_trivially_copyable<Type>::value, "only trivially copyable state can be read directly - give the class a loadState() function");
+            readBytes (&value, sizeof (Type));
+        }
+
+        /** juce::Random only holds its seed, but isn't guaranteed to be trivially copyable, so its bytes are copied explicitly
+        */
+        void readValue (juce::Random& random) { readBytes (&random, sizeof (juce::Random)); }
+
+        const char* data;           // source memory
+        size_t size;                // number of valid bytes in source memory
+        size_t position{};          // bytes read so far
+        bool failed{ false };       // true once the snapshot has been found not to match the model
+    };
+
+    /** A preallocated block of memory holding the complete DSP state of a model (anything with saveState() and loadState()).
+    Call allocateFor() off the audio thread; capture() and restore() then only copy memory, so they can be used while rendering
+    */
+    class Snapshot
+    {
+    public:
+
+        /** Allocates enough memory to hold the state of a prepared model
+        * @param model - model to size the snapshot for
+        */
+        template <typename ModelType>
+        void allocateFor (const ModelType& model)
+        {
+            SnapshotWriter counter;
+            model.saveState (counter);
+
+            sizeInBytes = counter.getPosition();
+            data.allocate (sizeInBytes, false);
+            usedBytes = 0;
+        }
+
+        /** Copies the state of a model into the snapshot
+        * @param model - model to capture
+        * @return true if the state fitted in the snapshot
+        */
+        template <typename ModelType>
+        bool capture (const ModelType& model)
+        {
+            if (data.get() == nullptr)
+            {
+                jassertfalse;       // call allocateFor() first
+                return false;
+            }
+
+            SnapshotWriter writer (data.get(), sizeInBytes);
+            model.saveState (writer);
+
+            usedBytes = writer.hasFailed() ? 0 : writer.getPosition();
+            return ! writer.hasFailed();
+        }
+
+        /** Restores a model to the state held in the snapshot
+        * @param model - model prepared the same way as the captured model
+        * @return true if the snapshot matched the model
+        */
+        template <typename ModelType>
+        bool restore (ModelType& model) const
+        {
+            SnapshotReader reader (data.get(), usedBytes);
+            model.loadState (reader);
+
+            return ! reader.hasFailed();
+        }
+
+        /** Returns true once a state has been captured
+        */
+        bool hasState() const { return usedBytes > 0; }
+
+        /** Returns the size of the snapshot's memory, bytes
+        */
+        size_t getSizeInBytes() const { return sizeInBytes; }
+
+    private:
+        juce::HeapBlock<char> data;     // snapshot memory
+        size_t sizeInBytes{};           // size of data, bytes
+        size_t usedBytes{};             // bytes holding the last captured state
+    };
+}
@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    jr_StateVariableFilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "jr_Snapshot.h"    // used for jr::SnapshotWriter / SnapshotReader
+
+namespace jr {
+
+    /** Output of a StateVariableFilter
+    */
+    enum class SVFType
+    {
+        LOW_PASS = 0,                       // low pass, same response as IIRCoefficients::makeLowPass()
+        BAND_PASS,                          // band pass with a constant 0dB peak, same response as IIRCoefficients::makeBandPass()
+        HIGH_PASS                           // high pass, same response as IIRCoefficients::makeHighPass()
+    };
+
+    /** A second order state variable filter using the topology-preserving transform (trapezoidal integrators), giving low, band and high pass
+    outputs at once. Its state is the integrators' own, so the cutoff can be moved every sample with no clicks or instability, and setting it
+    costs a rational tan() approximation and a division rather than a full biquad design
+    * @tparam SampleType - float or double
+    */
+    template <typename SampleType>
+    class StateVariableFilter
+    {
+    public:
+
+        /** All three outputs for one sample
+        */
+        struct Outputs
+        {
+            SampleType low{};               // low pass output
+            SampleType band{};              // band pass output, constant 0dB peak
+            SampleType high{};              // high pass output
+        };
+
+        StateVariableFilter() { setCutoff (cutoff); }
+
+        /** Sets the sample rate, keeping the cutoff and resonance
+        * @param sr - sample rate, Hz
+        */
+        void setSampleRate (SampleType sr)
+        {
+            sampleRate = sr;
+            setCutoff (cutoff);
+        }
+
+        /** Sets the cutoff frequency, which can be called every sample
+        * @param frequency - cutoff (or centre) frequency, Hz, limited to just below half the sample rate
+        */
+        void setCutoff (SampleType frequency)
+        {
+            cutoff = frequency;
+            g = getG (frequency);
+            updateCoefficients();
+        }
+
+        /** Sets the resonance
+        * @param Q - resonance, must be above 0
+        */
+        void setResonance (SampleType Q)
+        {
+            k = (SampleType) 1 / Q;
+            updateCoefficients();
+        }
+
+        /** Clears the filter state
+        */
+        void reset() { s1 = s2 = 0; }
+
+        /** Writes the coefficients and filter state to a snapshot
+        */
+        void saveState (SnapshotWriter& writer) const { writer.write (sampleRate, cutoff, g, k, a1, a2, a3, s1, s2); }
+
+        /** Reads the coefficients and filter state from a snapshot
+        */
+        void loadState (SnapshotReader& reader) { reader.read (sampleRate, cutoff, g, k, a1, a2, a3, s1, s2); }
+
+        /** Returns all three outputs for the next sample
+        * @param in - sample value in
+        */
+        Outputs processOutputs (SampleType in)
+        {
+            SampleType v3 = in - s2;
+            SampleType v1 = (a1 * s1) + (a2 * v3);
+            SampleType v2 = s2 + (a2 * s1) + (a3 * v3);
+
+            s1 = snapToZero ((2 * v1) - s1);
+            s2 = snapToZero ((2 * v2) - s2);
+
+            return { v2, k * v1, in - (k * v1) - v2 };
+        }
+
+        /** Returns one output for the next sample
+        * @param in - sample value in
+        * @param type - output to return
+        */
+        SampleType processSample (SampleType in, SVFType type)
+        {
+            Outputs out = processOutputs (in);
+
+            switch (type)
+            {
+                case SVFType::BAND_PASS:    return out.band;
+                case SVFType::HIGH_PASS:    return out.high;
+                case SVFType::LOW_PASS:
+                default:                    return out.low;
+            }
+        }
+
+        /** Filters a block of samples in place with a fixed cutoff
+        * @param data - samples to filter
+        * @param numSamples - number of samples
+        * @param type - output to write
+        */
+        void processBlock (SampleType* data, int numSamples, SVFType type)
+        {
+            for (int i = 0; i < numSamples; i++)
+                data[i] = processSample (data[i], type);
+        }
+
+        /** Filters a block of samples in place, moving the cutoff every sample. The last cutoff is kept afterwards
+        * @param data - samples to filter
+        * @param cutoffs - cutoff frequency for each sample, Hz
+        * @param numSamples - number of samples
+        * @param type - output to write
+        */
+        void processBlock (SampleType* data, const SampleType* cutoffs, int numSamples, SVFType type)
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                g = getG (cutoffs[i]);
+                updateCoefficients();
+                data[i] = processSample (data[i], type);
+            }
+
+            if (numSamples > 0)
+                cutoff = cutoffs[numSamples - 1];
+        }
+
+    private:
+
+        /** Returns the integrator gain for a cutoff, tan (pi * cutoff / sampleRate), using a [5/4] Pade approximation of tan()
+        which is within 0.02% of tan() up to 0.48 of the sample rate
+        * @param frequency - cutoff frequency, Hz
+        */
+        SampleType getG (SampleType frequency) const
+        {
+            SampleType x = juce::MathConstants<SampleType>::pi * juce::jlimit ((SampleType) 0, (SampleType) 0.49 * sampleRate, frequency) / sampleRate;
+            SampleType xSquared = x * x;
+
+            return x * (945 + xSquared * (-105 + xSquared)) / (945 + xSquared * (-420 + (15 * xSquared)));
+        }
+
+        /** Recalculates the per-sample coefficients from g and k
+        */
+        void updateCoefficients()
+        {
+            a1 = (SampleType) 1 / (1 + (g * (g + k)));
+            a2 = g * a1;
+            a3 = g * a2;
+        }
+
+        /** Returns a state value with denormals snapped to zero
+        */
+        static SampleType snapToZero (SampleType value)
+        {
+            return (value < (SampleType) -1.0e-8 || value > (SampleType) 1.0e-8) ? value : 0;
+        }
+
+        SampleType sampleRate{ 44100 };                 // sample rate, Hz
+        SampleType cutoff{ 1000 };                      // cutoff frequency, Hz
+        SampleType g{}, k{ juce::MathConstants<SampleType>::sqrt2 };   // integrator gain and damping (1 / Q)
+        SampleType a1{}, a2{}, a3{};                    // per-sample coefficients
+        SampleType s1{}, s2{};                          // integrator states
+    };
+}
@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    jr_Telemetry.cpp
+
+  ==============================================================================
+*/
+
+#include "jr_Telemetry.h"
+#include <cmath>                            // used for std::floor()
+#include <cstring>                          // used for std::memcmp()
+
+namespace jr {
+
+    namespace
+    {
+        const char telemetryMagic[4] = { 'J', 'R', 'T', 'L' };     // identifies a binary telemetry log
+    }
+
+    //========================= mutator functions ===========================//
+
+    bool TelemetryLog::open (const juce::File& file)
+    {
+        close();
+
+        auto mapping = std::make_unique<juce::MemoryMappedFile> (file, juce::MemoryMappedFile::readOnly);
+        auto* data = static_cast<const char*> (mapping->getData());
+        size_t size = mapping->getSize();
+
+        if (data == nullptr || size < sizeof (TelemetryHeader))
+            return false;
+
+        auto* newHeader = reinterpret_cast<const TelemetryHeader*> (data);
+        juce::uint64 maxFrames = (size - sizeof (TelemetryHeader)) / sizeof (TelemetryFrame);
+
+        if (std::memcmp (newHeader->magic, telemetryMagic, sizeof (telemetryMagic)) != 0 || newHeader->version != currentVersion
+            || ! (newHeader->frameRate > 0) || newHeader->numFrames == 0 || newHeader->numFrames > maxFrames)
+            return false;
+
+        mappedFile = std::move (mapping);
+        logFile = file;
+        header = newHeader;
+        frames = reinterpret_cast<const TelemetryFrame*> (data + sizeof (TelemetryHeader));
+        return true;
+    }
+
+    void TelemetryLog::close()
+    {
+        header = nullptr;
+        frames = nullptr;
+        logFile = juce::File();
+        mappedFile.reset();
+    }
+
+    bool TelemetryLog::convertCsv (const juce::File& csvFile, const juce::File& destFile, double frameRate)
+    {
+        if (! (frameRate > 0))
+            return false;
+
+        juce::FileInputStream input (csvFile);
+
+        if (! input.openedOk())
+            return false;
+
+        destFile.deleteFile();
+        TelemetryHeader newHeader{ { 'J', 'R', 'T', 'L' }, currentVersion, frameRate, 0, 0.0f, 0 };
+
+        {
+            juce::FileOutputStream output (destFile);
+
+            if (! output.openedOk())
+                return false;
+
+            // the header is written again once the number of frames and max rpm are known
+            output.write (&newHeader, sizeof (newHeader));
+
+            double startTime = 0.0;
+            double previousTime = 0.0;
+            TelemetryFrame previous{};
+            bool hasPrevious = false;
+
+            while (! input.isExhausted())
+            {
+                auto line = input.readNextLine().trim();
+
+                if (line.isEmpty() || ! (juce::CharacterFunctions::isDigit (line[0]) || line[0] == '-' || line[0] == '.'))
+                    continue;
+
+                juce::StringArray tokens;
+                tokens.addTokens (line, ",", "\"");
+
+                if (tokens.size() < 5)
+                    continue;
+
+                double time = tokens[0].getDoubleValue();
+                TelemetryFrame row{ tokens[1].getFloatValue(), tokens[2].getFloatValue(), tokens[3].getFloatValue(), tokens[4].getIntValue() != 0 ? 1u : 0u };
+
+                if (! hasPrevious)
+                {
+                    startTime = time;
+                    previousTime = time;
+                    previous = row;
+                    hasPrevious = true;
+                }
+                else if (time < previousTime)
+                {
+                    continue;
+                }
+
+                // write every frame up to this row, interpolating from the previous row
+                for (double frameTime = startTime + (newHeader.numFrames / frameRate); frameTime <= time; frameTime = startTime + (newHeader.numFrames / frameRate))
+                {
+                    double span = time - previousTime;
+                    float alpha = span > 0 ? (float) ((frameTime - previousTime) / span) : 1.0f;
+
+                    TelemetryFrame frame;
+                    frame.engineRpm = previous.engineRpm + (alpha * (row.engineRpm - previous.engineRpm));
+                    frame.motorRpm = previous.motorRpm + (alpha * (row.motorRpm - previous.motorRpm));
+                    frame.throttle = previous.throttle + (alpha * (row.throttle - previous.throttle));
+                    frame.flags = alpha >= 1.0f ? row.flags : previous.flags;
+
+                    output.write (&frame, sizeof (frame));
+                    newHeader.maxEngineRpm = juce::jmax (newHeader.maxEngineRpm, frame.engineRpm);
+                    newHeader.numFrames++;
+                }
+
+                previousTime = time;
+                previous = row;
+            }
+
+            if (newHeader.numFrames > 0)
+            {
+                output.setPosition (0);
+                output.write (&newHeader, sizeof (newHeader));
+                output.flush();
+            }
+
+            if (newHeader.numFrames > 0 && ! output.getStatus().failed())
+                return true;
+        }
+
+        destFile.deleteFile();
+        return false;
+    }
+
+    //========================= accessor functions ===========================//
+
+    double TelemetryLog::getLengthInSeconds() const
+    {
+        return header != nullptr ? (header->numFrames - 1) / header->frameRate : 0.0;
+    }
+
+    TelemetryValues TelemetryLog::getValuesAt (double timeInSeconds) const
+    {
+        jassert (isOpen());
+
+        if (! isOpen())
+            return {};
+
+        const juce::uint64 lastFrame = header->numFrames - 1;
+        double position = juce::jlimit (0.0, (double) lastFrame, timeInSeconds * header->frameRate);
+        auto index = (juce::uint64) position;
+        float alpha = (float) (position - index);
+
+        const TelemetryFrame& frame = frames[index];
+        const TelemetryFrame& nextFrame = frames[juce::jmin (index + 1, lastFrame)];
+
+        float engineRpm = frame.engineRpm + (alpha * (nextFrame.engineRpm - frame.engineRpm));
+        float motorRpm = frame.motorRpm + (alpha * (nextFrame.motorRpm - frame.motorRpm));
+        float throttle = frame.throttle + (alpha * (nextFrame.throttle - frame.throttle));
+
+        TelemetryValues values;
+        values.engineRevs = header->maxEngineRpm > 0 ? juce::jlimit (0.0f, 1.0f, engineRpm / header->maxEngineRpm) : 0.0f;
+        values.motorSpeed = motorRpm / 60.0f;
+        values.throttle = juce::jlimit (0.0f, 1.0f, throttle);
+        values.isOn = (frame.flags & 1) != 0;
+        return values;
+    }
+
+    double TelemetryLog::getLastTriggerChangeWithin (double timeInSeconds, double windowInSeconds) const
+    {
+        if (! isOpen() || timeInSeconds < 0)
+            return -1.0;
+
+        const double frameRate = header->frameRate;
+        auto last = (juce::int64) juce::jmin ((double) (header->numFrames - 1), std::floor (timeInSeconds * frameRate));
+        auto first = (juce::int64) juce::jmax (0.0, std::floor ((timeInSeconds - windowInSeconds) * frameRate));
+
+        for (juce::int64 i = last; i > first; i--)
+        {
+            if (((frames[i].flags ^ frames[i - 1].flags) & 1) != 0)
+                return i / frameRate;
+        }
+
+        if (first == 0 && (frames[0].flags & 1) != 0)
+            return 0.0;
+
+        return -1.0;
+    }
+
+    void TelemetryLog::applyTo (MachineParams& params, double timeInSeconds) const
+    {
+        TelemetryValues values = getValuesAt (timeInSeconds);
+
+        params.trigger = values.isOn;
+        params.engineRevs = values.engineRevs;
+        params.motorMaxSpeed = juce::jlimit (60.0f, 800.0f, values.motorSpeed);
+        params.engineGain *= 0.5f + (0.5f * values.throttle);
+    }
+}
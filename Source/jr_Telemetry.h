@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    jr_Telemetry.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <memory>                           // used for std::unique_ptr
+#include <JuceHeader.h>
+#include "jr_Machine.h"                     // used for MachineParams
+
+namespace jr {
+
+    /** Header at the start of a binary telemetry log. Frames follow straight after, at a fixed rate. All values are in the byte order of the
+    machine that wrote the log
+    */
+    struct TelemetryHeader
+    {
+        char magic[4];                      // "JRTL"
+        juce::uint32 version;               // format version, currently 1
+        double frameRate;                   // frames per second
+        juce::uint64 numFrames;             // number of frames in the log
+        float maxEngineRpm;                 // engine rpm that maps to full engine revs
+        juce::uint32 reserved;              // unused, 0
+    };
+
+    /** One frame of a binary telemetry log
+    */
+    struct TelemetryFrame
+    {
+        float engineRpm;                    // engine speed, rpm
+        float motorRpm;                     // motor speed, rpm
+        float throttle;                     // throttle position (0-1)
+        juce::uint32 flags;                 // bit 0 set while the machine is on
+    };
+
+    /** Control values read from a telemetry log at a point in time
+    */
+    struct TelemetryValues
+    {
+        float engineRevs{};                 // engine revs (0-1)
+        float motorSpeed{};                 // motor speed, Hz
+        float throttle{};                   // throttle position (0-1)
+        bool isOn{ false };                 // true if the machine is on
+    };
+
+    /** Recorded vehicle or robot telemetry, memory mapped from a binary log so that logs of any length can be played without loading them.
+    Values are linearly interpolated between frames, apart from the on/off state which holds until the next frame.
+    Open the log off the audio thread; reading values only touches the mapped memory
+    */
+    class TelemetryLog
+    {
+    public:
+
+        static constexpr juce::uint32 currentVersion{ 1 };      // version written by convertCsv()
+
+        /** Memory maps a binary log
+        * @param file - log file written by convertCsv()
+        * @return true if the file was mapped and is a valid log
+        */
+        bool open (const juce::File& file);
+
+        /** Unmaps the log
+        */
+        void close();
+
+        /** Returns true if a log is open
+        */
+        bool isOpen() const { return frames != nullptr; }
+
+        /** Returns the file of the open log
+        */
+        const juce::File& getFile() const { return logFile; }
+
+        /** Returns the length of the log, seconds
+        */
+        double getLengthInSeconds() const;
+
+        /** Returns the frame rate of the log, frames per second
+        */
+        double getFrameRate() const { return header != nullptr ? header->frameRate : 0.0; }
+
+        /** Returns the control values at a time, holding the first or last frame outside the log
+        * @param timeInSeconds - time from the start of the log, seconds
+        */
+        TelemetryValues getValuesAt (double timeInSeconds) const;
+
+        /** Returns the time of the last change of the on/off state within a window before a time, or a negative value if it didn't change.
+        A log that starts in the on state counts as switching on at time 0
+        * @param timeInSeconds - time from the start of the log, seconds
+        * @param windowInSeconds - length of the window to search, seconds
+        */
+        double getLastTriggerChangeWithin (double timeInSeconds, double windowInSeconds) const;
+
+        /** Drives a set of machine parameters from the log: the trigger, the engine revs and the motor max speed are replaced,
+        and the engine level is scaled between half and full by the throttle
+        * @param params - parameters to update
+        * @param timeInSeconds - time from the start of the log, seconds
+        */
+        void applyTo (MachineParams& params, double timeInSeconds) const;
+
+        /** Converts a CSV log into a binary log, resampling it to a fixed frame rate. The CSV is streamed, so any size can be converted.
+        Columns are: time (seconds), engine rpm, motor rpm, throttle (0-1), on (0 or 1). Lines that don't start with a number (e.g. a header) are skipped
+        * @param csvFile - CSV log to read
+        * @param destFile - binary log to write, replaced if it exists
+        * @param frameRate - frame rate of the binary log, frames per second
+        * @return true if the log was converted
+        */
+        static bool convertCsv (const juce::File& csvFile, const juce::File& destFile, double frameRate = 1000.0);
+
+    private:
+        std::unique_ptr<juce::MemoryMappedFile> mappedFile;     // mapping of the open log
+        juce::File logFile;                                     // file of the open log
+        const TelemetryHeader* header{ nullptr };               // header of the open log
+        const TelemetryFrame* frames{ nullptr };                // frames of the open log
+    };
+}
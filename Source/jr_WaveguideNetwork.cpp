@@ -0,0 +1,375 @@
+/*
+  ==============================================================================
+
+    jr_WaveguideNetwork.cpp
+
+  ==============================================================================
+*/
+
+#include "jr_WaveguideNetwork.h"
+
+namespace jr {
+
+    //========================= mutator functions ==============================//
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::setLayout (int numSegmentsIn, int numInjectionPointsIn, int numFeedbackTapsIn)
+    {
+        numSegments = juce::jlimit (1, maxSegments, numSegmentsIn);
+        numInjectionPoints = juce::jlimit (0, maxInjectionPoints, numInjectionPointsIn);
+        numFeedbackTaps = juce::jlimit (0, maxFeedbackTaps, numFeedbackTapsIn);
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::setInjectionPoint (int injectionNum, int segment, bool isHeard)
+    {
+        if (injectionNum < 0 || injectionNum >= numInjectionPoints || segment < 0 || segment >= numSegments)
+            return;
+
+        injectionSegments[injectionNum] = segment;
+        injectionsHeard[injectionNum] = isHeard;
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::setFeedbackTap (int tapNum, int fromSegment, int toSegment)
+    {
+        if (tapNum < 0 || tapNum >= numFeedbackTaps || fromSegment < 0 || fromSegment >= numSegments || toSegment < 0 || toSegment >= numSegments)
+            return;
+
+        feedbackSources[tapNum] = fromSegment;
+        feedbackDestinations[tapNum] = toSegment;
+    }
+
+    template <typename SampleType>
+    size_t WaveguideNetwork<SampleType>::getRequiredMemory (int maxDelayInSamples) const
+    {
+        auto numBlockSamples = (size_t) (numSegments * maxBlockSize);
+
+        return jr::MemoryArena::getRequiredBytes<SampleType> ((size_t) (numSegments * getLineLength (maxDelayInSamples)))
+               + jr::MemoryArena::getRequiredBytes<SampleType> ((size_t) (numSegments * (maxBlockSize + 1)))
+               + jr::MemoryArena::getRequiredBytes<int> (numBlockSamples)
+               + (3 * jr::MemoryArena::getRequiredBytes<SampleType> (numBlockSamples));
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::prepare (SampleType sr, int maxDelayInSamples, jr::MemoryArena& arena)
+    {
+        sampleRate = sr;
+        lineLength = getLineLength (maxDelayInSamples);
+        bank = arena.allocate<SampleType> ((size_t) (numSegments * lineLength));
+        juce::FloatVectorOperations::clear (bank, numSegments * lineLength);
+
+        auto numBlockSamples = (size_t) (numSegments * maxBlockSize);
+        blockOutputs = arena.allocate<SampleType> ((size_t) (numSegments * (maxBlockSize + 1)));
+        blockDelayInts = arena.allocate<int> (numBlockSamples);
+        blockDelayFracs = arena.allocate<SampleType> (numBlockSamples);
+        blockHeardInputs = arena.allocate<SampleType> (numBlockSamples);
+        blockUnheardInputs = arena.allocate<SampleType> (numBlockSamples);
+
+        writePos = 0;
+        std::fill (delays, delays + maxSegments, (SampleType) 0);
+        std::fill (segmentOutputs, segmentOutputs + maxSegments, (SampleType) 0);
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::setSegmentLength (int segment, SampleType lengthInMs)
+    {
+        if (segment < 0 || segment >= maxSegments)
+            return;
+
+        segmentLengths[segment] = lengthInMs;
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::setFeedbackGain (int tapNum, SampleType gain)
+    {
+        if (tapNum < 0 || tapNum >= maxFeedbackTaps)
+            return;
+
+        feedbackGains[tapNum] = gain;
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::gatherInjections (const SampleType* const* injections, int numSamples)
+    {
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            juce::FloatVectorOperations::clear (blockHeardInputs + (segment * maxBlockSize), numSamples);
+            juce::FloatVectorOperations::clear (blockUnheardInputs + (segment * maxBlockSize), numSamples);
+        }
+
+        for (int i = 0; i < numInjectionPoints; i++)
+        {
+            SampleType* inputs = (injectionsHeard[i] ? blockHeardInputs : blockUnheardInputs) + (injectionSegments[i] * maxBlockSize);
+            juce::FloatVectorOperations::add (inputs, injections[i], numSamples);
+        }
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::updateDelays (const SampleType* const* modulations, int numSamples)
+    {
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            SampleType* delayFracs = blockDelayFracs + (segment * maxBlockSize);
+            const SampleType* modulation = modulations[segment];
+
+            // the modulated delays are independent, so they are worked out together first (held in delayFracs until stored)
+            for (int i = 0; i < numSamples; i++)
+                delayFracs[i] = getModulatedDelay (segment, modulation[i]);
+
+            for (int i = 0; i < numSamples; i++)
+                storeDelay (segment, i, delayFracs[i]);
+        }
+    }
+
+    template <typename SampleType>
+    SampleType WaveguideNetwork<SampleType>::getFeedback (int segment, int sampleIndex) const
+    {
+        SampleType feedback{};
+
+        for (int i = 0; i < numFeedbackTaps; i++)
+        {
+            if (feedbackDestinations[i] == segment)
+                feedback += feedbackGains[i] * blockOutputs[(feedbackSources[i] * (maxBlockSize + 1)) + sampleIndex];
+        }
+
+        return feedback;
+    }
+
+    //======================== accessor functions =============================//
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::saveState (jr::SnapshotWriter& writer) const
+    {
+        writer.write (numSegments, lineLength);
+        writer.writeBytes (bank, (size_t) (numSegments * lineLength) * sizeof (SampleType));
+        writer.write (writePos, numInjectionPoints, numFeedbackTaps, segmentLengths, delays, segmentOutputs);
+        writer.write (injectionSegments, injectionsHeard, feedbackSources, feedbackDestinations, feedbackGains);
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::loadState (jr::SnapshotReader& reader)
+    {
+        int savedNumSegments{};
+        int savedLineLength{};
+        reader.read (savedNumSegments, savedLineLength);
+
+        if (savedNumSegments != numSegments || savedLineLength != lineLength)
+        {
+            reader.fail();
+            return;
+        }
+
+        reader.readBytes (bank, (size_t) (numSegments * lineLength) * sizeof (SampleType));
+        reader.read (writePos, numInjectionPoints, numFeedbackTaps, segmentLengths, delays, segmentOutputs);
+        reader.read (injectionSegments, injectionsHeard, feedbackSources, feedbackDestinations, feedbackGains);
+    }
+
+    //========================= processing functions ===========================//
+
+    template <typename SampleType>
+    SampleType WaveguideNetwork<SampleType>::process (SampleType input, const SampleType* injections, const SampleType* modulations)
+    {
+        // a single sample is processed as the first sample of a chunk, without looking for a run
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            blockHeardInputs[segment * maxBlockSize] = 0;
+            blockUnheardInputs[segment * maxBlockSize] = 0;
+        }
+
+        for (int i = 0; i < numInjectionPoints; i++)
+            (injectionsHeard[i] ? blockHeardInputs : blockUnheardInputs)[injectionSegments[i] * maxBlockSize] += injections[i];
+
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            storeDelay (segment, 0, getModulatedDelay (segment, modulations[segment]));
+            blockOutputs[segment * (maxBlockSize + 1)] = segmentOutputs[segment];
+        }
+
+        SampleType output{};
+        processSample (&output, &input, 0);
+
+        for (int segment = 0; segment < numSegments; segment++)
+            segmentOutputs[segment] = blockOutputs[(segment * (maxBlockSize + 1)) + 1];
+
+        return output;
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::processBlock (SampleType* output, const SampleType* input, const SampleType* const* injections, const SampleType* const* modulations, int numSamples)
+    {
+        const SampleType* injectionChunks[maxInjectionPoints];
+        const SampleType* modulationChunks[maxSegments];
+
+        for (int chunkStart = 0; chunkStart < numSamples; chunkStart += maxBlockSize)
+        {
+            for (int i = 0; i < numInjectionPoints; i++)
+                injectionChunks[i] = injections[i] + chunkStart;
+
+            for (int segment = 0; segment < numSegments; segment++)
+                modulationChunks[segment] = modulations[segment] + chunkStart;
+
+            processChunk (output + chunkStart, input + chunkStart, injectionChunks, modulationChunks, juce::jmin (maxBlockSize, numSamples - chunkStart));
+        }
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::processChunk (SampleType* output, const SampleType* input, const SampleType* const* injections, const SampleType* const* modulations, int numSamples)
+    {
+        gatherInjections (injections, numSamples);
+        updateDelays (modulations, numSamples);
+
+        // the shortest delay of any segment at each sample bounds how long a run can be
+        int minDelayInts[maxBlockSize];
+        std::copy (blockDelayInts, blockDelayInts + numSamples, minDelayInts);
+
+        for (int segment = 1; segment < numSegments; segment++)
+        {
+            const int* delayInts = blockDelayInts + (segment * maxBlockSize);
+
+            for (int i = 0; i < numSamples; i++)
+                minDelayInts[i] = juce::jmin (minDelayInts[i], delayInts[i]);
+        }
+
+        for (int segment = 0; segment < numSegments; segment++)
+            blockOutputs[segment * (maxBlockSize + 1)] = segmentOutputs[segment];
+
+        int sampleIndex = 0;
+
+        while (sampleIndex < numSamples)
+        {
+            // sample i of a run reads samples at least minDelayInts behind it, so these must all come from before the run
+            int runLength = 0;
+
+            while (sampleIndex + runLength < numSamples && minDelayInts[sampleIndex + runLength] > runLength)
+                runLength++;
+
+            if (runLength == 0)
+            {
+                processSample (output, input, sampleIndex);
+                sampleIndex++;
+            }
+            else
+            {
+                processRun (output, input, sampleIndex, runLength);
+                sampleIndex += runLength;
+            }
+        }
+
+        for (int segment = 0; segment < numSegments; segment++)
+            segmentOutputs[segment] = blockOutputs[(segment * (maxBlockSize + 1)) + numSamples];
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::processSample (SampleType* output, const SampleType* input, int sampleIndex)
+    {
+        output[sampleIndex] = 0;
+
+        // each segment feeds the next, so the junctions are worked through in order
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            const SampleType* previousOutputs = blockOutputs + (juce::jmax (0, segment - 1) * (maxBlockSize + 1));
+            SampleType* outputs = blockOutputs + (segment * (maxBlockSize + 1));
+            int blockIndex = (segment * maxBlockSize) + sampleIndex;
+
+            SampleType junction = (segment > 0 ? previousOutputs[sampleIndex + 1] : 0) + blockHeardInputs[blockIndex];
+            output[sampleIndex] += junction;
+
+            SampleType* line = bank + (segment * lineLength);
+            line[writePos] = (segment == 0 ? input[sampleIndex] : 0) + junction + blockUnheardInputs[blockIndex] + getFeedback (segment, sampleIndex);
+
+            int index1 = writePos + blockDelayInts[blockIndex];
+            index1 -= index1 >= lineLength ? lineLength : 0;
+            int index2 = index1 + 1;
+            index2 -= index2 >= lineLength ? lineLength : 0;
+
+            SampleType value1 = line[index1];
+            outputs[sampleIndex + 1] = value1 + blockDelayFracs[blockIndex] * (line[index2] - value1);
+        }
+
+        output[sampleIndex] += blockOutputs[((numSegments - 1) * (maxBlockSize + 1)) + sampleIndex + 1];
+        writePos = (writePos + lineLength - 1) % lineLength;
+    }
+
+    template <typename SampleType>
+    void WaveguideNetwork<SampleType>::processRun (SampleType* output, const SampleType* input, int startIndex, int numSamples)
+    {
+        int endIndex = startIndex + numSamples;
+
+        // every segment reads only samples written before the run, so all of their outputs can be read first
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            const SampleType* line = bank + (segment * lineLength);
+            const int* delayInts = blockDelayInts + (segment * maxBlockSize);
+            const SampleType* delayFracs = blockDelayFracs + (segment * maxBlockSize);
+            SampleType* outputs = blockOutputs + (segment * (maxBlockSize + 1)) + 1;
+
+            for (int i = startIndex; i < endIndex; i++)
+            {
+                // the write position moves back a sample each sample, and the delay is longer than the run so the index can't fall below it
+                int index1 = writePos - (i - startIndex) + delayInts[i];
+                index1 -= index1 >= lineLength ? lineLength : 0;
+                int index2 = index1 + 1;
+                index2 -= index2 >= lineLength ? lineLength : 0;
+
+                SampleType value1 = line[index1];
+                outputs[i] = value1 + delayFracs[i] * (line[index2] - value1);
+            }
+        }
+
+        std::fill (output + startIndex, output + endIndex, (SampleType) 0);
+
+        // then the junctions and writes are done a segment at a time
+        for (int segment = 0; segment < numSegments; segment++)
+        {
+            const SampleType* previousOutputs = blockOutputs + (juce::jmax (0, segment - 1) * (maxBlockSize + 1)) + 1;
+            const SampleType* heardInputs = blockHeardInputs + (segment * maxBlockSize);
+            const SampleType* unheardInputs = blockUnheardInputs + (segment * maxBlockSize);
+            SampleType feedback[maxBlockSize];
+            SampleType segmentInputs[maxBlockSize];
+
+            // feedback taps read the outputs of the sample before, which for a run are one place back in blockOutputs
+            std::fill (feedback + startIndex, feedback + endIndex, (SampleType) 0);
+
+            for (int tap = 0; tap < numFeedbackTaps; tap++)
+            {
+                if (feedbackDestinations[tap] != segment)
+                    continue;
+
+                const SampleType* sourceOutputs = blockOutputs + (feedbackSources[tap] * (maxBlockSize + 1));
+
+                for (int i = startIndex; i < endIndex; i++)
+                    feedback[i] += feedbackGains[tap] * sourceOutputs[i];
+            }
+
+            for (int i = startIndex; i < endIndex; i++)
+            {
+                SampleType junction = (segment > 0 ? previousOutputs[i] : 0) + heardInputs[i];
+                output[i] += junction;
+                segmentInputs[i] = ((segment == 0 ? input[i] : 0) + junction + unheardInputs[i]) + feedback[i];
+            }
+
+            SampleType* line = bank + (segment * lineLength);
+
+            for (int i = startIndex; i < endIndex; i++)
+            {
+                int index = writePos - (i - startIndex);
+                index += index < 0 ? lineLength : 0;
+                line[index] = segmentInputs[i];
+            }
+        }
+
+        const SampleType* lastOutputs = blockOutputs + ((numSegments - 1) * (maxBlockSize + 1)) + 1;
+
+        for (int i = startIndex; i < endIndex; i++)
+            output[i] += lastOutputs[i];
+
+        writePos -= numSamples;
+        writePos += writePos < 0 ? lineLength : 0;
+    }
+
+    //======================= Explicit Instantiations =========================//
+
+    template class WaveguideNetwork<float>;
+    template class WaveguideNetwork<double>;
+}
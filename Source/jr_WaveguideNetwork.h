@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+    jr_WaveguideNetwork.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "jr_MemoryArena.h"     // used for jr::MemoryArena
+#include "jr_Snapshot.h"        // used for jr::SnapshotWriter / SnapshotReader
+
+namespace jr {
+
+    /** A chain of delay line segments joined end to end, with signals injected at the junctions between them and taps feeding segment outputs
+    back into earlier segments. The shape of the network (number of segments, injection points and feedback taps) is set before prepare(),
+    and every segment is one line of a single delay bank in a jr::MemoryArena, sharing one write position. Each segment behaves the same as a
+    jr::DelayLine with the same maximum delay, so a network can stand in for a set of separate delay lines without changing the sound.
+    processBlock() works through runs of samples no longer than the shortest delay, in which no segment reads a sample written during the run,
+    so each segment is read and written as a block. A delay below 1 sample falls back to processing one sample at a time.
+    Use setLayout(), setInjectionPoint() and setFeedbackTap(), then getRequiredMemory() and prepare(), then call process() each sample or processBlock() for output.
+    * @tparam SampleType - float or double
+    */
+    template <typename SampleType>
+    class WaveguideNetwork
+    {
+    public:
+
+        static constexpr int maxSegments{ 16 };             // most segments a network can hold
+        static constexpr int maxInjectionPoints{ 16 };      // most injection points a network can hold
+        static constexpr int maxFeedbackTaps{ 8 };          // most feedback taps a network can hold
+        static constexpr int maxBlockSize{ 64 };            // most samples processed at once, longer blocks are split
+
+        /** Sets the shape of the network - call before getRequiredMemory() and prepare()
+        * @param numSegmentsIn - number of segments (1 to maxSegments)
+        * @param numInjectionPointsIn - number of injection points (0 to maxInjectionPoints)
+        * @param numFeedbackTapsIn - number of feedback taps (0 to maxFeedbackTaps)
+        */
+        void setLayout (int numSegmentsIn, int numInjectionPointsIn, int numFeedbackTapsIn);
+
+        /** Sets where a signal is injected into the network. An injection point adds its signal to the input of a segment, and can be heard
+        in the output along with the output of the segment before it
+        * @param injectionNum - index of injection point (0 to number of injection points - 1)
+        * @param segment - index of the segment the signal is added to the input of
+        * @param isHeard - true to also add the signal to the network output
+        */
+        void setInjectionPoint (int injectionNum, int segment, bool isHeard);
+
+        /** Sets which segments a feedback tap connects. The tap adds the previous sample of one segment's output to the input of another
+        * @param tapNum - index of feedback tap (0 to number of feedback taps - 1)
+        * @param fromSegment - index of the segment whose output is fed back
+        * @param toSegment - index of the segment whose input it is added to
+        */
+        void setFeedbackTap (int tapNum, int fromSegment, int toSegment);
+
+        /** Returns the number of bytes of arena memory the delay bank and block buffers need
+        * @param maxDelayInSamples - maximum delay of every segment, samples
+        */
+        size_t getRequiredMemory (int maxDelayInSamples) const;
+
+        /** Sets the sample rate and maximum delay and takes the delay bank and block buffers from the arena, clearing the delay bank
+        * @param sr - sample rate, Hz
+        * @param maxDelayInSamples - maximum delay of every segment, samples
+        * @param arena - arena with room for getRequiredMemory() bytes
+        */
+        void prepare (SampleType sr, int maxDelayInSamples, jr::MemoryArena& arena);
+
+        /** Sets the length of a segment, which is scaled by the segment's modulation each sample
+        * @param segment - index of segment
+        * @param lengthInMs - length, ms
+        */
+        void setSegmentLength (int segment, SampleType lengthInMs);
+
+        /** Sets the gain of a feedback tap
+        * @param tapNum - index of feedback tap
+        * @param gain - feedback gain (0-1)
+        */
+        void setFeedbackGain (int tapNum, SampleType gain);
+
+        /** Returns the next sample value of the network, the sum of every segment output and heard injection
+        * @param input - current sample value fed into the first segment
+        * @param injections - current sample value of each injection point
+        * @param modulations - current scale of each segment's length (a negative scale keeps the segment's last delay)
+        */
+        SampleType process (SampleType input, const SampleType* injections, const SampleType* modulations);
+
+        /** Processes a block of samples, giving the same output as calling process() for each
+        * @param output - array to write the network output to
+        * @param input - samples fed into the first segment
+        * @param injections - samples of each injection point
+        * @param modulations - scale of each segment's length for each sample (a negative scale keeps the segment's last delay)
+        * @param numSamples - number of samples
+        */
+        void processBlock (SampleType* output, const SampleType* input, const SampleType* const* injections, const SampleType* const* modulations, int numSamples);
+
+        /** Writes the complete DSP state of the network to a snapshot
+        * @param writer - snapshot writer
+        */
+        void saveState (jr::SnapshotWriter& writer) const;
+
+        /** Reads the complete DSP state of the network from a snapshot taken from a network prepared the same way
+        * @param reader - snapshot reader
+        */
+        void loadState (jr::SnapshotReader& reader);
+
+        /** Returns the memory used by the network, including its delay bank and block buffers in the arena
+        */
+        jr::MemoryFootprint getMemoryFootprint() const { return { sizeof (*this), bank == nullptr ? 0 : getRequiredMemory (lineLength - 2) }; }
+
+    private:
+
+        /** Returns the length of each line of the delay bank for a maximum delay, matching jr::DelayLine
+        * @param maxDelayInSamples - maximum delay, samples
+        */
+        static int getLineLength (int maxDelayInSamples) { return juce::jmax (4, maxDelayInSamples + 2); }
+
+        /** Returns the delay of a segment for a modulation, samples (negative if the modulation is)
+        * @param segment - index of segment
+        * @param modulation - scale of the segment's length
+        */
+        SampleType getModulatedDelay (int segment, SampleType modulation) const { return sampleRate * ((segmentLengths[segment] * modulation) / 1000.0f); }
+
+        /** Sets the delay of a segment for a sample of the chunk, keeping the last delay if the new one is negative, as jr::DelayLine::popSample() does
+        * @param segment - index of segment
+        * @param sampleIndex - index of the sample in the chunk
+        * @param newDelay - delay, samples
+        */
+        void storeDelay (int segment, int sampleIndex, SampleType newDelay)
+        {
+            if (newDelay >= 0)
+                delays[segment] = juce::jmin (newDelay, (SampleType) (lineLength - 2));
+
+            int blockIndex = (segment * maxBlockSize) + sampleIndex;
+            blockDelayInts[blockIndex] = (int) delays[segment];
+            blockDelayFracs[blockIndex] = delays[segment] - (SampleType) blockDelayInts[blockIndex];
+        }
+
+        /** Processes up to maxBlockSize samples, see processBlock()
+        */
+        void processChunk (SampleType* output, const SampleType* input, const SampleType* const* injections, const SampleType* const* modulations, int numSamples);
+
+        /** Sums the injections into the input of each segment for a chunk, split into those that are heard and those that aren't
+        * @param injections - samples of each injection point
+        * @param numSamples - number of samples in the chunk
+        */
+        void gatherInjections (const SampleType* const* injections, int numSamples);
+
+        /** Works out the delay of every segment for each sample of a chunk
+        * @param modulations - scale of each segment's length for each sample
+        * @param numSamples - number of samples in the chunk
+        */
+        void updateDelays (const SampleType* const* modulations, int numSamples);
+
+        /** Returns the sum of the feedback taps into a segment, from the segment outputs of the sample before
+        * @param segment - index of segment
+        * @param sampleIndex - index of the sample in the chunk
+        */
+        SampleType getFeedback (int segment, int sampleIndex) const;
+
+        /** Processes one sample of a chunk, working through the segments in order - used when a delay is too short for a run
+        * @param output - chunk output
+        * @param input - chunk input
+        * @param sampleIndex - index of the sample in the chunk
+        */
+        void processSample (SampleType* output, const SampleType* input, int sampleIndex);
+
+        /** Processes a run of samples of a chunk in which no segment reads a sample written during the run, a segment at a time
+        * @param output - chunk output
+        * @param input - chunk input
+        * @param startIndex - index of the first sample of the run in the chunk
+        * @param numSamples - length of the run
+        */
+        void processRun (SampleType* output, const SampleType* input, int startIndex, int numSamples);
+
+    private:
+        SampleType sampleRate{ 44100 };                 // sample rate, Hz
+        SampleType* bank{ nullptr };                    // delay bank, one line per segment (owned by the arena passed to prepare())
+        SampleType* blockOutputs{ nullptr };            // output of each segment for each sample of the chunk, after the output of the sample before it (arena)
+        int* blockDelayInts{ nullptr };                 // integer part of each segment's delay for each sample of the chunk (arena)
+        SampleType* blockDelayFracs{ nullptr };         // fractional part of each segment's delay for each sample of the chunk (arena)
+        SampleType* blockHeardInputs{ nullptr };        // sum of heard injections into each segment for each sample of the chunk (arena)
+        SampleType* blockUnheardInputs{ nullptr };      // sum of injections into each segment that aren't heard for each sample of the chunk (arena)
+        int lineLength{ 4 };                            // length of each line of the delay bank, samples
+        int writePos{};                                 // index of each line the next sample is written to (moves backwards through the line)
+
+        int numSegments{ 1 };                           // number of segments
+        int numInjectionPoints{};                       // number of injection points
+        int numFeedbackTaps{};                          // number of feedback taps
+
+        SampleType segmentLengths[maxSegments]{};       // length of each segment, ms
+        SampleType delays[maxSegments]{};               // current delay of each segment, samples
+        SampleType segmentOutputs[maxSegments]{};       // output of each segment for the last sample processed
+
+        int injectionSegments[maxInjectionPoints]{};    // segment each injection point feeds
+        bool injectionsHeard[maxInjectionPoints]{};     // whether each injection point is added to the output
+
+        int feedbackSources[maxFeedbackTaps]{};         // segment each feedback tap reads from
+        int feedbackDestinations[maxFeedbackTaps]{};    // segment each feedback tap adds to
+        SampleType feedbackGains[maxFeedbackTaps]{};    // gain of each feedback tap
+    };
+}
@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "jr_GoldenOutputTests.h"           // used for GoldenOutputTests::writeReferences()
+
+/** Runs every MechanicalModelling unit test headless and returns 1 if any fail, so the tests can gate a build.
+Run with --write-references <folder> to render the golden output scenarios into a folder instead, to replace Tests/GoldenRenders after an intended change in sound
+*/
+int main (int argc, char* argv[])
+{
+    if (argc == 3 && juce::String (argv[1]) == "--write-references")
+        return GoldenOutputTests::writeReferences (juce::File::getCurrentWorkingDirectory().getChildFile (argv[2])) ? 0 : 1;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+    runner.runTestsInCategory ("MechanicalModelling");
+
+    int numFailures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); i++)
+        numFailures += runner.getResult (i)->failures;
+
+    return numFailures > 0 ? 1 : 0;
+}
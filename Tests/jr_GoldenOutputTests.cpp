@@ -0,0 +1,323 @@
+/*
+  ==============================================================================
+
+    jr_GoldenOutputTests.cpp
+
+  ==============================================================================
+*/
+
+#include "jr_GoldenOutputTests.h"
+#include <complex>                          // used for std::complex
+#include <cstring>                          // used for std::memcpy()
+
+namespace
+{
+    constexpr int blockSize{ 64 };                      // samples rendered between control value updates
+    constexpr int fftOrder{ 11 };                       // spectra are taken from frames of 2^fftOrder samples
+    constexpr int fftSize{ 1 << fftOrder };             // spectrum frame size, samples
+    constexpr double spectralFloorDb{ -90.0 };          // level below the loudest bin that spectra are floored to, dB
+    constexpr double loudnessWindowSeconds{ 0.05 };     // short-term loudness window, seconds
+    constexpr double loudnessGateDb{ -70.0 };           // level below which loudness windows are skipped, dB
+
+    /** Transforms a frame in place with an iterative radix-2 FFT
+    * @param frame - fftSize samples, replaced by their spectrum
+    */
+    void performFFT (std::complex<double>* frame)
+    {
+        for (int i = 1, j = 0; i < fftSize; i++)
+        {
+            int bit = fftSize >> 1;
+
+            for (; (j & bit) != 0; bit >>= 1)
+                j ^= bit;
+
+            j ^= bit;
+
+            if (i < j)
+                std::swap (frame[i], frame[j]);
+        }
+
+        for (int length = 2; length <= fftSize; length <<= 1)
+        {
+            double angle = -juce::MathConstants<double>::twoPi / length;
+            std::complex<double> step (std::cos (angle), std::sin (angle));
+
+            for (int start = 0; start < fftSize; start += length)
+            {
+                std::complex<double> twiddle (1.0);
+
+                for (int k = 0; k < length / 2; k++)
+                {
+                    std::complex<double> even = frame[start + k];
+                    std::complex<double> odd = frame[start + k + (length / 2)] * twiddle;
+                    frame[start + k] = even + odd;
+                    frame[start + k + (length / 2)] = even - odd;
+                    twiddle *= step;
+                }
+            }
+        }
+    }
+
+    /** Returns the long-term power spectrum of a render in dB, the power of every Hann windowed frame (half overlapped) of both channels summed per bin
+    * @param buffer - render
+    */
+    std::vector<double> getLongTermSpectrum (const juce::AudioBuffer<float>& buffer)
+    {
+        std::vector<double> power (fftSize / 2 + 1, 0.0);
+        std::vector<std::complex<double>> frame (fftSize);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+        {
+            const float* samples = buffer.getReadPointer (channel);
+
+            for (int start = 0; start + fftSize <= buffer.getNumSamples(); start += fftSize / 2)
+            {
+                for (int i = 0; i < fftSize; i++)
+                {
+                    double window = 0.5 - (0.5 * std::cos (juce::MathConstants<double>::twoPi * i / fftSize));
+                    frame[(size_t) i] = samples[start + i] * window;
+                }
+
+                performFFT (frame.data());
+
+                for (size_t bin = 0; bin < power.size(); bin++)
+                    power[bin] += std::norm (frame[bin]);
+            }
+        }
+
+        for (auto& bin : power)
+            bin = 10.0 * std::log10 (bin + 1.0e-30);
+
+        return power;
+    }
+
+    /** Returns the short-term loudness of a render, the mean square of both channels over each window in dB
+    * @param buffer - render
+    */
+    std::vector<double> getShortTermLoudness (const juce::AudioBuffer<float>& buffer)
+    {
+        const int windowSize = (int) (loudnessWindowSeconds * GoldenOutputTests::sampleRate);
+        std::vector<double> loudness;
+
+        for (int start = 0; start + windowSize <= buffer.getNumSamples(); start += windowSize)
+        {
+            double sumOfSquares = 0.0;
+
+            for (int channel = 0; channel < buffer.getNumChannels(); channel++)
+                for (int i = 0; i < windowSize; i++)
+                    sumOfSquares += (double) buffer.getSample (channel, start + i) * buffer.getSample (channel, start + i);
+
+            loudness.push_back (10.0 * std::log10 ((sumOfSquares / (windowSize * buffer.getNumChannels())) + 1.0e-30));
+        }
+
+        return loudness;
+    }
+}
+
+//========================= test ===========================//
+
+void GoldenOutputTests::runTest()
+{
+    for (const auto& scenario : createScenarios())
+    {
+        beginTest (scenario.name);
+
+        auto output = render (scenario);
+        int numBytes = 0;
+        const char* data = BinaryData::getNamedResource ((scenario.name + "_f32").toRawUTF8(), numBytes);
+
+        expect (data != nullptr, "no reference render for " + scenario.name);
+        expectEquals (numBytes, (int) (output.getNumSamples() * output.getNumChannels() * sizeof (float)), "reference render is the wrong length");
+
+        if (data == nullptr || numBytes != (int) (output.getNumSamples() * output.getNumChannels() * sizeof (float)))
+            continue;
+
+        juce::AudioBuffer<float> reference (output.getNumChannels(), output.getNumSamples());
+
+        for (int i = 0; i < reference.getNumSamples(); i++)
+        {
+            for (int channel = 0; channel < reference.getNumChannels(); channel++)
+            {
+                float sample;
+                std::memcpy (&sample, data + (((i * reference.getNumChannels()) + channel) * sizeof (float)), sizeof (float));
+                reference.setSample (channel, i, sample);
+            }
+        }
+
+        double sampleError = getMaxSampleError (output, reference);
+        double spectralDistance = getSpectralDistance (output, reference);
+        double loudnessDifference = getMaxLoudnessDifference (output, reference);
+
+        logMessage ("max sample error " + juce::String (sampleError, 9) + ", spectral distance " + juce::String (spectralDistance, 4)
+                    + "dB, max loudness difference " + juce::String (loudnessDifference, 4) + "dB");
+
+        expectLessOrEqual (sampleError, scenario.tolerances.maxSampleError, "sample error");
+        expectLessOrEqual (spectralDistance, scenario.tolerances.maxSpectralDistance, "spectral distance");
+        expectLessOrEqual (loudnessDifference, scenario.tolerances.maxLoudnessDifference, "loudness difference");
+    }
+}
+
+bool GoldenOutputTests::writeReferences (const juce::File& folder)
+{
+    if (! folder.createDirectory())
+        return false;
+
+    for (const auto& scenario : createScenarios())
+    {
+        auto output = render (scenario);
+        std::vector<float> interleaved ((size_t) (output.getNumSamples() * output.getNumChannels()));
+
+        for (int i = 0; i < output.getNumSamples(); i++)
+            for (int channel = 0; channel < output.getNumChannels(); channel++)
+                interleaved[(size_t) ((i * output.getNumChannels()) + channel)] = output.getSample (channel, i);
+
+        if (! folder.getChildFile (scenario.name + ".f32").replaceWithData (interleaved.data(), interleaved.size() * sizeof (float)))
+            return false;
+    }
+
+    return true;
+}
+
+//========================= scenarios ===========================//
+
+std::vector<GoldenOutputTests::Scenario> GoldenOutputTests::createScenarios()
+{
+    // every model is heard in each scenario apart from the fan ones. The tolerances allow for the rounding differences of other compilers
+    // and instruction sets (fused multiply-adds move the phasors by up to about a tenth of each tolerance), which grow with the length of the render
+    MachineParams on;
+    on.trigger = true;
+    on.powerUpTime = 1.0f;
+    on.powerDownTime = 0.75f;
+    on.motorGain = 0.4f;
+    on.fanGain = 0.4f;
+    on.fanStereoWidth = 0.5f;
+    on.engineGain = 0.5f;
+    on.engineRevs = 0.3f;
+
+    MachineParams off = on;
+    off.trigger = false;
+
+    MachineParams fan = on;
+    fan.motorGain = 0.0f;
+    fan.engineGain = 0.0f;
+    fan.fanGain = 0.8f;
+    fan.fanStereoWidth = 0.8f;
+
+    std::vector<Scenario> scenarios (6);
+
+    scenarios[0].name = "power_up";
+    scenarios[0].timeline.addControlPoint (0.0, on);
+    scenarios[0].timeline.setLengthInSeconds (1.25);
+    scenarios[0].tolerances = { 2.0e-3, 0.02, 0.05 };
+
+    scenarios[1].name = "steady_state";
+    scenarios[1].timeline.addControlPoint (0.0, on);
+    scenarios[1].timeline.setLengthInSeconds (0.5);
+    scenarios[1].startsSteady = true;
+    scenarios[1].tolerances = { 5.0e-4, 0.02, 0.02 };
+
+    scenarios[2].name = "power_down";
+    scenarios[2].timeline.addControlPoint (0.0, on);
+    scenarios[2].timeline.addControlPoint (0.1, off);
+    scenarios[2].timeline.setLengthInSeconds (1.0);
+    scenarios[2].startsSteady = true;
+    scenarios[2].tolerances = { 5.0e-4, 0.02, 0.02 };
+
+    // engine revs stepped from 0 to 1 every 50ms, leaving the engine's own smoothing to join the steps
+    scenarios[3].name = "revs_sweep";
+    scenarios[3].startsSteady = true;
+    scenarios[3].tolerances = { 3.0e-3, 0.02, 0.05 };
+
+    for (int step = 0; step <= 20; step++)
+    {
+        MachineParams sweep = on;
+        sweep.engineRevs = step / 20.0f;
+        scenarios[3].timeline.addControlPoint (step * 0.05, sweep);
+    }
+
+    scenarios[3].timeline.setLengthInSeconds (1.05);
+
+    scenarios[4].name = "fan_doppler_off";
+    scenarios[4].timeline.addControlPoint (0.0, fan);
+    scenarios[4].timeline.setLengthInSeconds (0.5);
+    scenarios[4].startsSteady = true;
+    scenarios[4].tolerances = { 2.0e-5, 0.02, 0.02 };
+
+    fan.fanDoppler = true;
+    scenarios[5].name = "fan_doppler_on";
+    scenarios[5].timeline.addControlPoint (0.0, fan);
+    scenarios[5].timeline.setLengthInSeconds (0.5);
+    scenarios[5].startsSteady = true;
+    scenarios[5].tolerances = { 2.0e-5, 0.02, 0.02 };
+
+    return scenarios;
+}
+
+juce::AudioBuffer<float> GoldenOutputTests::render (const Scenario& scenario)
+{
+    Machine<float> machine;
+    jr::MemoryArena arena;
+
+    arena.prepare (machine.getRequiredMemory (sampleRate));
+    machine.prepare (sampleRate, arena);
+    machine.setRandomSeed (randomSeed);
+
+    if (scenario.startsSteady)
+        machine.setSteadyState (scenario.timeline.getParamsAt (0.0));
+
+    juce::AudioBuffer<float> output (2, (int) (scenario.timeline.getLengthInSeconds() * sampleRate));
+
+    for (int start = 0; start < output.getNumSamples(); start += blockSize)
+    {
+        machine.setParams (scenario.timeline.getParamsAt (start / sampleRate));
+        machine.process (output.getWritePointer (0, start), output.getWritePointer (1, start), juce::jmin (blockSize, output.getNumSamples() - start));
+    }
+
+    return output;
+}
+
+//========================= metrics ===========================//
+
+double GoldenOutputTests::getMaxSampleError (const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference)
+{
+    double maxError = 0.0;
+
+    for (int channel = 0; channel < output.getNumChannels(); channel++)
+        for (int i = 0; i < output.getNumSamples(); i++)
+            maxError = juce::jmax (maxError, std::abs ((double) output.getSample (channel, i) - reference.getSample (channel, i)));
+
+    return maxError;
+}
+
+double GoldenOutputTests::getSpectralDistance (const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference)
+{
+    auto outputSpectrum = getLongTermSpectrum (output);
+    auto referenceSpectrum = getLongTermSpectrum (reference);
+    double floor = *std::max_element (referenceSpectrum.begin(), referenceSpectrum.end()) + spectralFloorDb;
+    double sumOfSquares = 0.0;
+
+    for (size_t bin = 0; bin < referenceSpectrum.size(); bin++)
+    {
+        double difference = juce::jmax (outputSpectrum[bin], floor) - juce::jmax (referenceSpectrum[bin], floor);
+        sumOfSquares += difference * difference;
+    }
+
+    return std::sqrt (sumOfSquares / referenceSpectrum.size());
+}
+
+double GoldenOutputTests::getMaxLoudnessDifference (const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference)
+{
+    auto outputLoudness = getShortTermLoudness (output);
+    auto referenceLoudness = getShortTermLoudness (reference);
+    double maxDifference = 0.0;
+
+    for (size_t window = 0; window < referenceLoudness.size(); window++)
+        if (outputLoudness[window] > loudnessGateDb || referenceLoudness[window] > loudnessGateDb)
+            maxDifference = juce::jmax (maxDifference, std::abs (outputLoudness[window] - referenceLoudness[window]));
+
+    return maxDifference;
+}
+
+//======================= Registration =========================//
+
+static GoldenOutputTests goldenOutputTests;
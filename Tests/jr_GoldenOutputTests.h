@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    jr_GoldenOutputTests.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../Source/jr_OfflineRenderer.h"   // used for MachineTimeline
+
+/** Renders a fixed set of machine scenarios (power up, steady state, power down, a revs sweep, and the fan with and without doppler) with fixed seeds
+and compares each with its stored reference render, so that an optimisation of the models can't change their sound unnoticed. Each scenario is
+compared by its largest sample error, the distance between the long-term spectra and the largest difference in short-term loudness, each within
+a tolerance set for the scenario. The references are raw 32-bit little-endian floats (stereo, interleaved) in Tests/GoldenRenders, built into
+the test app as binary resources
+*/
+class GoldenOutputTests : public juce::UnitTest
+{
+public:
+    GoldenOutputTests() : juce::UnitTest ("Golden output", "MechanicalModelling") {}
+
+    void runTest() override;
+
+    /** Renders every scenario and writes it to <name>.f32 in a folder, used to replace the references after an intended change in sound.
+    Returns false if a file couldn't be written
+    * @param folder - folder to write to, created if needed
+    */
+    static bool writeReferences (const juce::File& folder);
+
+    static constexpr double sampleRate{ 48000.0 };          // sample rate of every scenario, Hz
+    static constexpr juce::int64 randomSeed{ 31 };          // seed of every scenario
+
+private:
+
+    /** The most each metric of a render may differ from its reference
+    */
+    struct Tolerances
+    {
+        double maxSampleError{};                            // largest difference of any sample
+        double maxSpectralDistance{};                       // RMS difference of the long-term spectra over the bins in use, dB
+        double maxLoudnessDifference{};                     // largest difference of the short-term loudness, dB
+    };
+
+    /** A fixed render of the machine
+    */
+    struct Scenario
+    {
+        juce::String name;                                  // name of the scenario and of its reference file
+        MachineTimeline timeline;                           // control values over the render, whose length is the length of the render
+        bool startsSteady{ false };                         // true to start in the steady state of the first control values, false to start from rest
+        Tolerances tolerances;                              // tolerances of the comparison with the reference
+    };
+
+    /** Returns every scenario
+    */
+    static std::vector<Scenario> createScenarios();
+
+    /** Renders a scenario, following its timeline a block at a time
+    * @param scenario - scenario to render
+    */
+    static juce::AudioBuffer<float> render (const Scenario& scenario);
+
+    /** Returns the largest difference between any two samples of a render and its reference
+    * @param output - render
+    * @param reference - reference render, the same size
+    */
+    static double getMaxSampleError (const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference);
+
+    /** Returns the RMS difference between the long-term power spectra of a render and its reference, dB. Bins more than 90dB below the reference's
+    loudest bin are raised to that floor, so that differences in near silence don't count
+    * @param output - render
+    * @param reference - reference render, the same size
+    */
+    static double getSpectralDistance (const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference);
+
+    /** Returns the largest difference between the short-term loudness (mean square of both channels over 50ms windows) of a render and its reference, dB.
+    Windows where both are below -70dB are skipped
+    * @param output - render
+    * @param reference - reference render, the same size
+    */
+    static double getMaxLoudnessDifference (const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& reference);
+};
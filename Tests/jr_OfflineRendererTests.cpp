@@ -0,0 +1,219 @@
+/*
+  ==============================================================================
+
+    jr_OfflineRendererTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <cstring>                                  // used for std::memcmp()
+#include "../Source/jr_OfflineRenderer.h"           // used for OfflineRenderer / MachineTimeline
+
+/** Checks that a timeline rendered in parallel is the same whatever the number of threads, and that the seams between its segments are continuous:
+no larger sample to sample step than the render has either side of the seam, and the same loudness as a render made in one segment.
+The seams are checked on the fan's tone alone, as the noise of the other sources would hide a step. A render with no crossfade is checked too,
+to show that the check finds the steps of segments joined without one
+*/
+class OfflineRendererTests : public juce::UnitTest
+{
+public:
+    OfflineRendererTests() : juce::UnitTest ("Offline renderer", "MechanicalModelling") {}
+
+    void runTest() override
+    {
+        testThreadCounts<float>();
+        testThreadCounts<double>();
+        testSeams();
+    }
+
+private:
+
+    static constexpr double segmentSeconds{ 0.5 };      // segment length of the parallel renders, seconds
+    static constexpr double maxStepRatio{ 2.0 };        // largest step at a seam, as a multiple of the largest step either side of it
+    static constexpr double maxSeamLoudnessDb{ 2.0 };   // largest difference in loudness at a seam from the render in one segment, dB
+    static constexpr double loudnessGateDb{ -70.0 };    // level below which the loudness at a seam isn't compared, dB
+
+    /** Returns a 4 second timeline that powers up, sweeps the revs, powers down and up again, so that seams fall in every state
+    * @param isToneOnly - true for the fan's tone alone, false for every source
+    */
+    static MachineTimeline createTimeline (bool isToneOnly)
+    {
+        MachineParams params;
+        params.powerUpTime = 0.5f;
+        params.powerDownTime = 0.5f;
+        params.motorGain = isToneOnly ? 0.0f : 0.4f;
+        params.fanGain = 0.4f;
+        params.fanNoiseLevel = isToneOnly ? 0.0f : 0.75f;
+        params.fanStereoWidth = 0.5f;
+        params.fanDoppler = true;
+        params.engineGain = isToneOnly ? 0.0f : 0.5f;
+
+        MachineTimeline timeline;
+        timeline.addControlPoint (0.0, params);
+
+        params.trigger = true;
+        timeline.addControlPoint (0.1, params);
+
+        for (int step = 1; step <= 5; step++)
+        {
+            params.engineRevs = step / 5.0f;
+            timeline.addControlPoint (0.1 + (step * 0.4), params);
+        }
+
+        params.trigger = false;
+        timeline.addControlPoint (2.4, params);
+
+        params.trigger = true;
+        timeline.addControlPoint (3.3, params);
+
+        timeline.setLengthInSeconds (4.0);
+        return timeline;
+    }
+
+    /** Returns the render settings with a number of threads
+    * @param numThreads - number of threads
+    */
+    static typename OfflineRenderer<float>::Settings createSettings (int numThreads)
+    {
+        OfflineRenderer<float>::Settings settings;
+        settings.segmentSeconds = segmentSeconds;
+        settings.preRollSeconds = 0.5;
+        settings.numThreads = numThreads;
+        settings.randomSeed = 33;
+        return settings;
+    }
+
+    template <typename SampleType>
+    void testThreadCounts()
+    {
+        beginTest (juce::String ("Renders the same on any number of threads (") + (sizeof (SampleType) == sizeof (float) ? "float" : "double") + ")");
+
+        auto timeline = createTimeline (false);
+        const auto floatSettings = createSettings (1);
+
+        typename OfflineRenderer<SampleType>::Settings settings;
+        settings.segmentSeconds = floatSettings.segmentSeconds;
+        settings.preRollSeconds = floatSettings.preRollSeconds;
+        settings.randomSeed = floatSettings.randomSeed;
+        settings.numThreads = 1;
+
+        juce::AudioBuffer<SampleType> singleThreaded;
+        OfflineRenderer<SampleType>::render (timeline, singleThreaded, settings);
+
+        for (int numThreads : { 3, 8 })
+        {
+            settings.numThreads = numThreads;
+            juce::AudioBuffer<SampleType> multiThreaded;
+            OfflineRenderer<SampleType>::render (timeline, multiThreaded, settings);
+
+            expectEquals (multiThreaded.getNumSamples(), singleThreaded.getNumSamples());
+
+            for (int channel = 0; channel < 2; channel++)
+                expect (std::memcmp (multiThreaded.getReadPointer (channel), singleThreaded.getReadPointer (channel), sizeof (SampleType) * (size_t) singleThreaded.getNumSamples()) == 0,
+                        "channel " + juce::String (channel) + " differs on " + juce::String (numThreads) + " threads");
+        }
+    }
+
+    void testSeams()
+    {
+        beginTest ("Seams are continuous");
+
+        auto timeline = createTimeline (true);
+        auto settings = createSettings (0);
+
+        juce::AudioBuffer<float> whole;
+        settings.segmentSeconds = timeline.getLengthInSeconds();
+        OfflineRenderer<float>::render (timeline, whole, settings);
+
+        juce::AudioBuffer<float> segmented;
+        settings.segmentSeconds = segmentSeconds;
+        OfflineRenderer<float>::render (timeline, segmented, settings);
+
+        const int segmentLength = (int) (segmentSeconds * settings.sampleRate);
+        const int crossfadeLength = (int) (settings.crossfadeSeconds * settings.sampleRate);
+
+        for (int seam = segmentLength; seam < segmented.getNumSamples(); seam += segmentLength)
+        {
+            double stepRatio = getSeamStepRatio (segmented, seam, crossfadeLength);
+            double loudness = getLoudness (segmented, seam - crossfadeLength, 2 * crossfadeLength);
+            double loudnessDifference = loudness - getLoudness (whole, seam - crossfadeLength, 2 * crossfadeLength);
+
+            logMessage ("seam at " + juce::String (seam) + ": step " + juce::String (stepRatio, 3) + " times the largest either side, loudness "
+                        + juce::String (loudnessDifference, 3) + "dB from one segment");
+
+            expectLessOrEqual (stepRatio, maxStepRatio, "step at seam " + juce::String (seam));
+
+            if (loudness > loudnessGateDb)
+                expectLessOrEqual (std::abs (loudnessDifference), maxSeamLoudnessDb, "loudness at seam " + juce::String (seam));
+        }
+
+        // without a crossfade the segments' oscillators are out of phase at the seams, which the check must find
+        juce::AudioBuffer<float> joined;
+        settings.crossfadeSeconds = 0.0;
+        OfflineRenderer<float>::render (timeline, joined, settings);
+
+        double maxJoinedStepRatio = 0.0;
+
+        for (int seam = segmentLength; seam < joined.getNumSamples(); seam += segmentLength)
+            maxJoinedStepRatio = juce::jmax (maxJoinedStepRatio, getSeamStepRatio (joined, seam, 0));
+
+        expect (maxJoinedStepRatio > maxStepRatio, "segments joined without a crossfade weren't found to step");
+    }
+
+    /** Returns the largest step of a render at a seam and its crossfade, as a multiple of the largest step in the 100ms either side (0 in silence)
+    * @param buffer - render
+    * @param seam - first sample of the segment after the seam
+    * @param crossfadeLength - length of the crossfade before the seam, samples
+    */
+    static double getSeamStepRatio (const juce::AudioBuffer<float>& buffer, int seam, int crossfadeLength)
+    {
+        const int margin = 64;
+        const int neighbourhood = 4800;
+        const int seamStart = seam - crossfadeLength - margin;
+        const int seamEnd = seam + margin;
+
+        double maxSeamStep = 0.0;
+        double maxStep = 0.0;
+
+        for (int i = juce::jmax (1, seamStart - neighbourhood); i < juce::jmin (buffer.getNumSamples(), seamEnd + neighbourhood); i++)
+        {
+            if (i >= seamStart && i < seamEnd)
+                maxSeamStep = juce::jmax (maxSeamStep, getStep (buffer, i));
+            else
+                maxStep = juce::jmax (maxStep, getStep (buffer, i));
+        }
+
+        return maxStep > 0.0 ? maxSeamStep / maxStep : 0.0;
+    }
+
+    /** Returns the largest difference between a sample and the one before it in either channel
+    * @param buffer - render
+    * @param index - index of the sample
+    */
+    static double getStep (const juce::AudioBuffer<float>& buffer, int index)
+    {
+        return juce::jmax (std::abs (buffer.getSample (0, index) - buffer.getSample (0, index - 1)),
+                           std::abs (buffer.getSample (1, index) - buffer.getSample (1, index - 1)));
+    }
+
+    /** Returns the mean square of both channels over a range of samples, dB
+    * @param buffer - render
+    * @param startSample - first sample
+    * @param numSamples - number of samples
+    */
+    static double getLoudness (const juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        double sumOfSquares = 0.0;
+
+        for (int channel = 0; channel < 2; channel++)
+            for (int i = startSample; i < startSample + numSamples; i++)
+                sumOfSquares += (double) buffer.getSample (channel, i) * buffer.getSample (channel, i);
+
+        return 10.0 * std::log10 ((sumOfSquares / (2 * numSamples)) + 1.0e-30);
+    }
+};
+
+//======================= Registration =========================//
+
+static OfflineRendererTests offlineRendererTests;
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    jr_PluginProcessorTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <cmath>                                    // used for std::isfinite()
+#include "../Source/PluginProcessor.h"              // used for MechanicalModellingAudioProcessor
+#include "../Source/jr_RealtimeChecker.h"           // used for jr::realtime::getNumViolations()
+
+/** Drives the plugin processor as a host would: prepares it at a series of sample rates in both precisions with the input and stem buses
+enabled, then calls processBlock() while sweeping every parameter through the value tree and sending notes, the mod wheel and pitch bend.
+processBlock() holds its own realtime check, so debug builds also expect no allocations or locks
+*/
+class PluginProcessorTests : public juce::UnitTest
+{
+public:
+    PluginProcessorTests() : juce::UnitTest ("Plugin processor", "MechanicalModelling") {}
+
+    void runTest() override
+    {
+        juce::ScopedJuceInitialiser_GUI juceInitialiser;    // the parameters need a message manager
+
+        testProcessBlock<float>();
+        testProcessBlock<double>();
+    }
+
+private:
+
+    /** Prepares one processor at several sample rates, alternating compact storage and mono/stereo stems, and at each renders two seconds
+    in blocks of varying size with the trigger on for the first second
+    */
+    template <typename SampleType>
+    void testProcessBlock()
+    {
+        const bool isDouble = sizeof (SampleType) == sizeof (double);
+        beginTest (juce::String ("processBlock (AudioBuffer<") + (isDouble ? "double" : "float") + ">) renders without allocating or locking");
+
+        constexpr int maxBlockSize{ 1024 };
+        const double sampleRates[] = { 44100.0, 96000.0, 22050.0, 48000.0 };
+
+        MechanicalModellingAudioProcessor processor;
+        const auto& parameters = processor.getParameters();
+        juce::AudioProcessorParameter* triggerParameter = nullptr;
+
+        for (auto* parameter : parameters)
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+                if (withID->paramID == "trigger")
+                    triggerParameter = parameter;
+
+        expect (triggerParameter != nullptr);
+
+        if (triggerParameter == nullptr)
+            return;
+
+        juce::AudioBuffer<SampleType> buffer;
+        juce::MidiBuffer midiMessages;
+        juce::Random random (26);
+        int numViolationsBefore = jr::realtime::getNumViolations();
+
+        for (int rateIndex = 0; rateIndex < juce::numElementsInArray (sampleRates); rateIndex++)
+        {
+            double sampleRate = sampleRates[rateIndex];
+
+            // stereo input and main output, with every stem bus enabled as mono or stereo
+            auto layout = processor.getBusesLayout();
+            layout.inputBuses.getReference (0) = juce::AudioChannelSet::stereo();
+            layout.outputBuses.getReference (0) = juce::AudioChannelSet::stereo();
+
+            for (int stem = 1; stem < layout.outputBuses.size(); stem++)
+                layout.outputBuses.getReference (stem) = ((rateIndex + stem) % 2) == 0 ? juce::AudioChannelSet::stereo() : juce::AudioChannelSet::mono();
+
+            expect (processor.setBusesLayout (layout), "buses layout is supported");
+
+            processor.setProcessingPrecision (isDouble ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+            processor.setCompactDelayStorage (rateIndex % 2 == 1);
+            processor.setRateAndBufferSizeDetails (sampleRate, maxBlockSize);
+            processor.prepareToPlay (sampleRate, maxBlockSize);
+
+            buffer.setSize (juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), maxBlockSize);
+            bool isFinite = true;
+
+            for (int position = 0, block = 0; position < (int) (2.0 * sampleRate); block++)
+            {
+                int numSamples = 1 + random.nextInt (maxBlockSize);
+
+                // every parameter is swept through its range, each from a different point
+                for (int i = 0; i < parameters.size(); i++)
+                    if (parameters[i] != triggerParameter)
+                        parameters[i]->setValueNotifyingHost ((float) ((block + (i * 7)) % 50) / 49.0f);
+
+                triggerParameter->setValueNotifyingHost (position < (int) sampleRate ? 1.0f : 0.0f);
+
+                // notes are held for a few blocks at a time, with the mod wheel and pitch bend moving in every block
+                midiMessages.clear();
+
+                if (block % 8 == 0)
+                    midiMessages.addEvent (juce::MidiMessage::noteOn (1, 60, (juce::uint8) 100), random.nextInt (numSamples));
+                else if (block % 8 == 4)
+                    midiMessages.addEvent (juce::MidiMessage::noteOff (1, 60), random.nextInt (numSamples));
+
+                midiMessages.addEvent (juce::MidiMessage::controllerEvent (1, 1, random.nextInt (128)), random.nextInt (numSamples));
+                midiMessages.addEvent (juce::MidiMessage::pitchWheel (1, random.nextInt (16384)), random.nextInt (numSamples));
+
+                juce::AudioBuffer<SampleType> blockBuffer (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+
+                for (int channel = 0; channel < processor.getTotalNumInputChannels(); channel++)
+                    for (int i = 0; i < numSamples; i++)
+                        blockBuffer.setSample (channel, i, (SampleType) (random.nextFloat() - 0.5f));
+
+                processor.processBlock (blockBuffer, midiMessages);
+
+                for (int channel = 0; channel < blockBuffer.getNumChannels(); channel++)
+                    isFinite = isFinite && std::isfinite (blockBuffer.getMagnitude (channel, 0, numSamples));
+
+                position += numSamples;
+            }
+
+            expect (isFinite, "output is finite at " + juce::String (sampleRate) + " Hz");
+            processor.releaseResources();
+        }
+
+        expectEquals (jr::realtime::getNumViolations(), numViolationsBefore);
+    }
+};
+
+//======================= Registration =========================//
+
+static PluginProcessorTests pluginProcessorTests;
@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    jr_RealtimeCheckerTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <mutex>                                    // used for std::mutex
+#include <new>                                      // used for std::nothrow and std::align_val_t
+#include "../Source/jr_RealtimeChecker.h"           // used for jr::realtime
+#include "../Source/jr_Machine.h"                   // used for Machine
+#include "../Source/jr_MachineAPI.h"                // used for jr_machine_render()
+
+/** Checks that the realtime checker catches allocations and locks, then drives a Machine (as processBlock() does) and the C API through
+sample rate changes and parameter sweeps with every block inside a check, expecting no violations. Only runs when JR_REALTIME_CHECKS is on
+*/
+class RealtimeCheckerTests : public juce::UnitTest
+{
+public:
+    RealtimeCheckerTests() : juce::UnitTest ("Realtime checker", "MechanicalModelling") {}
+
+    void runTest() override
+    {
+       #if JR_REALTIME_CHECKS
+        testHooks();
+        testMachine<float>();
+        testMachine<double>();
+        testMachineAPI();
+       #else
+        beginTest ("Realtime checks are off in this build");
+       #endif
+    }
+
+private:
+
+   #if JR_REALTIME_CHECKS
+    /** Runs a function inside a check and returns true if the check saw a violation
+    * @param function - function to run
+    */
+    template <typename Function>
+    static bool isViolation (Function&& function)
+    {
+        int numViolationsBefore = jr::realtime::getNumViolations();
+
+        {
+            jr::realtime::ScopedAudioThreadCheck check;
+            function();
+        }
+
+        return jr::realtime::getNumViolations() > numViolationsBefore;
+    }
+
+    void testHooks()
+    {
+        beginTest ("Hooks catch allocations and locks");
+
+        // the operators are called directly, as new expressions whose memory isn't used may be optimised away
+        void* volatile ptr = nullptr;
+
+        expect (isViolation ([&] { ptr = ::operator new (16); }), "operator new");
+        expect (isViolation ([&] { ::operator delete (ptr); }), "operator delete");
+        expect (isViolation ([&] { ptr = ::operator new[] (16, std::nothrow); }), "nothrow operator new[]");
+        expect (isViolation ([&] { ::operator delete[] (ptr, std::nothrow); }), "nothrow operator delete[]");
+        expect (isViolation ([&] { ptr = ::operator new (16, std::align_val_t (64)); }), "aligned operator new");
+        expect (((juce::pointer_sized_uint) ptr % 64) == 0, "aligned operator new returns aligned memory");
+        expect (isViolation ([&] { ::operator delete (ptr, std::align_val_t (64)); }), "aligned operator delete");
+        expect (! isViolation ([&] { ::operator delete (nullptr); }), "deleting nullptr doesn't count");
+
+        jr::realtime::CriticalSection checkedCriticalSection;
+        jr::realtime::SpinLock checkedSpinLock;
+
+        expect (isViolation ([&] { const jr::realtime::CriticalSection::ScopedLockType lock (checkedCriticalSection); }), "checked CriticalSection");
+        expect (isViolation ([&] { const jr::realtime::SpinLock::ScopedLockType lock (checkedSpinLock); }), "checked SpinLock");
+
+       #if JUCE_LINUX
+        juce::CriticalSection criticalSection;
+        std::mutex mutex;
+
+        expect (isViolation ([&] { const juce::ScopedLock lock (criticalSection); }), "juce::CriticalSection");
+        expect (isViolation ([&] { std::lock_guard<std::mutex> lock (mutex); }), "std::mutex");
+       #endif
+
+        expect (! isViolation ([] {}), "empty callback");
+    }
+
+    /** Prepares one Machine at a series of sample rates as prepareToPlay() does, and at each renders blocks of varying size while sweeping
+    the trigger, revs, speeds, doppler and input mode, with stems and an input
+    */
+    template <typename SampleType>
+    void testMachine()
+    {
+        beginTest (juce::String ("Machine<") + (sizeof (SampleType) == sizeof (float) ? "float" : "double") + "> renders without allocating or locking");
+
+        constexpr int maxBlockSize{ 1024 };
+        const double sampleRates[] = { 44100.0, 96000.0, 22050.0, 48000.0, 192000.0 };
+        const MachineInputMode inputModes[] = { MachineInputMode::OFF, MachineInputMode::WAVEGUIDE, MachineInputMode::RESONATOR, MachineInputMode::MOTOR_SPEED };
+
+        juce::AudioBuffer<SampleType> output (2, maxBlockSize);
+        juce::AudioBuffer<SampleType> stemBuffer (6, maxBlockSize);
+        juce::AudioBuffer<SampleType> input (2, maxBlockSize);
+        juce::Random random (26);
+
+        for (int channel = 0; channel < input.getNumChannels(); channel++)
+            for (int i = 0; i < maxBlockSize; i++)
+                input.setSample (channel, i, (SampleType) (random.nextFloat() - 0.5f));
+
+        typename Machine<SampleType>::Stems stems;
+        stems.engine[0] = stemBuffer.getWritePointer (0);
+        stems.engine[1] = stemBuffer.getWritePointer (1);
+        stems.motor[0] = stemBuffer.getWritePointer (2);
+        stems.fan[0] = stemBuffer.getWritePointer (4);
+        stems.fan[1] = stemBuffer.getWritePointer (5);
+
+        SampleType* const* outputChannels = output.getArrayOfWritePointers();
+        const SampleType* const* inputChannels = input.getArrayOfReadPointers();
+
+        Machine<SampleType> machine;
+        jr::MemoryArena arena;
+        int numViolationsBefore = jr::realtime::getNumViolations();
+
+        for (int rateIndex = 0; rateIndex < juce::numElementsInArray (sampleRates); rateIndex++)
+        {
+            double sampleRate = sampleRates[rateIndex];
+            machine.setCompactStorage (rateIndex % 2 == 1);
+            arena.prepare (machine.getRequiredMemory (sampleRate));
+            machine.prepare (sampleRate, arena);
+
+            MachineParams params;
+            params.motorGain = 0.5f;
+            params.fanGain = 0.5f;
+            params.engineGain = 0.5f;
+            params.powerUpTime = 0.5f;
+            params.powerDownTime = 0.5f;
+
+            // two seconds at each rate, long enough to power up and down
+            for (int position = 0, block = 0; position < (int) (2.0 * sampleRate); block++)
+            {
+                int numSamples = 1 + random.nextInt (maxBlockSize);
+                double time = position / sampleRate;
+
+                params.trigger = time < 1.0;
+                params.engineRevs = (float) std::fmod (time, 1.0);
+                params.motorMaxSpeed = 60.0f + (740.0f * random.nextFloat());
+                params.fanRatio = 10.0f + (20.0f * random.nextFloat());
+                params.fanStereoWidth = random.nextFloat();
+                params.fanDoppler = (block % 3) == 0;
+                params.motorHum = (block % 5) == 0;
+                params.inputMode = inputModes[block % 4];
+
+                {
+                    jr::realtime::ScopedAudioThreadCheck check;
+                    machine.setParams (params);
+                    machine.process (outputChannels, MachineOutputRouting(), 0, numSamples, stems, inputChannels, 2);
+                }
+
+                position += numSamples;
+            }
+        }
+
+        expectEquals (jr::realtime::getNumViolations(), numViolationsBefore);
+    }
+
+    /** Renders through the C API, whose render call holds its own check, at several sample rates while sweeping every parameter
+    */
+    void testMachineAPI()
+    {
+        beginTest ("jr_machine_render() renders without allocating or locking");
+
+        constexpr int maxBlockSize{ 512 };
+        const double sampleRates[] = { 48000.0, 44100.0, 96000.0 };
+        const int channelCounts[] = { 1, 2, 6 };
+
+        // range of each parameter, as documented in jr_MachineAPI.h
+        const float ranges[JR_MACHINE_NUM_PARAMS][2] = { { 0, 1 }, { 0, 1 }, { 0.5f, 10 }, { 0.5f, 10 }, { 0, 1 },
+                                                         { 0, 1 }, { 60, 800 }, { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 },
+                                                         { 0, 1 }, { 10, 30 }, { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 },
+                                                         { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 }, { 0, 1 } };
+
+        juce::AudioBuffer<float> output (6, maxBlockSize);
+        juce::Random random (38);
+        float* const* outputChannels = output.getArrayOfWritePointers();
+        int numViolationsBefore = jr::realtime::getNumViolations();
+
+        for (int rateIndex = 0; rateIndex < juce::numElementsInArray (sampleRates); rateIndex++)
+        {
+            jr_machine* machine = jr_machine_create (sampleRates[rateIndex], rateIndex % 2, 38);
+            expect (machine != nullptr);
+
+            if (machine == nullptr)
+                continue;
+
+            jr_machine_set_param (machine, JR_MACHINE_TRIGGER, 1.0f);
+
+            for (int block = 0; block < 200; block++)
+            {
+                // every parameter is swept through its range, with the trigger switched off for the last quarter
+                for (int param = 1; param < JR_MACHINE_NUM_PARAMS; param++)
+                    jr_machine_set_param (machine, (jr_machine_param) param, ranges[param][0] + ((ranges[param][1] - ranges[param][0]) * (float) (block % 50) / 49.0f));
+
+                jr_machine_set_param (machine, JR_MACHINE_TRIGGER, block < 150 ? 1.0f : 0.0f);
+
+                jr_machine_render (machine, outputChannels, channelCounts[block % 3], 1 + random.nextInt (maxBlockSize));
+            }
+
+            jr_machine_destroy (machine);
+        }
+
+        expectEquals (jr::realtime::getNumViolations(), numViolationsBefore);
+    }
+   #endif
+};
+
+//======================= Registration =========================//
+
+static RealtimeCheckerTests realtimeCheckerTests;
@@ -0,0 +1,616 @@
+/*
+  ==============================================================================
+
+    jr_WaveguideNetworkTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <vector>                                   // used for std::vector
+#include "../Source/jr_WaveguideNetwork.h"          // used for jr::WaveguideNetwork
+#include "../Source/CircularWaveguide.h"            // used for CircularWaveguide
+#include "../Source/jr_Delay.h"                     // used for jr::DelayLine
+#include "../Source/jr_IIRFilter.h"                 // used for jr::IIRFilter
+#include "../Source/jr_Engine.h"                    // used for Engine
+
+namespace
+{
+    /** The circular waveguide as it was before its delays became a jr::WaveguideNetwork: four jr::DelayLine objects joined in a loop by hand.
+    Kept as the reference the network's four segment layout must match
+    */
+    template <typename SampleType>
+    class DelayLineWaveguide
+    {
+    public:
+
+        /** Returns the number of bytes of arena memory the delay lines need
+        * @param sr - sample rate, Hz
+        * @param driveStorage - sample format of the driving phasor delay line
+        */
+        static size_t getRequiredMemory (SampleType sr, jr::DelayStorage driveStorage)
+        {
+            SampleType sizeInSamples = 0.12f * sr;
+            return (4 * jr::DelayLine<SampleType>::getRequiredMemory ((int) sizeInSamples)) + jr::DelayLine<SampleType>::getRequiredMemory ((int) (sizeInSamples * 3.0f), driveStorage);
+        }
+
+        /** Sets the sample rate and takes the delay lines from the arena
+        * @param sr - sample rate, Hz
+        * @param driveStorage - sample format of the driving phasor delay line
+        * @param arena - arena with room for getRequiredMemory() bytes
+        */
+        void prepare (SampleType sr, jr::DelayStorage driveStorage, jr::MemoryArena& arena)
+        {
+            sampleRate = sr;
+
+            SampleType sizeInSamples = 0.12f * sampleRate;
+            delay1.prepare ((int) sizeInSamples, arena);
+            delay2.prepare ((int) sizeInSamples, arena);
+            delay3.prepare ((int) sizeInSamples, arena);
+            delay4.prepare ((int) sizeInSamples, arena);
+            delayedDrive.prepare ((int) (sizeInSamples * 3.0f), arena, driveStorage, 1.0f);
+
+            hpf1.setCoefficients (jr::IIRCoefficients<SampleType>::makeHighPass (sampleRate, 30.0, 0.01));
+        }
+
+        /** Sets the dimensions, feedback and params, as CircularWaveguide's setters do
+        */
+        void setParams (SampleType w1, SampleType w2, SampleType l1, SampleType l2, SampleType fb, SampleType parabDelay, SampleType parabMix, SampleType wDelay, SampleType warpAmt)
+        {
+            width1 = w1;
+            width2 = w2;
+            length1 = l1;
+            length2 = l2;
+            feedbackAmt = fb;
+            parabolicDelay = parabDelay;
+            parabolicMix = parabMix;
+            warpDelay = wDelay;
+            waveguideWarp = warpAmt;
+        }
+
+        /** Returns the next sample value for the waveguide, see CircularWaveguide::process()
+        */
+        SampleType process (SampleType speedIn, SampleType driveIn, SampleType b, SampleType c, SampleType d)
+        {
+            delayedDrive.pushSample (driveIn);
+
+            SampleType a = delayedDrive.popSample (((parabolicDelay / 1000.0f) * sampleRate));
+            a -= 0.5f;
+            a = 0.5f * ((-4.0f * pow (a, 2)) + 1.0f);
+            a *= (parabolicMix * 2.0f);
+
+            SampleType cosineCurve = cos (juce::MathConstants<SampleType>().twoPi * delayedDrive.popSample ((warpDelay / 1000.0f) * sampleRate));
+            SampleType warpAmount = speedIn * waveguideWarp;
+            SampleType fm1 = 0.5f + ((1.0f - cosineCurve) * warpAmount);
+            SampleType fm2 = 0.5f + (cosineCurve * warpAmount);
+
+            SampleType output{};
+
+            delay1.pushSample ((hpf1.processSingleSampleRaw (a) + (feedbackAmt * fbSignal2)));
+            SampleType delayOut = delay1.popSample ((sampleRate * ((width2 * fm2) / 1000.0f)));
+
+            SampleType outputSubMix = delayOut + b;
+            output += outputSubMix;
+            delay2.pushSample (outputSubMix);
+
+            fbSignal1 = delay2.popSample ((sampleRate * ((length1 * fm1) / 1000.0f)));
+            output += fbSignal1;
+            delay3.pushSample (fbSignal1 + c);
+
+            outputSubMix = delay3.popSample ((sampleRate * ((width1 * fm1) / 1000.0f))) + d;
+            output += outputSubMix;
+            delay4.pushSample (outputSubMix);
+
+            fbSignal2 = delay4.popSample ((sampleRate * ((length2 * fm2) / 1000.0f)));
+            output += fbSignal2;
+
+            return output;
+        }
+
+    private:
+        SampleType sampleRate{};                // sample rate, Hz
+        SampleType feedbackAmt{};               // feedback amount (0-1)
+        SampleType fbSignal1{};                 // output of delay 2
+        SampleType fbSignal2{};                 // output of delay 4, fed back into delay 1
+        SampleType width1{};                    // width 1, ms
+        SampleType width2{};                    // width 2, ms
+        SampleType length1{};                   // length 1, ms
+        SampleType length2{};                   // length 2, ms
+        SampleType parabolicDelay{};            // delay in ms for driver to signal 'a'
+        SampleType parabolicMix{};              // mix amount for signal 'a'
+        SampleType warpDelay{};                 // delay in ms for 'fm1' and 'fm2'
+        SampleType waveguideWarp{};             // amount of driving signal sent to 'fm1' and 'fm2'
+
+        jr::IIRFilter<SampleType> hpf1;         // high pass filter to filter signal 'a'
+        jr::DelayLine<SampleType> delay1;       // width 2
+        jr::DelayLine<SampleType> delay2;       // length 1
+        jr::DelayLine<SampleType> delay3;       // width 1
+        jr::DelayLine<SampleType> delay4;       // length 2
+        jr::DelayLine<SampleType> delayedDrive; // driving phasor
+    };
+
+    /** A network of any layout built from one jr::DelayLine per segment, summing in the order the network documents: each junction is the
+    output of the segment before plus the heard injections, and feeds the segment along with its unheard injections and feedback taps
+    */
+    template <typename SampleType>
+    class DelayLineNetwork
+    {
+    public:
+
+        /** Sets the layout and takes the delay lines from the arena
+        * @param numSegmentsIn - number of segments
+        * @param maxDelayInSamples - maximum delay of every segment, samples
+        * @param arena - arena with room for numSegmentsIn delay lines of maxDelayInSamples
+        */
+        void prepare (int numSegmentsIn, int maxDelayInSamples, jr::MemoryArena& arena)
+        {
+            numSegments = numSegmentsIn;
+
+            for (int segment = 0; segment < numSegments; segment++)
+                lines[segment].prepare (maxDelayInSamples, arena);
+        }
+
+        /** Returns the next sample value of the network
+        * @param input - current sample value fed into the first segment
+        * @param heardInputs - sum of the heard injections into each segment
+        * @param unheardInputs - sum of the injections into each segment that aren't heard
+        * @param feedbackInputs - sum of the feedback taps into each segment, from the outputs of the sample before
+        * @param delays - delay of each segment, samples (negative to keep the last)
+        */
+        SampleType process (SampleType input, const SampleType* heardInputs, const SampleType* unheardInputs, const SampleType* feedbackInputs, const SampleType* delays)
+        {
+            SampleType output{};
+
+            for (int segment = 0; segment < numSegments; segment++)
+            {
+                SampleType junction = (segment > 0 ? outputs[segment - 1] : 0) + heardInputs[segment];
+                output += junction;
+
+                lines[segment].pushSample ((segment == 0 ? input : 0) + junction + unheardInputs[segment] + feedbackInputs[segment]);
+                outputs[segment] = lines[segment].popSample (delays[segment]);
+            }
+
+            return output + outputs[numSegments - 1];
+        }
+
+        /** Returns the output of a segment for the last sample processed
+        * @param segment - index of segment
+        */
+        SampleType getOutput (int segment) const { return outputs[segment]; }
+
+    private:
+        static constexpr int maxSegments{ jr::WaveguideNetwork<SampleType>::maxSegments };
+
+        int numSegments{ 1 };                               // number of segments
+        jr::DelayLine<SampleType> lines[maxSegments];       // one delay line per segment
+        SampleType outputs[maxSegments]{};                  // output of each segment for the last sample processed
+    };
+}
+
+/** Checks jr::WaveguideNetwork against separate jr::DelayLine objects joined by hand: CircularWaveguide's four segment layout against the
+four delay line loop it replaced, and a larger layout with several injections and feedback taps against a delay line per segment.
+Then checks that processBlock() gives the same output as process() each sample, for the network, CircularWaveguide and Engine, over
+blocks of random length and delays that fall below a sample or are held by a negative modulation
+*/
+class WaveguideNetworkTests : public juce::UnitTest
+{
+public:
+    WaveguideNetworkTests() : juce::UnitTest ("Waveguide network", "MechanicalModelling") {}
+
+    void runTest() override
+    {
+        testCircularWaveguide<float>();
+        testCircularWaveguide<double>();
+        testLayout<float>();
+        testLayout<double>();
+        testNetworkBlocks<float>();
+        testNetworkBlocks<double>();
+        testCircularWaveguideBlocks<float>();
+        testCircularWaveguideBlocks<double>();
+        testEngineBlocks<float>();
+        testEngineBlocks<double>();
+    }
+
+private:
+
+    // the six segment layout: injections heard and unheard (one into the first segment) and feedback taps back to the start, from a segment to itself and forward
+    static constexpr int numSegments{ 6 };                                          // number of segments
+    static constexpr int numInjections{ 4 };                                        // number of injection points
+    static constexpr int numTaps{ 3 };                                              // number of feedback taps
+    static constexpr int injectionSegments[numInjections]{ 0, 2, 2, 5 };            // segment each injection point feeds
+    static constexpr bool injectionsHeard[numInjections]{ true, false, true, true }; // whether each injection point is heard
+    static constexpr int tapSources[numTaps]{ 5, 2, 1 };                            // segment each feedback tap reads from
+    static constexpr int tapDestinations[numTaps]{ 0, 2, 4 };                       // segment each feedback tap adds to
+    static constexpr float tapGains[numTaps]{ 0.5f, 0.3f, 0.2f };                   // gain of each feedback tap
+    static constexpr int layoutSampleRate{ 48000 };                                 // sample rate of the layout tests, Hz
+    static constexpr int layoutMaxDelay{ 2400 };                                    // maximum delay of every segment of the layout, samples
+    static constexpr int maxTestBlockSize{ 200 };                                   // longest block of the block tests, longer than the network splits blocks into
+
+    /** Returns the largest difference from a reference allowed, relative to its peak. The outputs are identical on builds that don't fuse
+    multiplies and adds, but fusing rounds the two sides' sums differently and the feedback carries the difference on
+    */
+    template <typename SampleType>
+    static double getMaxError() { return sizeof (SampleType) == sizeof (float) ? 1.0e-3 : 1.0e-9; }
+
+    /** Returns the name of a sample type for test names
+    */
+    template <typename SampleType>
+    static juce::String getTypeName() { return sizeof (SampleType) == sizeof (float) ? "float" : "double"; }
+
+    /** Runs CircularWaveguide and the four delay line loop side by side at two sample rates, with and without compact storage, through a
+    speed sweep whose warp takes the delays below a sample and negative
+    */
+    template <typename SampleType>
+    void testCircularWaveguide()
+    {
+        beginTest ("CircularWaveguide matches the four delay line loop (" + getTypeName<SampleType>() + ")");
+
+        for (double sampleRate : { 48000.0, 44100.0 })
+        {
+            for (bool isCompact : { false, true })
+            {
+                auto storage = isCompact ? jr::DelayStorage::FIXED16 : jr::DelayStorage::FULL_PRECISION;
+                auto sr = (SampleType) sampleRate;
+
+                CircularWaveguide<SampleType> waveguide;
+                waveguide.setCompactStorage (isCompact);
+                jr::MemoryArena arena;
+                arena.prepare (waveguide.getRequiredMemory (sr));
+                waveguide.prepare (sr, arena);
+                waveguide.setDimensions (12.0f, 7.0f, 20.0f, 15.0f);
+                waveguide.setFeedbackAmt (0.6f);
+                waveguide.setParams (8.0f, 0.7f, 3.0f, 0.72f);
+
+                DelayLineWaveguide<SampleType> reference;
+                jr::MemoryArena referenceArena;
+                referenceArena.prepare (DelayLineWaveguide<SampleType>::getRequiredMemory (sr, storage));
+                reference.prepare (sr, storage, referenceArena);
+                reference.setParams (12.0f, 7.0f, 20.0f, 15.0f, 0.6f, 8.0f, 0.7f, 3.0f, 0.72f);
+
+                juce::Random random (49);
+                SampleType phase{};
+                SampleType peak{};
+                double error{};
+
+                for (int i = 0; i < (int) sampleRate; i++)
+                {
+                    auto speed = (SampleType) i / (SampleType) sampleRate;
+                    phase += (SampleType) (0.002 + (0.02 * speed));
+                    phase -= phase >= 1 ? 1 : 0;
+
+                    auto b = (SampleType) (random.nextFloat() - 0.5f);
+                    auto c = (SampleType) (random.nextFloat() - 0.5f);
+                    auto d = (SampleType) (random.nextFloat() - 0.5f);
+
+                    SampleType expected = reference.process (speed, phase, b, c, d);
+                    SampleType actual = waveguide.process (speed, phase, b, c, d);
+
+                    peak = juce::jmax (peak, std::abs (expected));
+                    error = juce::jmax (error, (double) std::abs (actual - expected));
+                }
+
+                logMessage (juce::String ((int) sampleRate) + "Hz" + (isCompact ? " compact" : "") + ": largest difference " + juce::String (error) + ", peak " + juce::String (peak));
+                expect (peak > 0, "reference is silent");
+                expectLessOrEqual (error, getMaxError<SampleType>() * peak, juce::String ((int) sampleRate) + "Hz" + (isCompact ? " compact" : ""));
+            }
+        }
+    }
+
+    /** Sets a network up with the six segment layout and prepares it
+    * @param network - network to set up
+    * @param arena - arena to prepare and take the network's memory from
+    * @param segmentLengths - length of each segment, ms
+    */
+    template <typename SampleType>
+    static void prepareLayout (jr::WaveguideNetwork<SampleType>& network, jr::MemoryArena& arena, const SampleType* segmentLengths)
+    {
+        network.setLayout (numSegments, numInjections, numTaps);
+
+        for (int i = 0; i < numInjections; i++)
+            network.setInjectionPoint (i, injectionSegments[i], injectionsHeard[i]);
+
+        for (int tap = 0; tap < numTaps; tap++)
+        {
+            network.setFeedbackTap (tap, tapSources[tap], tapDestinations[tap]);
+            network.setFeedbackGain (tap, tapGains[tap]);
+        }
+
+        arena.prepare (network.getRequiredMemory (layoutMaxDelay));
+        network.prepare ((SampleType) layoutSampleRate, layoutMaxDelay, arena);
+
+        for (int segment = 0; segment < numSegments; segment++)
+            network.setSegmentLength (segment, segmentLengths[segment]);
+    }
+
+    /** Runs a six segment network with injections heard and unheard (one into the first segment) and three feedback taps (back to the start,
+    from a segment to itself and forward) against a delay line per segment, with random modulations that go below a sample and negative
+    */
+    template <typename SampleType>
+    void testLayout()
+    {
+        beginTest ("Six segment layout with three feedback taps matches a delay line per segment (" + getTypeName<SampleType>() + ")");
+
+        // the third segment is short enough for its delay to often fall below a sample
+        const SampleType segmentLengths[numSegments] = { 3.0f, 11.0f, 0.05f, 7.5f, 19.0f, 1.0f };
+
+        jr::WaveguideNetwork<SampleType> network;
+        jr::MemoryArena arena;
+        prepareLayout (network, arena, segmentLengths);
+
+        DelayLineNetwork<SampleType> reference;
+        jr::MemoryArena referenceArena;
+        referenceArena.prepare (numSegments * jr::DelayLine<SampleType>::getRequiredMemory (layoutMaxDelay));
+        reference.prepare (numSegments, layoutMaxDelay, referenceArena);
+
+        juce::Random random (490);
+        SampleType peak{};
+        double error{};
+
+        for (int i = 0; i < layoutSampleRate; i++)
+        {
+            SampleType input = (SampleType) (random.nextFloat() - 0.5f);
+            SampleType injections[numInjections];
+            SampleType modulations[numSegments];
+            SampleType heardInputs[numSegments]{};
+            SampleType unheardInputs[numSegments]{};
+            SampleType feedbackInputs[numSegments]{};
+            SampleType delays[numSegments];
+
+            for (int j = 0; j < numInjections; j++)
+            {
+                injections[j] = (SampleType) (random.nextFloat() - 0.5f);
+                (injectionsHeard[j] ? heardInputs : unheardInputs)[injectionSegments[j]] += injections[j];
+            }
+
+            for (int tap = 0; tap < numTaps; tap++)
+                feedbackInputs[tapDestinations[tap]] += (SampleType) tapGains[tap] * reference.getOutput (tapSources[tap]);
+
+            // about one modulation in eleven is negative, keeping the segment's last delay
+            for (int segment = 0; segment < numSegments; segment++)
+            {
+                modulations[segment] = (SampleType) ((random.nextFloat() * 2.2f) - 0.2f);
+                delays[segment] = (SampleType) layoutSampleRate * ((segmentLengths[segment] * modulations[segment]) / 1000.0f);
+            }
+
+            SampleType expected = reference.process (input, heardInputs, unheardInputs, feedbackInputs, delays);
+            SampleType actual = network.process (input, injections, modulations);
+
+            peak = juce::jmax (peak, std::abs (expected));
+            error = juce::jmax (error, (double) std::abs (actual - expected));
+        }
+
+        logMessage ("largest difference " + juce::String (error) + ", peak " + juce::String (peak));
+        expect (peak > 0, "reference is silent");
+        expectLessOrEqual (error, getMaxError<SampleType>() * peak);
+    }
+
+    /** Expects the output of processBlock() to be the same as that of process() each sample
+    * @param perSample - output of process()
+    * @param blocked - output of processBlock()
+    */
+    template <typename SampleType>
+    void expectSameOutput (const std::vector<SampleType>& perSample, const std::vector<SampleType>& blocked)
+    {
+        SampleType peak{};
+        int numDifferent{};
+        int firstDifferent{ -1 };
+
+        for (size_t i = 0; i < perSample.size(); i++)
+        {
+            peak = juce::jmax (peak, std::abs (perSample[i]));
+
+            if (blocked[i] != perSample[i])
+            {
+                numDifferent++;
+                firstDifferent = firstDifferent < 0 ? (int) i : firstDifferent;
+            }
+        }
+
+        logMessage (juce::String (numDifferent) + " samples differ, first at " + juce::String (firstDifferent) + ", peak " + juce::String (peak));
+        expect (peak > 0, "output is silent");
+        expectEquals (numDifferent, 0);
+    }
+
+    /** Runs two six segment networks side by side, one through process() each sample and the other through processBlock() in blocks of
+    random length. The modulations move smoothly, with stretches where the delay of one segment is below a sample (so the network falls back
+    to one sample at a time) and stretches of negative modulations that keep the last delay
+    */
+    template <typename SampleType>
+    void testNetworkBlocks()
+    {
+        beginTest ("Network processBlock() matches process() (" + getTypeName<SampleType>() + ")");
+
+        // long enough for runs of a whole chunk, until the third segment's modulation is dropped below a sample
+        const SampleType segmentLengths[numSegments] = { 3.0f, 11.0f, 5.0f, 7.5f, 19.0f, 1.5f };
+        const int numSamples = layoutSampleRate;
+        const int stretchLength = layoutSampleRate / 10;
+
+        juce::Random random (50);
+        std::vector<SampleType> input ((size_t) numSamples);
+        std::vector<std::vector<SampleType>> injections (numInjections, std::vector<SampleType> ((size_t) numSamples));
+        std::vector<std::vector<SampleType>> modulations (numSegments, std::vector<SampleType> ((size_t) numSamples));
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            input[(size_t) i] = (SampleType) (random.nextFloat() - 0.5f);
+
+            for (auto& injection : injections)
+                injection[(size_t) i] = (SampleType) (random.nextFloat() - 0.5f);
+
+            int stretch = (i / stretchLength) % 3;
+
+            for (int segment = 0; segment < numSegments; segment++)
+            {
+                auto phase = juce::MathConstants<double>::twoPi * i / (layoutSampleRate * (0.3 + (0.1 * segment)));
+                auto modulation = 0.7 + (0.5 * std::sin (phase));
+
+                // 5ms is 240 samples, so these keep the third segment between 0.24 and 0.96 samples
+                if (stretch == 1 && segment == 2)
+                    modulation = 0.0025 + (0.0015 * std::sin (phase));
+
+                if (stretch == 2 && random.nextInt (4) == 0)
+                    modulation = -0.5;
+
+                modulations[(size_t) segment][(size_t) i] = (SampleType) modulation;
+            }
+        }
+
+        jr::WaveguideNetwork<SampleType> perSampleNetwork;
+        jr::MemoryArena perSampleArena;
+        prepareLayout (perSampleNetwork, perSampleArena, segmentLengths);
+
+        jr::WaveguideNetwork<SampleType> blockNetwork;
+        jr::MemoryArena blockArena;
+        prepareLayout (blockNetwork, blockArena, segmentLengths);
+
+        std::vector<SampleType> perSample ((size_t) numSamples);
+        std::vector<SampleType> blocked ((size_t) numSamples);
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            SampleType sampleInjections[numInjections];
+            SampleType sampleModulations[numSegments];
+
+            for (int j = 0; j < numInjections; j++)
+                sampleInjections[j] = injections[(size_t) j][(size_t) i];
+
+            for (int segment = 0; segment < numSegments; segment++)
+                sampleModulations[segment] = modulations[(size_t) segment][(size_t) i];
+
+            perSample[(size_t) i] = perSampleNetwork.process (input[(size_t) i], sampleInjections, sampleModulations);
+        }
+
+        for (int blockStart = 0; blockStart < numSamples;)
+        {
+            int numInBlock = juce::jmin (1 + random.nextInt (maxTestBlockSize), numSamples - blockStart);
+            const SampleType* blockInjections[numInjections];
+            const SampleType* blockModulations[numSegments];
+
+            for (int j = 0; j < numInjections; j++)
+                blockInjections[j] = injections[(size_t) j].data() + blockStart;
+
+            for (int segment = 0; segment < numSegments; segment++)
+                blockModulations[segment] = modulations[(size_t) segment].data() + blockStart;
+
+            blockNetwork.processBlock (blocked.data() + blockStart, input.data() + blockStart, blockInjections, blockModulations, numInBlock);
+            blockStart += numInBlock;
+        }
+
+        expectSameOutput (perSample, blocked);
+    }
+
+    /** Runs two CircularWaveguides side by side, one through process() each sample and the other through processBlock() in blocks of random
+    length, through a speed sweep whose warp takes 'fm2' through zero, so the delays fall below a sample and go negative
+    */
+    template <typename SampleType>
+    void testCircularWaveguideBlocks()
+    {
+        beginTest ("CircularWaveguide processBlock() matches process() (" + getTypeName<SampleType>() + ")");
+
+        const int numSamples = 48000;
+        const auto sampleRate = (SampleType) numSamples;
+
+        CircularWaveguide<SampleType> waveguides[2];
+        jr::MemoryArena arenas[2];
+
+        for (int i = 0; i < 2; i++)
+        {
+            arenas[i].prepare (waveguides[i].getRequiredMemory (sampleRate));
+            waveguides[i].prepare (sampleRate, arenas[i]);
+            waveguides[i].setDimensions (12.0f, 7.0f, 20.0f, 15.0f);
+            waveguides[i].setFeedbackAmt (0.6f);
+            waveguides[i].setParams (8.0f, 0.7f, 3.0f, 0.72f);
+        }
+
+        juce::Random random (500);
+        std::vector<SampleType> speeds ((size_t) numSamples), drives ((size_t) numSamples), b ((size_t) numSamples), c ((size_t) numSamples), d ((size_t) numSamples);
+        SampleType phase{};
+
+        for (size_t i = 0; i < (size_t) numSamples; i++)
+        {
+            speeds[i] = (SampleType) i / sampleRate;
+            phase += (SampleType) (0.002 + (0.02 * speeds[i]));
+            phase -= phase >= 1 ? 1 : 0;
+            drives[i] = phase;
+            b[i] = (SampleType) (random.nextFloat() - 0.5f);
+            c[i] = (SampleType) (random.nextFloat() - 0.5f);
+            d[i] = (SampleType) (random.nextFloat() - 0.5f);
+        }
+
+        std::vector<SampleType> perSample ((size_t) numSamples);
+        std::vector<SampleType> blocked ((size_t) numSamples);
+
+        for (size_t i = 0; i < (size_t) numSamples; i++)
+            perSample[i] = waveguides[0].process (speeds[i], drives[i], b[i], c[i], d[i]);
+
+        for (int blockStart = 0; blockStart < numSamples;)
+        {
+            int numInBlock = juce::jmin (1 + random.nextInt (maxTestBlockSize), numSamples - blockStart);
+            waveguides[1].processBlock (blocked.data() + blockStart, speeds.data() + blockStart, drives.data() + blockStart,
+                                        b.data() + blockStart, c.data() + blockStart, d.data() + blockStart, numInBlock);
+            blockStart += numInBlock;
+        }
+
+        expectSameOutput (perSample, blocked);
+    }
+
+    /** Runs two Engines with the same seed side by side, one through setSpeed() and process() each sample and the other through processBlock()
+    in blocks of random length, through a speed sweep at full aggression, excited by the overtones and then by an external signal
+    */
+    template <typename SampleType>
+    void testEngineBlocks()
+    {
+        beginTest ("Engine processBlock() matches process() (" + getTypeName<SampleType>() + ")");
+
+        const int numSamples = 48000;
+        const auto sampleRate = (SampleType) numSamples;
+
+        for (bool isExternal : { false, true })
+        {
+            Engine<SampleType> engines[2];
+            jr::MemoryArena arenas[2];
+
+            for (int i = 0; i < 2; i++)
+            {
+                arenas[i].prepare (engines[i].getRequiredMemory (sampleRate));
+                engines[i].prepare (sampleRate, arenas[i]);
+                engines[i].setRandomSeed (50);
+                engines[i].setMappedParams (0.8f, 1.0f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f);
+                engines[i].setExternalExcitation (isExternal);
+            }
+
+            juce::Random random (5000);
+            std::vector<SampleType> speeds ((size_t) numSamples), excitations ((size_t) numSamples);
+
+            for (size_t i = 0; i < (size_t) numSamples; i++)
+            {
+                speeds[i] = (SampleType) i / sampleRate;
+                excitations[i] = (SampleType) (random.nextFloat() - 0.5f);
+            }
+
+            std::vector<SampleType> perSample ((size_t) numSamples);
+            std::vector<SampleType> blocked ((size_t) numSamples);
+
+            for (size_t i = 0; i < (size_t) numSamples; i++)
+            {
+                engines[0].setSpeed (speeds[i]);
+                engines[0].setExcitation (excitations[i]);
+                perSample[i] = engines[0].process();
+            }
+
+            for (int blockStart = 0; blockStart < numSamples;)
+            {
+                int numInBlock = juce::jmin (1 + random.nextInt (maxTestBlockSize), numSamples - blockStart);
+                engines[1].processBlock (blocked.data() + blockStart, speeds.data() + blockStart, excitations.data() + blockStart, numInBlock);
+                blockStart += numInBlock;
+            }
+
+            logMessage (isExternal ? "external excitation:" : "overtones:");
+            expectSameOutput (perSample, blocked);
+        }
+    }
+};
+
+//======================= Registration =========================//
+
+static WaveguideNetworkTests waveguideNetworkTests;